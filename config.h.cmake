@@ -7,6 +7,12 @@
 /* Defined if MQTT handling is enabled. */
 #cmakedefine HAVE_MQTT
 
+/* Defined if zlib is available for gzip compressed HTTP content. */
+#cmakedefine HAVE_ZLIB
+
+/* Defined if epoll is available. */
+#cmakedefine HAVE_EPOLL
+
 /* Defined if ppoll() is available. */
 #cmakedefine HAVE_PPOLL
 
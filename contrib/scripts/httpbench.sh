@@ -0,0 +1,41 @@
+#!/bin/sh
+# Measure the HTTP requests per second of a running ebusd.
+# For realistic numbers, let ebusd decode a replayed bus, e.g. with ebusfeed (see "ebusfeed --help"):
+#   ebusd -f -d /dev/ttyUSB20 --nodevicecheck --httpport=8080 & ebusfeed /path/to/ebus_dump.bin
+# Usage: httpbench.sh [-p PORT] [-n COUNT] [-c CLIENTS] [-K] [URI]
+#   -p PORT     the HTTP port of ebusd [8080]
+#   -n COUNT    the number of requests per client [1000]
+#   -c CLIENTS  the number of parallel clients [1]
+#   -K          open a new connection for each request instead of keeping it alive
+#   URI         the URI to request [/data]
+port=8080
+count=1000
+clients=1
+close=
+while [ -n "$1" ]; do
+  case "$1" in
+    -p) shift; port=$1 ;;
+    -n) shift; count=$1 ;;
+    -c) shift; clients=$1 ;;
+    -K) close=1 ;;
+    *) break ;;
+  esac
+  shift
+done
+uri=${1:-/data}
+url="http://127.0.0.1:$port$uri"
+if [ -n "$close" ]; then
+  header="Connection: close"
+else
+  header="Connection: keep-alive"
+fi
+urls=`yes "$url -o /dev/null" | head -n $count`
+start=`date +%s.%N`
+i=0
+while [ $i -lt $clients ]; do
+  curl -s -H "$header" -w '%{http_code}\n' $urls | awk '$1!=200{f++}END{if(f)print f " requests failed"}' &
+  i=$((i+1))
+done
+wait
+end=`date +%s.%N`
+echo "$start $end $count $clients" | awk '{d=$2-$1; n=$3*$4; printf "%d requests in %.3f s: %.1f requests/s\n", n, d, n/d}'
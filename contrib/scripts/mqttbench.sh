@@ -0,0 +1,33 @@
+#!/bin/sh
+# Measure the MQTT get requests per second handled by a running ebusd.
+# Requests a passive message (answered without bus traffic) and waits for all answers to be published, e.g. with
+# ebusd decoding a replayed bus (see "ebusfeed --help") and without "--mqttcoalesce", "--mqttmaxrate",
+# "--mqttchanges", and "--mqttdedup" so that every request gets answered:
+#   ebusd -f -d /dev/ttyUSB20 --nodevicecheck --mqttport=1883 & ebusfeed /path/to/ebus_dump.bin
+# Usage: mqttbench.sh [-h HOST] [-p PORT] [-n COUNT] [TOPIC]
+#   -h HOST     the MQTT broker host [localhost]
+#   -p PORT     the MQTT broker port [1883]
+#   -n COUNT    the number of requests [10000]
+#   TOPIC       the topic of the message (without "/get") [ebusd/broadcast/datetime]
+host=localhost
+port=1883
+count=10000
+while [ -n "$1" ]; do
+  case "$1" in
+    -h) shift; host=$1 ;;
+    -p) shift; port=$1 ;;
+    -n) shift; count=$1 ;;
+    *) break ;;
+  esac
+  shift
+done
+topic=${1:-ebusd/broadcast/datetime}
+mosquitto_sub -h "$host" -p "$port" -R -C "$count" -W 60 -t "$topic" >/dev/null &
+sub=$!
+sleep 1
+start=`date +%s.%N`
+# a single "?" is the same as an empty get request, which mosquitto_pub would skip
+yes '?' | head -n $count | mosquitto_pub -h "$host" -p "$port" -l -t "$topic/get"
+wait $sub || echo "not all requests answered"
+end=`date +%s.%N`
+echo "$start $end $count" | awk '{d=$2-$1; printf "%d requests in %.3f s: %.1f requests/s\n", $3, d, $3/d}'
@@ -376,6 +376,55 @@ result_t BusHandler::readFromBus(Message* message, const string& inputStr, symbo
   return ret;
 }
 
+bool BusDecoder::add(const MasterSymbolString& master, const SlaveSymbolString& slave, bool sent) {
+  flush();
+  m_pending.m_master = master;
+  m_pending.m_slave = slave;
+  m_pending.m_sent = sent;
+  if (m_overflow.empty() && m_completed.push(m_pending)) {
+    notify();
+    return true;
+  }
+  m_overflow.emplace_back();
+  CompletedMessage& deferred = m_overflow.back();
+  deferred.m_master = master;
+  deferred.m_slave = slave;
+  deferred.m_sent = sent;
+  if (++m_deferred == 1 || m_deferred % 100 == 0) {  // avoid flooding the log
+    logNotice(lf_bus, "decoder queue full, deferred %s / %s (%u in total)", master.getStr().c_str(),
+        slave.getStr().c_str(), m_deferred);
+  }
+  notify();
+  return false;
+}
+
+void BusDecoder::flush() {
+  if (m_overflow.empty()) {
+    return;
+  }
+  while (!m_overflow.empty() && m_completed.push(m_overflow.front())) {
+    m_overflow.pop_front();
+  }
+  notify();
+}
+
+void BusDecoder::run() {
+  while (isRunning()) {
+    CompletedMessage* completed;
+    while ((completed = m_completed.front()) != nullptr) {
+      m_busHandler->handleCompleted(completed->m_master, completed->m_slave, completed->m_sent);
+      m_completed.pop();
+    }
+    waitNotified(1000);
+  }
+}
+
+
+bool BusHandler::start(const char* name) {
+  m_decoderStarted = m_decoder.start("busdecoder");
+  return WaitThread::start(name);
+}
+
 void BusHandler::run() {
   unsigned int symCount = 0;
   time_t now, lastTime;
@@ -385,6 +434,9 @@ void BusHandler::run() {
       m_answer?" in answer mode":"");
 
   do {
+    if (m_decoderStarted) {
+      m_decoder.flush();  // pass on the messages deferred while the decoder did not keep up
+    }
     if (m_device->isValid() && !m_reconnect) {
       result_t result = handleSymbol();
       time(&now);
@@ -448,10 +500,13 @@ result_t BusHandler::handleSymbol() {
         time_t now;
         time(&now);
         if (m_lastPoll == 0 || difftime(now, m_lastPoll) > m_pollInterval) {
+          uint64_t hold = m_messages->holdDefinitions();
           Message* message = m_messages->getNextPoll();
-          if (message != nullptr) {
+          if (message == nullptr) {
+            m_messages->releaseDefinitions(hold);
+          } else {
             m_lastPoll = now;
-            auto request = new PollRequest(message);
+            auto request = new PollRequest(m_messages, hold, message);
             result_t ret = request->prepare(m_ownMasterAddress);
             if (ret != RESULT_OK) {
               logError(lf_bus, "prepare poll message: %s", getResultCode(ret));
@@ -939,6 +994,7 @@ result_t BusHandler::handleSymbol() {
     m_nextSendPos = 0;
     m_repeat = false;
     {
+      uint64_t hold = m_messages->holdDefinitions();
       Message* message;
       message = m_messages->find(m_command);
       if (message == nullptr) {
@@ -949,6 +1005,7 @@ result_t BusHandler::handleSymbol() {
       }
       if (message == nullptr || message->isWrite()) {
         // don't know this request or definition has wrong direction, deny
+        m_messages->releaseDefinitions(hold);
         return setState(bs_skip, RESULT_ERR_INVALID_ARG);
       }
       istringstream input;  // TODO create input from database of internal variables
@@ -958,6 +1015,7 @@ result_t BusHandler::handleSymbol() {
       // build response and store in m_response for sending back to requesting master
       m_response.clear();
       result = message->prepareSlave(&input, &m_response);
+      m_messages->releaseDefinitions(hold);
       if (result != RESULT_OK) {
         return setState(bs_skip, result);
       }
@@ -1121,7 +1179,7 @@ bool BusHandler::addSeenAddress(symbol_t address) {
 }
 
 void BusHandler::messageCompleted() {
-  const char* prefix = m_currentRequest ? "sent" : "received";
+  bool sent = m_currentRequest != nullptr;
   if (m_currentRequest) {
     m_command = m_currentRequest->m_master;
   }
@@ -1134,9 +1192,8 @@ void BusHandler::messageCompleted() {
     addSeenAddress(dstAddress);
   }
 
-  bool master = isMaster(dstAddress);
+  uint64_t hold = m_messages->holdDefinitions();
   if (dstAddress == BROADCAST) {
-    logInfo(lf_update, "%s BC cmd: %s", prefix, m_command.getStr().c_str());
     if (m_command.getDataSize() >= 10 && m_command[2] == 0x07 && m_command[3] == 0x04) {
       symbol_t slaveAddress = getSlaveAddress(srcAddress);
       addSeenAddress(slaveAddress);
@@ -1166,10 +1223,7 @@ void BusHandler::messageCompleted() {
         logNotice(lf_update, "store broadcast ident: %s", getResultCode(result));
       }
     }
-  } else if (master) {
-    logInfo(lf_update, "%s MM cmd: %s", prefix, m_command.getStr().c_str());
-  } else {
-    logInfo(lf_update, "%s MS cmd: %s / %s", prefix, m_command.getStr().c_str(), m_response.getStr().c_str());
+  } else if (!isMaster(dstAddress)) {
     if (m_command.size() >= 5 && m_command[2] == 0x07 && m_command[3] == 0x04) {
       Message* message = m_messages->getScanMessage(dstAddress);
       if (message && (message->getLastUpdateTime() == 0 || message->getLastSlaveData().getDataSize() < 10)) {
@@ -1186,24 +1240,44 @@ void BusHandler::messageCompleted() {
       }
     }
   }
-  Message* message = m_messages->find(m_command);
+  m_messages->releaseDefinitions(hold);
+  if (m_decoderStarted) {
+    m_decoder.add(m_command, m_response, sent);
+  } else {
+    handleCompleted(m_command, m_response, sent);
+  }
+}
+
+void BusHandler::handleCompleted(const MasterSymbolString& command, const SlaveSymbolString& response, bool sent) {
+  const char* prefix = sent ? "sent" : "received";
+  symbol_t srcAddress = command[0], dstAddress = command[1];
+  bool master = isMaster(dstAddress);
+  if (dstAddress == BROADCAST) {
+    logInfo(lf_update, "%s BC cmd: %s", prefix, command.getStr().c_str());
+  } else if (master) {
+    logInfo(lf_update, "%s MM cmd: %s", prefix, command.getStr().c_str());
+  } else {
+    logInfo(lf_update, "%s MS cmd: %s / %s", prefix, command.getStr().c_str(), response.getStr().c_str());
+  }
+  uint64_t hold = m_messages->holdDefinitions();
+  Message* message = m_messages->find(command);
   if (m_grabMessages) {
     uint64_t key;
     if (message) {
       key = message->getKey();
     } else {
-      key = Message::createKey(m_command, m_command[1] == BROADCAST ? 1 : 4);  // up to 4 DD bytes (1 for broadcast)
+      key = Message::createKey(command, command[1] == BROADCAST ? 1 : 4);  // up to 4 DD bytes (1 for broadcast)
     }
-    m_grabbedMessages[key].setLastData(m_command, m_response);
+    m_grabbedMessages[key].setLastData(command, response);
   }
   if (message == nullptr) {
     if (dstAddress == BROADCAST) {
-      logNotice(lf_update, "%s unknown BC cmd: %s", prefix, m_command.getStr().c_str());
+      logNotice(lf_update, "%s unknown BC cmd: %s", prefix, command.getStr().c_str());
     } else if (master) {
-      logNotice(lf_update, "%s unknown MM cmd: %s", prefix, m_command.getStr().c_str());
+      logNotice(lf_update, "%s unknown MM cmd: %s", prefix, command.getStr().c_str());
     } else {
-      logNotice(lf_update, "%s unknown MS cmd: %s / %s", prefix, m_command.getStr().c_str(),
-        m_response.getStr().c_str());
+      logNotice(lf_update, "%s unknown MS cmd: %s / %s", prefix, command.getStr().c_str(),
+        response.getStr().c_str());
     }
   } else {
     m_messages->invalidateCache(message);
@@ -1213,14 +1287,14 @@ void BusHandler::messageCompleted() {
       : message->isPassive() ? message->isWrite() ? "update-write" : "update-read"
       : message->getPollPriority() > 0 ? message->isWrite() ? "poll-write" : "poll-read"
       : message->isWrite() ? "write" : "read";
-    result_t result = message->storeLastData(m_command, m_response);
+    result_t result = message->storeLastData(command, response);
     ostringstream output;
-    if (result == RESULT_OK) {
+    if (result == RESULT_OK && needsLog(lf_update, ll_notice)) {  // decoded data is only needed for logging
       result = message->decodeLastData(false, nullptr, -1, 0, &output);
     }
     if (result < RESULT_OK) {
       logError(lf_update, "unable to parse %s %s %s from %s / %s: %s", mode, circuit.c_str(), name.c_str(),
-          m_command.getStr().c_str(), m_response.getStr().c_str(), getResultCode(result));
+          command.getStr().c_str(), response.getStr().c_str(), getResultCode(result));
     } else {
       string data = output.str();
       if (m_answer && dstAddress == (master ? m_ownMasterAddress : m_ownSlaveAddress)) {
@@ -1242,15 +1316,19 @@ void BusHandler::messageCompleted() {
       }
     }
   }
+  m_messages->releaseDefinitions(hold);
 }
 
 result_t BusHandler::prepareScan(symbol_t slave, bool full, const string& levels, bool* reload,
     ScanRequest** request) {
+  uint64_t hold = m_messages->holdDefinitions();  // released by the ScanRequest
   Message* scanMessage = m_messages->getScanMessage();
   if (scanMessage == nullptr) {
+    m_messages->releaseDefinitions(hold);
     return RESULT_ERR_NOTFOUND;
   }
   if (m_device->isReadOnly()) {
+    m_messages->releaseDefinitions(hold);
     return RESULT_OK;
   }
   deque<Message*> messages;
@@ -1293,9 +1371,10 @@ result_t BusHandler::prepareScan(symbol_t slave, bool full, const string& levels
     messages.push_front(scanMessage);
   }
   if (messages.empty()) {
+    m_messages->releaseDefinitions(hold);
     return RESULT_OK;
   }
-  *request = new ScanRequest(slave == SYN, m_messages, messages, slaves, this, *reload ? 0 : 1);
+  *request = new ScanRequest(slave == SYN, m_messages, hold, messages, slaves, this, *reload ? 0 : 1);
   result_t result = (*request)->prepare(m_ownMasterAddress);
   if (result < RESULT_OK) {
     delete *request;
@@ -151,15 +151,20 @@ class PollRequest : public BusRequest {
  public:
   /**
    * Constructor.
+   * @param messageMap the @a MessageMap instance.
+   * @param hold the hold on the definitions taken before looking up the @a Message (see
+   * @a MessageMap::holdDefinitions()), released on destruction.
    * @param message the associated @a Message.
    */
-  explicit PollRequest(Message* message)
-    : BusRequest(m_master, true), m_message(message), m_index(0) {}
+  PollRequest(MessageMap* messageMap, uint64_t hold, Message* message)
+    : BusRequest(m_master, true), m_messageMap(messageMap), m_hold(hold), m_message(message), m_index(0) {}
 
   /**
    * Destructor.
    */
-  virtual ~PollRequest() {}
+  virtual ~PollRequest() {
+    m_messageMap->releaseDefinitions(m_hold);
+  }
 
   /**
    * Prepare the master data.
@@ -173,6 +178,12 @@ class PollRequest : public BusRequest {
 
 
  private:
+  /** the @a MessageMap instance. */
+  MessageMap* m_messageMap;
+
+  /** the hold on the definitions of @a m_messageMap. */
+  const uint64_t m_hold;
+
   /** the master data @a MasterSymbolString. */
   MasterSymbolString m_master;
 
@@ -195,16 +206,18 @@ class ScanRequest : public BusRequest {
    * Constructor.
    * @param deleteOnFinish whether to automatically delete this @a ScanRequest when finished.
    * @param messageMap the @a MessageMap instance.
+   * @param hold the hold on the definitions taken before looking up the @a Message instances (see
+   * @a MessageMap::holdDefinitions()), released on destruction.
    * @param messages the @a Message instances to query starting with the primary one.
    * @param slaves the slave addresses to scan.
    * @param busHandler the @a BusHandler instance to notify of final scan result.
    * @param notifyIndex the offset to the index for notifying the scan result.
    */
-  ScanRequest(bool deleteOnFinish, MessageMap* messageMap, const deque<Message*>& messages,
+  ScanRequest(bool deleteOnFinish, MessageMap* messageMap, uint64_t hold, const deque<Message*>& messages,
       const deque<symbol_t>& slaves, BusHandler* busHandler, size_t notifyIndex = 0)
-    : BusRequest(m_master, deleteOnFinish), m_messageMap(messageMap), m_index(0), m_allMessages(messages),
-      m_messages(messages), m_slaves(slaves), m_busHandler(busHandler), m_notifyIndex(notifyIndex),
-      m_result(RESULT_ERR_NO_SIGNAL) {
+    : BusRequest(m_master, deleteOnFinish), m_messageMap(messageMap), m_hold(hold), m_index(0),
+      m_allMessages(messages), m_messages(messages), m_slaves(slaves), m_busHandler(busHandler),
+      m_notifyIndex(notifyIndex), m_result(RESULT_ERR_NO_SIGNAL) {
     m_message = m_messages.front();
     m_messages.pop_front();
   }
@@ -212,7 +225,9 @@ class ScanRequest : public BusRequest {
   /**
    * Destructor.
    */
-  virtual ~ScanRequest() {}
+  virtual ~ScanRequest() {
+    m_messageMap->releaseDefinitions(m_hold);
+  }
 
   /**
    * Prepare the next master data.
@@ -229,6 +244,9 @@ class ScanRequest : public BusRequest {
   /** the @a MessageMap instance. */
   MessageMap* m_messageMap;
 
+  /** the hold on the definitions of @a m_messageMap. */
+  const uint64_t m_hold;
+
   /** the master data @a MasterSymbolString. */
   MasterSymbolString m_master;
 
@@ -358,10 +376,80 @@ class GrabbedMessage {
 };
 
 
+/**
+ * Helper class for a message completed on the bus that is waiting to be handled.
+ */
+class CompletedMessage {
+ public:
+  /** the @a MasterSymbolString. */
+  MasterSymbolString m_master;
+
+  /** the @a SlaveSymbolString. */
+  SlaveSymbolString m_slave;
+
+  /** whether the message was sent by us. */
+  bool m_sent;
+};
+
+
+/**
+ * Thread for handling messages completed on the bus (i.e. storing, decoding, and logging) outside of the
+ * time critical @a BusHandler thread.
+ */
+class BusDecoder : public NotifiableThread {
+ public:
+  /**
+   * Construct a new instance.
+   * @param busHandler the @a BusHandler instance.
+   */
+  explicit BusDecoder(BusHandler* busHandler) : NotifiableThread(), m_busHandler(busHandler), m_deferred(0) {}
+
+  /**
+   * Add a completed message to be handled (called from the @a BusHandler thread only).
+   * When the queue is full, the message is kept in an overflow list and passed on by a later @a add() or
+   * @a flush(), so that no message gets lost.
+   * @param master the @a MasterSymbolString.
+   * @param slave the @a SlaveSymbolString.
+   * @param sent whether the message was sent by us.
+   * @return true when the message was queued directly, false if it was kept in the overflow list.
+   */
+  bool add(const MasterSymbolString& master, const SlaveSymbolString& slave, bool sent);
+
+  /**
+   * Pass the messages kept in the overflow list on to the queue as far as possible (called from the
+   * @a BusHandler thread only).
+   */
+  void flush();
+
+
+ protected:
+  // @copydoc
+  void run() override;
+
+
+ private:
+  /** the @a BusHandler instance. */
+  BusHandler* m_busHandler;
+
+  /** the pending item used for filling the queue. */
+  CompletedMessage m_pending;
+
+  /** the messages not fitting into the queue in order (only accessed by the @a BusHandler thread). */
+  deque<CompletedMessage> m_overflow;
+
+  /** the number of messages kept in the overflow list because the queue was full. */
+  unsigned int m_deferred;
+
+  /** the queue of completed messages. */
+  RingQueue<CompletedMessage, 32> m_completed;
+};
+
+
 /**
  * Handles input from and output to the bus with respect to the eBUS protocol.
  */
 class BusHandler : public WaitThread {
+  friend class BusDecoder;
  public:
   /**
    * Construct a new instance.
@@ -396,7 +484,7 @@ class BusHandler : public WaitThread {
       m_currentRequest(nullptr), m_currentAnswering(false), m_runningScans(0), m_nextSendPos(0),
       m_symPerSec(0), m_maxSymPerSec(0),
       m_state(bs_noSignal), m_escape(0), m_crc(0), m_crcValid(false), m_repeat(false),
-      m_grabMessages(true) {
+      m_grabMessages(true), m_decoder(this), m_decoderStarted(false) {
     memset(m_seenAddresses, 0, sizeof(m_seenAddresses));
     m_lastSynReceiveTime.tv_sec = 0;
     m_lastSynReceiveTime.tv_nsec = 0;
@@ -408,6 +496,7 @@ class BusHandler : public WaitThread {
   virtual ~BusHandler() {
     stop();
     join();
+    m_decoder.join();
     BusRequest* req;
     while ((req = m_finishedRequests.pop()) != nullptr) {
       delete req;
@@ -429,7 +518,8 @@ class BusHandler : public WaitThread {
   void clear();
 
   /**
-   * Inject a message from outside and treat it as regularly retrieved from the bus.
+   * Inject a message from outside and treat it as regularly retrieved from the bus (only before the
+   * @a BusHandler was started).
    * @param master the @a MasterSymbolString with the master data.
    * @param slave the @a SlaveSymbolString with the slave data.
    */
@@ -460,6 +550,9 @@ class BusHandler : public WaitThread {
   result_t readFromBus(Message* message, const string& inputStr, symbol_t dstAddress = SYN,
       symbol_t srcAddress = SYN);
 
+  // @copydoc
+  bool start(const char* name) override;
+
   /**
    * Main thread entry.
    */
@@ -650,6 +743,14 @@ class BusHandler : public WaitThread {
    */
   void messageCompleted();
 
+  /**
+   * Store, decode, and log a completed message.
+   * @param master the @a MasterSymbolString.
+   * @param slave the @a SlaveSymbolString.
+   * @param sent whether the message was sent by us.
+   */
+  void handleCompleted(const MasterSymbolString& master, const SlaveSymbolString& slave, bool sent);
+
   /**
    * Prepare a @a ScanRequest.
    * @param slave the single slave address to scan, or @a SYN for multiple.
@@ -796,6 +897,12 @@ class BusHandler : public WaitThread {
 
   /** the grabbed messages by key.*/
   map<uint64_t, GrabbedMessage> m_grabbedMessages;
+
+  /** the @a BusDecoder for handling completed messages. */
+  BusDecoder m_decoder;
+
+  /** whether the @a BusDecoder was started (otherwise completed messages are handled directly). */
+  bool m_decoderStarted;
 };
 
 }  // namespace ebusd
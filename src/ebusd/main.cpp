@@ -24,9 +24,13 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <argp.h>
+#include <unistd.h>
 #include <csignal>
+#include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <deque>
+#include <functional>
 #include <iomanip>
 #include <map>
 #include <vector>
@@ -49,6 +53,7 @@ using std::setfill;
 using std::setw;
 using std::nouppercase;
 using std::cout;
+using std::ofstream;
 
 /** the path and name of the PID file. */
 #ifdef PACKAGE_PIDFILE
@@ -87,6 +92,8 @@ static struct options opt = {
   getenv("LANG"),  // preferLanguage
   false,  // checkConfig
   false,  // dumpConfig
+  "",  // configCache
+  "",  // httpCache
   5,  // pollInterval
   false,  // injectMessages
 
@@ -141,6 +148,30 @@ static string s_configUriPrefix;
 /** the @a HttpClient for retrieving configuration files from HTTP. */
 static HttpClient s_configHttpClient;
 
+/** the host name of the HTTP configuration server. */
+static string s_configHost;
+
+/** the port of the HTTP configuration server. */
+static uint16_t s_configPort = 80;
+
+/** the path of the local cache for configuration files retrieved from HTTP (with trailing "/"), or empty. */
+static string s_httpCachePath;
+
+/** the maximum number of @a ConfigFileFetcher threads for retrieving configuration files from HTTP in parallel. */
+#define MAX_CONFIG_FETCHERS 4
+
+/** the content and modification time of configuration files retrieved from HTTP in advance (by relative URI). */
+static map<string, pair<string, time_t>> s_fetchedConfig;
+
+/** the @a FileRowsCache for the read configuration files, or nullptr. */
+static FileRowsCache* s_configCache = nullptr;
+
+/** the maximum number of @a FileSplitter threads for reading local configuration files in parallel. */
+#define MAX_CONFIG_SPLITTERS 8
+
+/** the @a CachedFileRows of local configuration files split in parallel before being added (by relative name). */
+static map<string, CachedFileRows> s_splitRows;
+
 /** the documentation of the program. */
 static const char argpdoc[] =
   "A daemon for communication with eBUS heating systems.";
@@ -150,7 +181,9 @@ static const char argpdoc[] =
 #define O_CFGLNG (O_DEVLAT+1)
 #define O_CHKCFG (O_CFGLNG+1)
 #define O_DMPCFG (O_CHKCFG+1)
-#define O_POLINT (O_DMPCFG+1)
+#define O_CFGCAC (O_DMPCFG+1)
+#define O_HTTCAC (O_CFGCAC+1)
+#define O_POLINT (O_HTTCAC+1)
 #define O_ANSWER (O_POLINT+1)
 #define O_ACQTIM (O_ANSWER+1)
 #define O_ACQRET (O_ACQTIM+1)
@@ -199,6 +232,10 @@ static const struct argp_option argpoptions[] = {
       "Prefer LANG in multilingual configuration files [system default language]", 0 },
   {"checkconfig",    O_CHKCFG, nullptr,    0, "Check CSV config files, then stop", 0 },
   {"dumpconfig",     O_DMPCFG, nullptr,    0, "Check and dump CSV config files, then stop", 0 },
+  {"configcache",    O_CFGCAC, "FILE",     0, "Cache the read CSV config files in binary FILE for a faster startup",
+      0 },
+  {"httpcache",      O_HTTCAC, "PATH",     0, "Keep CSV config files retrieved from HTTP configpath in PATH, "
+      "revalidate them on use, and use them when the server is unavailable", 0 },
   {"pollinterval",   O_POLINT, "SEC",      0, "Poll for data every SEC seconds (0=disable) [5]", 0 },
   {"inject",         'i',      nullptr,    0, "Inject remaining arguments as already seen messages (e.g. "
       "\"FF08070400/0AB5454850303003277201\")", 0 },
@@ -260,6 +297,9 @@ static DataFieldTemplates s_globalTemplates;
  */
 static map<string, DataFieldTemplates*> s_templatesByPath;
 
+/** the @a Mutex for serializing the loading of config files and templates. */
+static Mutex s_configMutex;
+
 /**
  * The program argument parsing function.
  * @param key the key from @a argpoptions.
@@ -350,6 +390,20 @@ error_t parse_opt(int key, char *arg, struct argp_state *state) {
     opt->checkConfig = true;
     opt->dumpConfig = true;
     break;
+  case O_CFGCAC:  // --configcache=/var/cache/ebusd/config.bin
+    if (arg == nullptr || arg[0] == 0) {
+      argp_error(state, "invalid configcache");
+      return EINVAL;
+    }
+    opt->configCache = arg;
+    break;
+  case O_HTTCAC:  // --httpcache=/var/cache/ebusd/http
+    if (arg == nullptr || arg[0] == 0 || strcmp("/", arg) == 0) {
+      argp_error(state, "invalid httpcache");
+      return EINVAL;
+    }
+    opt->httpCache = arg;
+    break;
   case O_POLINT:  // --pollinterval=5
     opt->pollInterval = parseInt(arg, 10, 0, 3600, &result);
     if (result != RESULT_OK) {
@@ -694,6 +748,10 @@ void shutdown(bool error = false) {
     }
   }
   s_templatesByPath.clear();
+  if (s_configCache) {
+    delete s_configCache;
+    s_configCache = nullptr;
+  }
 
   // reset all signal handlers to default
   signal(SIGHUP, SIG_DFL);
@@ -744,6 +802,212 @@ void signalHandler(int sig) {
   }
 }
 
+/**
+ * Get the name of the local HTTP cache file for the URI.
+ * @param uri the URI relative to the config path.
+ * @return the name of the local cache file (without extension).
+ */
+static string getHttpCacheFile(const string& uri) {
+  ostringstream name;
+  name << s_httpCachePath;
+  for (const auto ch : uri) {
+    if (isalnum(static_cast<unsigned char>(ch)) || ch == '.' || ch == '_' || ch == '-') {
+      name << ch;
+    } else {
+      name << '%' << setw(2) << hex << setfill('0') << static_cast<unsigned>(static_cast<unsigned char>(ch))
+           << dec << setw(0);
+    }
+  }
+  return name.str();
+}
+
+/**
+ * Retrieve configuration files or listings from the HTTP config path with pipelined requests, revalidating and
+ * updating the local HTTP cache if enabled. The cached content is used when not modified or when the server is
+ * unavailable.
+ * @param client the @a HttpClient to use.
+ * @param requests the @a conditionalGet_t with the URIs relative to the config path to retrieve (updated with the
+ * content in @a conditionalGet_t::response and the modification time in @a conditionalGet_t::time on success).
+ */
+static void fetchConfigHttp(HttpClient* client, vector<conditionalGet_t>* requests) {
+  size_t count = requests->size();
+  vector<string> uris(count), cachedContents(count);
+  vector<time_t> cachedTimes(count, 0);
+  vector<char> cached(count, 0);  // no vector<bool> in order to not share words between elements
+  for (size_t index = 0; index < count; index++) {
+    conditionalGet_t& get = (*requests)[index];
+    uris[index] = get.uri;
+    get.uri = s_configUriPrefix + uris[index];
+    get.etag.clear();
+    get.time = 0;
+    if (s_httpCachePath.empty()) {
+      continue;
+    }
+    const string cacheFile = getHttpCacheFile(uris[index]);
+    ifstream metaStream((cacheFile + ".meta").c_str());
+    if (metaStream.is_open() && getline(metaStream, get.etag) && (metaStream >> cachedTimes[index])) {
+      ifstream bodyStream(cacheFile.c_str(), ifstream::in | ifstream::binary);
+      if (bodyStream.is_open()) {
+        ostringstream body;
+        body << bodyStream.rdbuf();
+        cachedContents[index] = body.str();
+        cached[index] = 1;
+        get.time = cachedTimes[index];
+        continue;
+      }
+    }
+    get.etag.clear();
+    cachedTimes[index] = 0;
+  }
+  client->getIfModified(requests);
+  for (size_t index = 0; index < count; index++) {
+    conditionalGet_t& get = (*requests)[index];
+    get.uri = uris[index];
+    if (!get.success) {
+      if (!cached[index]) {
+        continue;
+      }
+      logNotice(lf_main, "unable to retrieve %s, using cached content", get.uri.c_str());
+      get.success = true;
+      get.modified = false;
+    }
+    if (!get.modified) {
+      get.response.swap(cachedContents[index]);
+      get.time = cachedTimes[index];
+      continue;
+    }
+    if (s_httpCachePath.empty()) {
+      continue;
+    }
+    // write the content and meta data to temporary files first in order to not leave a partially written file
+    // behind, and drop the old meta data before replacing the content so that a stale meta file never validates
+    // new content
+    const string cacheFile = getHttpCacheFile(get.uri);
+    const string tempFile = cacheFile + ".tmp", metaFile = cacheFile + ".meta", tempMetaFile = metaFile + ".tmp";
+    ofstream bodyStream(tempFile.c_str(), ofstream::out | ofstream::binary | ofstream::trunc);
+    bodyStream << get.response;
+    bodyStream.close();
+    ofstream metaStream(tempMetaFile.c_str(), ofstream::out | ofstream::trunc);
+    metaStream << get.etag << "\n" << get.time << "\n";
+    metaStream.close();
+    if (bodyStream.fail() || metaStream.fail()) {
+      remove(tempFile.c_str());
+      remove(tempMetaFile.c_str());
+      logError(lf_main, "unable to update HTTP cache for %s", get.uri.c_str());
+      continue;
+    }
+    remove(metaFile.c_str());
+    if (rename(tempFile.c_str(), cacheFile.c_str()) != 0 || rename(tempMetaFile.c_str(), metaFile.c_str()) != 0) {
+      remove(tempFile.c_str());
+      remove(tempMetaFile.c_str());
+      logError(lf_main, "unable to update HTTP cache for %s", get.uri.c_str());
+    }
+  }
+}
+
+/**
+ * Retrieve a configuration file or listing from the HTTP config path unless already retrieved in advance.
+ * @param uri the URI relative to the config path.
+ * @param content the string in which to store the content.
+ * @param mtime optional pointer to a @a time_t value for storing the modification time, or nullptr.
+ * @return true on success, false on error.
+ */
+static bool getConfigHttp(const string& uri, string* content, time_t* mtime) {
+  s_configMutex.lock();
+  const auto it = s_fetchedConfig.find(uri);
+  if (it != s_fetchedConfig.end()) {
+    content->swap(it->second.first);
+    if (mtime) {
+      *mtime = it->second.second;
+    }
+    s_fetchedConfig.erase(it);
+    s_configMutex.unlock();
+    return true;
+  }
+  vector<conditionalGet_t> requests(1);
+  requests[0].uri = uri;
+  fetchConfigHttp(&s_configHttpClient, &requests);
+  s_configMutex.unlock();
+  content->swap(requests[0].response);
+  if (mtime) {
+    *mtime = requests[0].time;
+  }
+  return requests[0].success;
+}
+
+/**
+ * A thread retrieving configuration files from HTTP with pipelined requests on its own connection.
+ */
+class ConfigFileFetcher : public Thread {
+ public:
+  /**
+   * Constructor.
+   * @param requests the @a conditionalGet_t with the URIs relative to the config path to retrieve.
+   */
+  explicit ConfigFileFetcher(vector<conditionalGet_t>* requests) : Thread(), m_requests(requests) {}
+
+
+ protected:
+  // @copydoc
+  void run() override {
+    HttpClient client;
+    client.connect(s_configHost, s_configPort, PACKAGE_NAME "/" PACKAGE_VERSION);
+    fetchConfigHttp(&client, m_requests);
+  }
+
+
+ private:
+  /** the @a conditionalGet_t with the URIs relative to the config path to retrieve. */
+  vector<conditionalGet_t>* m_requests;
+};
+
+/**
+ * Retrieve configuration files from the HTTP config path in parallel for being used by @a getConfigHttp() afterwards.
+ * @param uris the URIs relative to the config path to retrieve.
+ */
+static void fetchConfigFiles(const vector<string>& uris) {
+  size_t count = uris.size() > MAX_CONFIG_FETCHERS ? MAX_CONFIG_FETCHERS : uris.size();
+  if (uris.size() < 2) {
+    return;  // not worth retrieving in advance
+  }
+  // distribute the files to the connections, each sending its requests pipelined
+  vector<vector<conditionalGet_t>> requests(count);
+  for (size_t index = 0; index < uris.size(); index++) {
+    conditionalGet_t get;
+    get.uri = uris[index];
+    requests[index % count].push_back(get);
+  }
+  vector<ConfigFileFetcher*> fetchers;
+  for (auto& connectionRequests : requests) {
+    ConfigFileFetcher* fetcher = new ConfigFileFetcher(&connectionRequests);
+    if (fetcher->start("configfetcher")) {
+      fetchers.push_back(fetcher);
+    } else {
+      delete fetcher;
+      connectionRequests.clear();
+    }
+  }
+  for (auto fetcher : fetchers) {
+    fetcher->join();
+    delete fetcher;
+  }
+  size_t fetchedCount = 0;
+  s_configMutex.lock();
+  for (auto& connectionRequests : requests) {
+    for (auto& get : connectionRequests) {
+      if (get.success) {
+        pair<string, time_t>& content = s_fetchedConfig[get.uri];
+        content.first.swap(get.response);
+        content.second = get.time;
+        fetchedCount++;
+      }
+    }
+  }
+  s_configMutex.unlock();
+  logInfo(lf_main, "retrieved %d of %d config files with %d connections", fetchedCount, uris.size(),
+      fetchers.size());
+}
+
 /**
  * Collect configuration files matching the prefix and extension from the specified path.
  * @param relPath the relative path from which to collect the files (without trailing "/").
@@ -760,9 +1024,8 @@ static result_t collectConfigFiles(const string& relPath, const string& prefix,
     vector<string>* dirs = nullptr, bool* hasTemplates = nullptr) {
   const string relPathWithSlash = relPath.empty() ? "" : relPath + "/";
   if (!s_configUriPrefix.empty()) {
-    string uri = s_configUriPrefix + relPathWithSlash + "?t=" + extension.substr(1) + query;
     string names;
-    if (!s_configHttpClient.get(uri, "", &names)) {
+    if (!getConfigHttp(relPathWithSlash + "?t=" + extension.substr(1) + query, &names, nullptr)) {
       return RESULT_ERR_NOTFOUND;
     }
     istringstream stream(names);
@@ -896,17 +1159,27 @@ static bool readTemplates(const string relPath, const string extension, bool ava
  * @param recursive whether to load all files recursively.
  * @param verbose whether to verbosely log problems.
  * @param errorDescription a string in which to store the error description in case of error.
+ * @param collectOnly the @a vector to which to only add the relative names of the files that would be read
+ * (including the templates) instead of reading them, or nullptr.
  * @return the result code.
  */
 static result_t readConfigFiles(const string& relPath, const string& extension, const bool recursive,
-    const bool verbose, string* errorDescription, MessageMap* messages) {
+    const bool verbose, string* errorDescription, MessageMap* messages, vector<string>* collectOnly = nullptr) {
   vector<string> files, dirs;
   bool hasTemplates = false;
   result_t result = collectConfigFiles(relPath, "", extension, &files, false, "", &dirs, &hasTemplates);
   if (result != RESULT_OK) {
     return result;
   }
-  readTemplates(relPath, extension, hasTemplates, verbose);
+  if (collectOnly) {
+    if (hasTemplates && s_templatesByPath.find(relPath) == s_templatesByPath.end()) {
+      collectOnly->push_back((relPath.empty() ? "" : relPath + "/") + "_templates" + extension);
+    }
+    collectOnly->insert(collectOnly->end(), files.begin(), files.end());
+    files.clear();
+  } else {
+    readTemplates(relPath, extension, hasTemplates, verbose);
+  }
   for (const auto& name : files) {
     logInfo(lf_main, "reading file %s", name.c_str());
     result_t result = loadDefinitionsFromConfigPath(messages, name, verbose, nullptr, errorDescription);
@@ -917,17 +1190,62 @@ static result_t readConfigFiles(const string& relPath, const string& extension,
   }
   if (recursive) {
     for (const auto& name : dirs) {
-      logInfo(lf_main, "reading dir  %s", name.c_str());
-      result = readConfigFiles(name, extension, true, verbose, errorDescription, messages);
+      if (!collectOnly) {
+        logInfo(lf_main, "reading dir  %s", name.c_str());
+      }
+      result = readConfigFiles(name, extension, true, verbose, errorDescription, messages, collectOnly);
       if (result != RESULT_OK) {
         return result;
       }
-      logInfo(lf_main, "successfully read dir %s", name.c_str());
+      if (!collectOnly) {
+        logInfo(lf_main, "successfully read dir %s", name.c_str());
+      }
     }
   }
   return RESULT_OK;
 }
 
+/**
+ * Split the local configuration files from the specified path in parallel into @a s_splitRows for being added
+ * afterwards in the usual order.
+ * @param relPath the relative path from which to read the files (without trailing "/").
+ * @param extension the filename extension of the files to read.
+ * @param recursive whether to read all files recursively.
+ */
+static void splitConfigFiles(const string& relPath, const string& extension, const bool recursive) {
+  s_splitRows.clear();
+  if (!s_configUriPrefix.empty()) {
+    return;  // the HTTP client handles a single request at a time
+  }
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  vector<string> files;
+  string errorDescription;
+  // walk the same way as for reading so that exactly the files to be read afterwards are split
+  readConfigFiles(relPath, extension, recursive, false, &errorDescription, nullptr, &files);
+  if (s_configCache) {
+    // skip the files available in the cache
+    for (auto it = files.begin(); it != files.end(); ) {
+      struct stat st;
+      if (stat((s_configLocalPrefix + *it).c_str(), &st) == 0 && s_configCache->get(*it,
+          static_cast<uint64_t>(st.st_mtim.tv_sec)*1000000000ULL + static_cast<uint64_t>(st.st_mtim.tv_nsec),
+          static_cast<size_t>(st.st_size))) {
+        it = files.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+  size_t count = cpus < 2 ? 0 : cpus > MAX_CONFIG_SPLITTERS ? MAX_CONFIG_SPLITTERS : static_cast<size_t>(cpus);
+  if (count > files.size()) {
+    count = files.size();
+  }
+  if (count < 2) {
+    return;  // not worth splitting in parallel
+  }
+  size_t threads = FileSplitter::splitFiles(s_configLocalPrefix, files, count, &s_splitRows);
+  logInfo(lf_main, "split %d config files with %d threads", s_splitRows.size(), threads);
+}
+
 /**
  * Helper method for immediate reading of a @a Message from the bus.
  * @param message the @a Message to read.
@@ -968,28 +1286,83 @@ result_t loadDefinitionsFromConfigPath(FileReader* reader, const string& filenam
     map<string, string>* defaults, string* errorDescription, bool replace) {
   istream* stream = nullptr;
   time_t mtime = 0;
+  uint64_t stamp = 0;
+  size_t fileSize = 0;
+  CachedFileRows* cachedRows = nullptr;
+  CachedFileRows* splitRows = nullptr;
+  string content;
+  s_configMutex.lock();  // for the config cache (already locked when called from loading the config files)
   if (s_configUriPrefix.empty()) {
-    stream = FileReader::openFile(s_configLocalPrefix + filename, errorDescription, &mtime);
+    struct stat st;
+    if ((s_configCache || !s_splitRows.empty()) && stat((s_configLocalPrefix + filename).c_str(), &st) == 0) {
+      mtime = st.st_mtime;
+      stamp = static_cast<uint64_t>(st.st_mtim.tv_sec)*1000000000ULL + static_cast<uint64_t>(st.st_mtim.tv_nsec);
+      fileSize = static_cast<size_t>(st.st_size);
+      if (s_configCache) {
+        cachedRows = s_configCache->get(filename, stamp, fileSize);
+      }
+      const auto it = cachedRows ? s_splitRows.end() : s_splitRows.find(filename);
+      if (it != s_splitRows.end() && it->second.m_stamp == stamp && it->second.m_fileSize == fileSize) {
+        splitRows = &it->second;
+      }
+    }
+    if (!cachedRows && !splitRows) {
+      stream = FileReader::openFile(s_configLocalPrefix + filename, errorDescription, &mtime);
+    }
   } else {
-    string content;
-    if (s_configHttpClient.get(s_configUriPrefix + filename, "", &content, &mtime)) {
-      stream = new istringstream(content);
+    if (getConfigHttp(filename, &content, &mtime)) {
+      // identify the content by its hash as the server might not tell the modification time
+      stamp = static_cast<uint64_t>(std::hash<string>()(content));
+      fileSize = content.size();
+      if (s_configCache) {
+        cachedRows = s_configCache->get(filename, stamp, fileSize);
+      }
+      if (!cachedRows) {
+        stream = new BufferStream(content.data(), content.size());
+      }
     }
   }
   result_t result;
-  if (stream) {
+  if (cachedRows) {
+    logDebug(lf_main, "using cached rows of %s", filename.c_str());
+    reader->setCachedRows(cachedRows);
+    result = reader->readFromStream(nullptr, filename, mtime, verbose, defaults, errorDescription, replace);
+  } else if (splitRows) {
+    reader->setCachedRows(splitRows);
+    result = reader->readFromStream(nullptr, filename, mtime, verbose, defaults, errorDescription, replace);
+    if (s_configCache && result == RESULT_OK) {
+      *s_configCache->prepare(filename, stamp, fileSize) = std::move(*splitRows);
+      s_configCache->commit(filename);
+    }
+    s_splitRows.erase(filename);
+  } else if (stream) {
+    if (s_configCache) {
+      reader->setCachedRows(s_configCache->prepare(filename, stamp, fileSize));
+    }
     result = reader->readFromStream(stream, filename, mtime, verbose, defaults, errorDescription, replace);
+    if (s_configCache) {
+      s_configCache->commit(filename);
+    }
     delete(stream);
   } else {
     result = RESULT_ERR_NOTFOUND;
   }
+  s_configMutex.unlock();
   return result;
 }
 
+/**
+ * Save the @a FileRowsCache of the read configuration files if enabled and modified.
+ */
+static void saveConfigCache() {
+  if (s_configCache && !s_configCache->save()) {
+    logError(lf_main, "unable to save config cache %s", opt.configCache);
+  }
+}
+
 result_t loadConfigFiles(MessageMap* messages, bool verbose, bool denyRecursive) {
   logInfo(lf_main, "loading configuration files from %s", opt.configPath);
-  messages->lock();
-  messages->clear();
+  s_configMutex.lock();
   s_globalTemplates.clear();
   for (auto& it : s_templatesByPath) {
     if (it.second != &s_globalTemplates) {
@@ -999,16 +1372,24 @@ result_t loadConfigFiles(MessageMap* messages, bool verbose, bool denyRecursive)
   }
   s_templatesByPath.clear();
 
+  // load into a separate instance so that readers of the current definitions are not blocked in the meantime
+  MessageMap* loaded = new MessageMap(opt.checkConfig, "", false);
   string errorDescription;
-  result_t result = readConfigFiles("", ".csv",
-      (!opt.scanConfig || opt.checkConfig) && !denyRecursive, verbose, &errorDescription, messages);
+  bool recursive = (!opt.scanConfig || opt.checkConfig) && !denyRecursive;
+  splitConfigFiles("", ".csv", recursive);
+  result_t result = readConfigFiles("", ".csv", recursive, verbose, &errorDescription, loaded);
+  s_splitRows.clear();
   if (result == RESULT_OK) {
     logInfo(lf_main, "read config files");
   } else {
     logError(lf_main, "error reading config files from %s: %s, last error: %s", opt.configPath,
         getResultCode(result), errorDescription.c_str());
   }
-  messages->unlock();
+  messages->swapDefinitions(loaded);
+  saveConfigCache();
+  // the previous messages are freed as soon as no other thread holds them anymore (checked regularly afterwards)
+  messages->freeRetiredDefinitions();
+  s_configMutex.unlock();
   return opt.checkConfig ? result : RESULT_OK;
 }
 
@@ -1151,24 +1532,44 @@ result_t loadScanConfigFile(MessageMap* messages, symbol_t address, bool verbose
   }
 
   // found the right file. load the templates if necessary, then load the file itself
+  s_configMutex.lock();
+  if (!fromLocal) {
+    // retrieve the files needed below in parallel
+    vector<string> uris;
+    uris.push_back(best);
+    if (s_templatesByPath.find(manufStr) == s_templatesByPath.end()) {
+      if (hasTemplates) {
+        uris.push_back(manufStr + "/_templates.csv");
+      }
+      uris.push_back(manufStr + "/?t=csv&a=-");
+    }
+    fetchConfigFiles(uris);
+  }
   bool readCommon = readTemplates(manufStr, ".csv", hasTemplates, opt.checkConfig);
   if (readCommon) {
     result = collectConfigFiles(manufStr, "", ".csv", &files, true, "&a=-");
     if (result == RESULT_OK && !files.empty()) {
+      vector<string> commonFiles;
       for (const auto& name : files) {
         string baseName = name.substr(manufStr.length()+1, name.length()-manufStr.length()-strlen(".csv"));  // *.
         if (baseName == "_templates.") {  // skip templates
           continue;
         }
         if (baseName.length() < 3 || baseName.find_first_of('.') != 2) {  // different from the scheme "ZZ."
-          string errorDescription;
-          result = loadDefinitionsFromConfigPath(messages, name, verbose, nullptr, &errorDescription);
-          if (result == RESULT_OK) {
-            logNotice(lf_main, "read common config file %s", name.c_str());
-          } else {
-            logError(lf_main, "error reading common config file %s: %s, %s", name.c_str(), getResultCode(result),
-                errorDescription.c_str());
-          }
+          commonFiles.push_back(name);
+        }
+      }
+      if (!fromLocal) {
+        fetchConfigFiles(commonFiles);
+      }
+      for (const auto& name : commonFiles) {
+        string errorDescription;
+        result = loadDefinitionsFromConfigPath(messages, name, verbose, nullptr, &errorDescription);
+        if (result == RESULT_OK) {
+          logNotice(lf_main, "read common config file %s", name.c_str());
+        } else {
+          logError(lf_main, "error reading common config file %s: %s, %s", name.c_str(), getResultCode(result),
+              errorDescription.c_str());
         }
       }
     }
@@ -1176,11 +1577,16 @@ result_t loadScanConfigFile(MessageMap* messages, symbol_t address, bool verbose
   bestDefaults["name"] = ident;
   string errorDescription;
   result = loadDefinitionsFromConfigPath(messages, best, verbose, &bestDefaults, &errorDescription);
+  s_fetchedConfig.clear();  // drop anything retrieved in advance but not used
   if (result != RESULT_OK) {
     logError(lf_main, "error reading scan config file %s for ID \"%s\", SW%4.4d, HW%4.4d: %s, %s", best.c_str(),
         ident.c_str(), sw, hw, getResultCode(result), errorDescription.c_str());
+    saveConfigCache();
+    s_configMutex.unlock();
     return result;
   }
+  saveConfigCache();
+  s_configMutex.unlock();
   logNotice(lf_main, "read scan config file %s for ID \"%s\", SW%4.4d, HW%4.4d", best.c_str(), ident.c_str(), sw, hw);
   *relativeFile = best;
   return RESULT_OK;
@@ -1247,15 +1653,24 @@ int main(int argc, char* argv[]) {
       logError(lf_main, "invalid configpath without scanconfig");
       return EINVAL;
     }
-    uint16_t configPort = 80;
-    string proto, configHost;
-    if (!HttpClient::parseUrl(configPath, &proto, &configHost, &configPort, &s_configUriPrefix)) {
+    string proto;
+    if (!HttpClient::parseUrl(configPath, &proto, &s_configHost, &s_configPort, &s_configUriPrefix)) {
       logError(lf_main, "invalid configPath URL");
       return EINVAL;
     }
-    if (!s_configHttpClient.connect(configHost, configPort, PACKAGE_NAME "/" PACKAGE_VERSION)) {
-      logError(lf_main, "invalid configPath URL");
-      return EINVAL;
+    if (opt.httpCache[0]) {
+      s_httpCachePath = opt.httpCache[strlen(opt.httpCache)-1] == '/' ? opt.httpCache : string(opt.httpCache) + "/";
+      if (mkdir(s_httpCachePath.c_str(), 0755) != 0 && errno != EEXIST) {
+        logError(lf_main, "unable to create httpcache %s", opt.httpCache);
+        return EINVAL;
+      }
+    }
+    if (!s_configHttpClient.connect(s_configHost, s_configPort, PACKAGE_NAME "/" PACKAGE_VERSION)) {
+      if (s_httpCachePath.empty()) {
+        logError(lf_main, "invalid configPath URL");
+        return EINVAL;
+      }
+      logNotice(lf_main, "configPath URL currently not reachable, using httpcache");
     }
     s_configHttpClient.disconnect();
   }
@@ -1267,6 +1682,12 @@ int main(int argc, char* argv[]) {
     setFacilitiesLogLevel(opt.logAreas, opt.logLevel);
   }
 
+  if (opt.configCache[0]) {
+    s_configCache = new FileRowsCache(opt.configCache);
+    if (s_configCache->load()) {
+      logInfo(lf_main, "loaded config cache %s with %d files", opt.configCache, s_configCache->size());
+    }
+  }
   s_messageMap = new MessageMap(opt.checkConfig);
   if (opt.checkConfig) {
     logNotice(lf_main, PACKAGE_STRING "." REVISION " performing configuration check...");
@@ -49,6 +49,8 @@ struct options {
   const char* preferLanguage;  //!< preferred language in configuration files
   bool checkConfig;  //!< check CSV config files, then stop
   bool dumpConfig;   //!< dump CSV config files, then stop
+  const char* configCache;  //!< binary file for caching the read CSV config files, or empty to disable []
+  const char* httpCache;  //!< path for caching the CSV config files retrieved via HTTP, or empty to disable []
   unsigned int pollInterval;  //!< poll interval in seconds, 0 to disable [5]
   bool injectMessages;  //!< inject remaining arguments as already seen messages
 
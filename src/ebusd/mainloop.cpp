@@ -98,6 +98,9 @@ result_t UserList::addFromFile(const string& filename, unsigned int lineNo, map<
 }
 
 
+/** the number of @a QueryWorker instances. */
+#define QUERY_WORKERS 2
+
 MainLoop::MainLoop(const struct options& opt, Device *device, MessageMap* messages)
   : Thread(), m_device(device), m_reconnectCount(0), m_userList(opt.accessLevel), m_messages(messages),
     m_address(opt.address), m_scanConfig(opt.scanConfig), m_initialScan(opt.readOnly ? ESC : opt.initialScan),
@@ -153,6 +156,11 @@ MainLoop::MainLoop(const struct options& opt, Device *device, MessageMap* messag
   m_htmlPath = opt.htmlPath;
   m_network = new Network(opt.localOnly, opt.port, opt.httpPort, &m_netQueue);
   m_network->start("network");
+  for (int i = 0; i < QUERY_WORKERS; i++) {
+    QueryWorker* worker = new QueryWorker(this);
+    worker->start("queryworker");
+    m_queryWorkers.push_back(worker);
+  }
   logInfo(lf_main, "registering data handlers");
   if (datahandler_register(&m_userList, m_busHandler, messages, &m_dataHandlers)) {
     logInfo(lf_main, "registered data handlers");
@@ -165,6 +173,15 @@ MainLoop::MainLoop(const struct options& opt, Device *device, MessageMap* messag
 MainLoop::~MainLoop() {
   m_shutdown = true;
   join();
+  for (const auto worker : m_queryWorkers) {
+    worker->join();
+    delete worker;
+  }
+  m_queryWorkers.clear();
+  NetMessage* netMessage;
+  while ((netMessage = m_mainQueue.pop()) != nullptr) {
+    netMessage->setResult("ERR: shutdown", "", nullptr, 0, 0, true);
+  }
 
   for (const auto dataHandler : m_dataHandlers) {
     delete dataHandler;
@@ -209,6 +226,7 @@ MainLoop::~MainLoop() {
 void MainLoop::run() {
   bool reload = true;
   time_t lastTaskRun, now, start, lastSignal = 0, since, sinkSince = 1, nextCheckRun;
+  uint64_t sinceSequence, sinkSequence = 0;
   int taskDelay = 5;
   symbol_t lastScanAddress = 0;  // 0 is known to be a master
   string lastScanStatus = ".";
@@ -228,7 +246,7 @@ void MainLoop::run() {
   }
   while (!m_shutdown) {
     // pick the next message to handle
-    NetMessage* netMessage = m_netQueue.pop(taskDelay);
+    NetMessage* netMessage = m_mainQueue.pop(taskDelay);
     time(&now);
     if (now < lastTaskRun) {
       // clock skew
@@ -245,6 +263,7 @@ void MainLoop::run() {
         m_busHandler->reconnect();
         m_reconnectCount++;
       }
+      m_messages->freeRetiredDefinitions();
       if (m_scanConfig) {
         bool loadDelay = false;
         string scanStatus = lastScanStatus;
@@ -369,56 +388,51 @@ void MainLoop::run() {
     time(&now);
     if (!dataSinks.empty()) {
       messages.clear();
-      m_messages->lock();
-      m_messages->findAll("", "", "*", false, true, true, true, true, true, sinkSince, now, false, &messages);
+      m_messages->lockShared();
+      if (!m_messages->findUpdates("*", false, &sinkSequence, &messages)) {
+        // journal overrun: fall back to checking the update time of all messages
+        m_messages->findAll("", "", "*", false, true, true, true, true, true, sinkSince, 0, false, &messages);
+      }
+      m_messages->unlockShared();
       for (const auto message : messages) {
         for (const auto dataSink : dataSinks) {
           dataSink->notifyUpdate(message);
         }
       }
-      m_messages->unlock();
       sinkSince = now;
     }
     if (netMessage == nullptr) {
       continue;
     }
     if (m_shutdown) {
-      netMessage->setResult("ERR: shutdown", "", nullptr, now, true);
+      netMessage->setResult("ERR: shutdown", "", nullptr, now, 0, true);
       break;
     }
     string request = netMessage->getRequest();
     string user = netMessage->getUser();
-    ClientSettings settings = netMessage->getSettings(&since);
+    ClientSettings settings = netMessage->getSettings(&since, &sinceSequence);
     if (!netMessage->isListeningMode()) {
       since = now;
+      sinceSequence = m_messages->getUpdateSequence();
     }
     ostringstream ostream;
-    bool connected = true;
+    bool connected = !netMessage->isHttp() || netMessage->isKeepAlive();
     if (request.length() > 0) {
-      logDebug(lf_main, ">>> %s", request.c_str());
-      result_t result = decodeMessage(request, netMessage->isHttp(), &connected, &settings, &user, &reload, &ostream);
-      if (!netMessage->isHttp() && (ostream.tellp() == 0 || result != RESULT_OK)) {
-        if (settings.mode != cm_direct) {
-          ostream.str("");
-        }
-        ostream << getResultCode(result);
-      }
-      if (ostream.tellp() > 100) {
-        logDebug(lf_main, "<<< %s ...", ostream.str().substr(0, 100).c_str());
-      } else {
-        logDebug(lf_main, "<<< %s", ostream.str().c_str());
-      }
-      if (ostream.tellp() == 0) {
-        ostream << "\n";  // only for HTTP
-      } else if (!netMessage->isHttp()) {
-        ostream << (settings.mode == cm_direct ? "\n" : "\n\n");
+      if (!netMessage->isBusRequired()) {
+        logDebug(lf_main, ">>> %s", request.c_str());
       }
+      executeRequest(request, netMessage->isHttp(), false, &connected, &settings, &user, &reload, &ostream);
     }
     if (settings.mode == cm_listen) {
       if (!settings.listenOnlyUnknown) {
         string levels = getUserLevels(user);
         messages.clear();
-        m_messages->findAll("", "", levels, false, true, true, true, true, true, since, now, true, &messages);
+        m_messages->lockShared();
+        if (!m_messages->findUpdates(levels, true, &sinceSequence, &messages)) {
+          // journal overrun: fall back to checking the change time of all messages
+          m_messages->findAll("", "", levels, false, true, true, true, true, true, since, 0, true, &messages);
+        }
+        m_messages->unlockShared();
         for (const auto message : messages) {
           ostream << message->getCircuit() << " " << message->getName() << " = " << dec;
           message->decodeLastData(false, nullptr, -1, settings.format, &ostream);
@@ -438,10 +452,85 @@ void MainLoop::run() {
       }
     }
     // send result to client
-    netMessage->setResult(ostream.str(), user, &settings, now, !connected);
+    netMessage->setResult(ostream.str(), user, &settings, now, sinceSequence, !connected);
   }
 }
 
+void QueryWorker::run() {
+  m_mainLoop->handleQueries();
+}
+
+void MainLoop::handleQueries() {
+  while (!m_shutdown) {
+    NetMessage* netMessage = m_netQueue.pop(1);
+    if (netMessage == nullptr) {
+      continue;
+    }
+    string request = netMessage->getRequest();
+    if (netMessage->isListeningMode() || !isQuery(request, netMessage->isHttp())) {
+      m_mainQueue.push(netMessage);
+      continue;
+    }
+    string user = netMessage->getUser();
+    ClientSettings settings = netMessage->getSettings();
+    ostringstream ostream;
+    bool connected = !netMessage->isHttp() || netMessage->isKeepAlive();
+    bool reload = false;
+    logDebug(lf_main, ">>> %s", request.c_str());
+    // the hold keeps the instances alive when the shared lock is given up for adding a derived scan message
+    uint64_t hold = m_messages->holdDefinitions();
+    m_messages->lockShared();
+    result_t result = executeRequest(request, netMessage->isHttp(), true, &connected, &settings, &user, &reload,
+        &ostream);
+    m_messages->unlockShared();
+    m_messages->releaseDefinitions(hold);
+    if (result == RESULT_CONTINUE) {
+      // needs the bus: pass to main loop
+      netMessage->setBusRequired();
+      m_mainQueue.push(netMessage);
+      continue;
+    }
+    time_t now;
+    time(&now);
+    netMessage->setResult(ostream.str(), user, &settings, now, m_messages->getUpdateSequence(), !connected);
+  }
+}
+
+bool MainLoop::isQuery(const string& request, bool isHttp) {
+  if (isHttp) {
+    return true;
+  }
+  size_t pos = request.find(' ');
+  string cmd = request.substr(0, pos);
+  transform(cmd.begin(), cmd.end(), cmd.begin(), ::toupper);
+  return cmd == "R" || cmd == "READ" || cmd == "F" || cmd == "FIND" || cmd == "I" || cmd == "INFO";
+}
+
+result_t MainLoop::executeRequest(const string& request, bool isHttp, bool cacheOnly, bool* connected,
+    ClientSettings* settings, string* user, bool* reload, ostringstream* ostream) {
+  result_t result = decodeMessage(request, isHttp, cacheOnly, connected, settings, user, reload, ostream);
+  if (cacheOnly && result == RESULT_CONTINUE) {
+    return result;
+  }
+  if (!isHttp && (ostream->tellp() == 0 || result != RESULT_OK)) {
+    if (settings->mode != cm_direct) {
+      ostream->str("");
+    }
+    *ostream << getResultCode(result);
+  }
+  if (ostream->tellp() > 100) {
+    logDebug(lf_main, "<<< %s ...", ostream->str().substr(0, 100).c_str());
+  } else {
+    logDebug(lf_main, "<<< %s", ostream->str().c_str());
+  }
+  if (ostream->tellp() == 0) {
+    *ostream << "\n";  // only for HTTP
+  } else if (!isHttp) {
+    *ostream << (settings->mode == cm_direct ? "\n" : "\n\n");
+  }
+  return RESULT_OK;
+}
+
 void MainLoop::notifyDeviceData(symbol_t symbol, bool received) {
   if (received && m_dumpFile) {
     m_dumpFile->write(&symbol, 1);
@@ -498,8 +587,8 @@ void MainLoop::notifyStatus(bool error, const char* message) {
   }
 }
 
-result_t MainLoop::decodeMessage(const string &data, bool isHttp, bool* connected, ClientSettings* settings,
-    string* user, bool* reload, ostringstream* ostream) {
+result_t MainLoop::decodeMessage(const string &data, bool isHttp, bool cacheOnly, bool* connected,
+    ClientSettings* settings, string* user, bool* reload, ostringstream* ostream) {
   string token, previous;
   istringstream stream(data);
   vector<string> args;
@@ -536,15 +625,17 @@ result_t MainLoop::decodeMessage(const string &data, bool isHttp, bool* connecte
   if (isHttp) {
     if (args.size() < 2) {
       *connected = false;
-      *ostream << "HTTP/1.0 400 Bad Request\r\n\r\n";
+      *ostream << "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close"
+               << "\r\nServer: " PACKAGE_NAME "/" PACKAGE_VERSION "\r\n\r\n";
       return RESULT_OK;
     }
     const char* str = args.size() > 0 ? args[0].c_str() : "";
     if (strcmp(str, "GET") == 0) {
-      return executeGet(args, connected, ostream);
+      return executeGet(args, connected, cacheOnly, ostream);
     }
     *connected = false;
-    *ostream << "HTTP/1.0 405 Method Not Allowed\r\n\r\n";
+    *ostream << "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\nConnection: close"
+             << "\r\nServer: " PACKAGE_NAME "/" PACKAGE_VERSION "\r\n\r\n";
     return RESULT_OK;
   }
 
@@ -573,7 +664,7 @@ result_t MainLoop::decodeMessage(const string &data, bool isHttp, bool* connecte
     return executeAuth(args, user, ostream);
   }
   if (cmd == "R" || cmd == "READ") {
-    return executeRead(args, getUserLevels(*user), ostream);
+    return executeRead(args, getUserLevels(*user), cacheOnly, ostream);
   }
   if (cmd == "W" || cmd == "WRITE") {
     return executeWrite(args, getUserLevels(*user), ostream);
@@ -686,7 +777,8 @@ result_t MainLoop::executeAuth(const vector<string>& args, string* user, ostring
   return RESULT_OK;
 }
 
-result_t MainLoop::executeRead(const vector<string>& args, const string& levels, ostringstream* ostream) {
+result_t MainLoop::executeRead(const vector<string>& args, const string& levels, bool cacheOnly,
+    ostringstream* ostream) {
   size_t argPos = 1;
   bool hex = false, newDefinition = false;
   OutputFormat verbosity = 0;
@@ -823,6 +915,9 @@ result_t MainLoop::executeRead(const vector<string>& args, const string& levels,
         "    DD         data byte(s) to send";
     return RESULT_OK;
   }
+  if (cacheOnly && (newDefinition || pollPriority > 0)) {
+    return RESULT_CONTINUE;
+  }
   time_t now;
   time(&now);
 
@@ -835,7 +930,9 @@ result_t MainLoop::executeRead(const vector<string>& args, const string& levels,
     if (master[1] == BROADCAST || isMaster(master[1])) {
       return RESULT_ERR_INVALID_ARG;
     }
-    logNotice(lf_main, "read hex cmd: %s", master.getStr().c_str());
+    if (!cacheOnly) {
+      logNotice(lf_main, "read hex cmd: %s", master.getStr().c_str());
+    }
 
     // find message
     Message* message = m_messages->find(master, false, true, false, false);
@@ -860,6 +957,9 @@ result_t MainLoop::executeRead(const vector<string>& args, const string& levels,
       *ostream << slave.getStr();
       return RESULT_OK;
     }
+    if (cacheOnly) {
+      return RESULT_CONTINUE;
+    }
 
     // send message
     SlaveSymbolString slave;
@@ -966,6 +1066,9 @@ result_t MainLoop::executeRead(const vector<string>& args, const string& levels,
   if (message->getDstAddress() == SYN && dstAddress == SYN) {
     return RESULT_ERR_INVALID_ADDR;
   }
+  if (cacheOnly) {
+    return RESULT_CONTINUE;
+  }
   // read directly from bus
   ret = m_busHandler->readFromBus(message, params, dstAddress, srcAddress);
   if (ret != RESULT_OK) {
@@ -1983,7 +2086,7 @@ bool parseBoolQuery(const string& value) {
   return value.length() == 0 || value == "1" || value == "true";
 }
 
-result_t MainLoop::executeGet(const vector<string>& args, bool* connected, ostringstream* ostream) {
+result_t MainLoop::executeGet(const vector<string>& args, bool* connected, bool cacheOnly, ostringstream* ostream) {
   bool required = false, full = false, withWrite = false, raw = false;
   bool withDefinition = false;
   OutputFormat verbosity = OF_NAMES;
@@ -2074,6 +2177,9 @@ result_t MainLoop::executeGet(const vector<string>& args, bool* connected, ostri
     time(&now);
     time_t maxLastUp = 0;
     if (ret == RESULT_OK) {
+      if (cacheOnly && pollPriority > 0) {
+        return RESULT_CONTINUE;
+      }
       bool first = true;
       verbosity |= OF_JSON | (full ? OF_ALL_ATTRS : 0) | (withDefinition ? OF_DEFINTION : 0);
       deque<Message*> messages;
@@ -2095,6 +2201,9 @@ result_t MainLoop::executeGet(const vector<string>& args, bool* connected, ostri
           if (message->isPassive()) {
             continue;  // not possible to actively read this message
           }
+          if (cacheOnly) {
+            return RESULT_CONTINUE;
+          }
           if (m_busHandler->readFromBus(message, "") != RESULT_OK) {
             continue;
           }
@@ -2170,8 +2279,7 @@ result_t MainLoop::executeGet(const vector<string>& args, bool* connected, ostri
                << "\n}";
       type = 6;
     }
-    *connected = false;
-    return formatHttpResult(ret, type, ostream);
+    return formatHttpResult(ret, type, *connected, ostream);
   }  // request for "/data..."
 
   if (uri.length() < 1 || uri[0] != '/' || uri.find("//") != string::npos || uri.find("..") != string::npos) {
@@ -2217,15 +2325,14 @@ result_t MainLoop::executeGet(const vector<string>& args, bool* connected, ostri
       }
     }
   }
-  *connected = false;
-  return formatHttpResult(ret, type, ostream);
+  return formatHttpResult(ret, type, *connected, ostream);
 }
 
-result_t MainLoop::formatHttpResult(result_t ret, int type, ostringstream* ostream) {
+result_t MainLoop::formatHttpResult(result_t ret, int type, bool keepAlive, ostringstream* ostream) {
   string data = ret == RESULT_OK ? ostream->str() : "";
   ostream->str("");
   ostream->clear();
-  *ostream << "HTTP/1.0 ";
+  *ostream << "HTTP/1.1 ";
   switch (ret) {
   case RESULT_OK:
     *ostream << "200 OK\r\nContent-Type: ";
@@ -2258,7 +2365,6 @@ result_t MainLoop::formatHttpResult(result_t ret, int type, ostringstream* ostre
       *ostream << "text/html";
       break;
     }
-    *ostream << "\r\nContent-Length: " << setw(0) << dec << static_cast<unsigned>(data.length());
     break;
   case RESULT_ERR_NOTFOUND:
     *ostream << "404 Not Found";
@@ -2275,7 +2381,9 @@ result_t MainLoop::formatHttpResult(result_t ret, int type, ostringstream* ostre
     *ostream << "500 Internal Server Error";
     break;
   }
-  *ostream << "\r\nServer: " PACKAGE_NAME "/" PACKAGE_VERSION "\r\n\r\n" << data;
+  *ostream << "\r\nContent-Length: " << setw(0) << dec << static_cast<unsigned>(data.length())
+           << "\r\nConnection: " << (keepAlive ? "keep-alive" : "close")
+           << "\r\nServer: " PACKAGE_NAME "/" PACKAGE_VERSION "\r\n\r\n" << data;
   return RESULT_OK;
 }
 
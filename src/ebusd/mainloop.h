@@ -94,10 +94,38 @@ class UserList : public UserInfo, public MappedFileReader {
 };
 
 
+/** Forward declaration for @a MainLoop. */
+class MainLoop;
+
+/**
+ * A worker thread answering client requests from cached data only.
+ */
+class QueryWorker : public Thread {
+ public:
+  /**
+   * Constructor.
+   * @param mainLoop the @a MainLoop instance.
+   */
+  explicit QueryWorker(MainLoop* mainLoop) : Thread(), m_mainLoop(mainLoop) {}
+
+
+ protected:
+  // @copydoc
+  void run() override;
+
+
+ private:
+  /** the @a MainLoop instance. */
+  MainLoop* m_mainLoop;
+};
+
+
 /**
  * The main loop handling requests from connected clients.
  */
 class MainLoop : public Thread, DeviceListener {
+  friend class QueryWorker;
+
  public:
   /**
    * Construct the main loop and create network and bus handling components.
@@ -142,18 +170,50 @@ class MainLoop : public Thread, DeviceListener {
 
 
  private:
+  /**
+   * Handle client requests from the @a Network in a @a QueryWorker and pass those not answerable from cached data
+   * only to the main loop.
+   */
+  void handleQueries();
+
+  /**
+   * Return whether the client request might be answered from cached data only.
+   * @param request the request string.
+   * @param isHttp true for HTTP message.
+   * @return true when the request might be answered from cached data only.
+   */
+  static bool isQuery(const string& request, bool isHttp);
+
+  /**
+   * Decode and execute client request and format the result string.
+   * @param request the request string to decode (not empty).
+   * @param isHttp true for HTTP message.
+   * @param cacheOnly true to answer from cached data only without changing anything.
+   * @param connected set to false when the client connection shall be closed.
+   * @param settings set to the new client settings.
+   * @param user set to the new user name when changed by authentication.
+   * @param reload set to true when the configuration files were reloaded.
+   * @param ostream the @a ostringstream to format the result string to.
+   * @return @a RESULT_CONTINUE when @p cacheOnly was set and the request needs to be executed without it,
+   * @a RESULT_OK otherwise.
+   */
+  result_t executeRequest(const string& request, bool isHttp, bool cacheOnly, bool* connected,
+      ClientSettings* settings, string* user, bool* reload, ostringstream* ostream);
+
   /**
    * Decode and execute client message.
    * @param data the data string to decode (may be empty).
-   * @param connected set to false when the client connection shall be closed.
    * @param isHttp true for HTTP message.
+   * @param cacheOnly true to answer from cached data only without changing anything.
+   * @param connected set to false when the client connection shall be closed.
    * @param settings set to the new client settings.
    * @param user set to the new user name when changed by authentication.
    * @param reload set to true when the configuration files were reloaded.
    * @param ostream the @a ostringstream to format the result string to.
-   * @return the result code.
+   * @return the result code (@a RESULT_CONTINUE when @p cacheOnly was set and the request needs to be executed
+   * without it).
    */
-  result_t decodeMessage(const string& data, bool isHttp, bool* connected, ClientSettings* settings,
+  result_t decodeMessage(const string& data, bool isHttp, bool cacheOnly, bool* connected, ClientSettings* settings,
       string* user, bool* reload, ostringstream* ostream);
 
   /**
@@ -187,10 +247,11 @@ class MainLoop : public Thread, DeviceListener {
    * Execute the read command.
    * @param args the arguments passed to the command (starting with the command itself), or empty for help.
    * @param levels the current user's access levels.
+   * @param cacheOnly true to answer from cached data only without changing anything.
    * @param ostream the @a ostringstream to format the result string to.
-   * @return the result code.
+   * @return the result code (@a RESULT_CONTINUE when @p cacheOnly was set and the bus is needed).
    */
-  result_t executeRead(const vector<string>& args, const string& levels, ostringstream* ostream);
+  result_t executeRead(const vector<string>& args, const string& levels, bool cacheOnly, ostringstream* ostream);
 
   /**
    * Execute the write command.
@@ -357,19 +418,21 @@ class MainLoop : public Thread, DeviceListener {
    * Execute the HTTP GET command.
    * @param args the arguments passed to the command (starting with the command itself).
    * @param connected set to false when the client connection shall be closed.
+   * @param cacheOnly true to answer from cached data only without changing anything.
    * @param ostream the @a ostringstream to format the result string to.
-   * @return the result code.
+   * @return the result code (@a RESULT_CONTINUE when @p cacheOnly was set and the bus is needed).
    */
-  result_t executeGet(const vector<string>& args, bool* connected, ostringstream* ostream);
+  result_t executeGet(const vector<string>& args, bool* connected, bool cacheOnly, ostringstream* ostream);
 
   /**
    * Format the HTTP answer to the result string.
    * @param ret the result code of handling the request.
    * @param type the content type.
+   * @param keepAlive whether the client connection shall be kept open.
    * @param ostream the @a ostringstream to format the result string to.
    * @return the result code.
    */
-  result_t formatHttpResult(result_t ret, int type, ostringstream* ostream);
+  result_t formatHttpResult(result_t ret, int type, bool keepAlive, ostringstream* ostream);
 
   /** the @a Device instance. */
   Device* m_device;
@@ -435,9 +498,15 @@ class MainLoop : public Thread, DeviceListener {
   /** the created @a Network instance. */
   Network* m_network;
 
-  /** the @a NetMessage @a Queue. */
+  /** the @a NetMessage @a Queue filled by the @a Network and handled by the @a QueryWorker instances. */
   Queue<NetMessage*> m_netQueue;
 
+  /** the @a NetMessage @a Queue for requests passed from the @a QueryWorker instances to the main loop. */
+  Queue<NetMessage*> m_mainQueue;
+
+  /** the @a QueryWorker instances. */
+  list<QueryWorker*> m_queryWorkers;
+
   /** the path for HTML files served by the HTTP port. */
   string m_htmlPath;
 
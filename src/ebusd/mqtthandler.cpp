@@ -21,6 +21,7 @@
 #endif
 
 #include "ebusd/mqtthandler.h"
+#include <poll.h>
 #include <csignal>
 #include <deque>
 #include "lib/utils/log.h"
@@ -46,6 +47,13 @@ using std::dec;
 #define O_KEYF (O_CERT+1)
 #define O_KEPA (O_KEYF+1)
 #define O_INSE (O_KEPA+1)
+#define O_COAL (O_INSE+1)
+#define O_RATE (O_COAL+1)
+#define O_BTCH (O_RATE+1)
+#define O_DEDU (O_BTCH+1)
+
+/** the default time in milliseconds for collecting message updates to publish in a batch. */
+#define DEFAULT_BATCH_MILLIS 1000
 
 /** the definition of the MQTT arguments. */
 static const struct argp_option g_mqtt_argp_options[] = {
@@ -69,6 +77,15 @@ static const struct argp_option g_mqtt_argp_options[] = {
   {"mqttignoreinvalid", O_IGIN, nullptr, 0,
    "Ignore invalid parameters during init (e.g. for DNS not resolvable yet)", 0 },
   {"mqttchanges",  O_CHGS, nullptr,       0, "Whether to only publish changed messages instead of all received", 0 },
+  {"mqttcoalesce", O_COAL, "MSEC",        0, "Combine updates of the same topic within MSEC milliseconds into a single "
+   "publish [0]", 0 },
+  {"mqttmaxrate",  O_RATE, "COUNT",       0, "Publish at most COUNT message updates per second, 0 for no limit [0]",
+   0 },
+  {"mqttbatch",    O_BTCH, "MODE",        0, "Publish the message updates collected within the mqttcoalesce time "
+   "(or 1 second) as single JSON document per \"circuit\" or for \"all\" circuits instead of separately (not "
+   "together with %field in mqtttopic)", 0 },
+  {"mqttdedup",    O_DEDU, nullptr,       0, "Skip publishing data identical to the last one published for the topic",
+   0 },
 
 #if (LIBMOSQUITTO_MAJOR >= 1)
   {"mqttca",       O_CAFI, "CA",          0, "Use CA file or dir (ending with '/') for MQTT TLS (no default)", 0 },
@@ -100,6 +117,10 @@ static int g_version = MQTT_PROTOCOL_V31;  //!< protocol version to use
 #endif
 static bool g_ignoreInvalidParams = false;  //!< ignore invalid parameters during init
 static bool g_onlyChanges = false;        //!< whether to only publish changed messages instead of all received
+static unsigned int g_coalesceMillis = 0;  //!< the time in milliseconds for combining updates of the same topic
+static unsigned int g_maxRate = 0;        //!< the maximum number of message updates to publish per second, or 0
+static BatchMode g_batchMode = BM_NONE;   //!< the mode for publishing message updates in batches
+static bool g_dedup = false;              //!< whether to skip data identical to the last one published for the topic
 
 #if (LIBMOSQUITTO_MAJOR >= 1)
 static const char* g_cafile = nullptr;    //!< CA file for TLS
@@ -112,6 +133,19 @@ static bool g_insecure = false;           //!< whether to allow insecure TLS con
 
 bool parseTopic(const string& topic, vector<string>* strs, vector<string>* fields);
 
+/**
+ * Return whether the MQTT topic contains the field name.
+ * @return whether the MQTT topic contains the field name.
+ */
+static bool hasFieldTopic() {
+  for (const auto& field : g_topicFields) {
+    if (field == "field") {
+      return true;
+    }
+  }
+  return false;
+}
+
 static char* replaceSecret(char *arg) {
   char* ret = strdup(arg);
   int cnt = 0;
@@ -179,6 +213,10 @@ static error_t mqtt_parse_opt(int key, char *arg, struct argp_state *state) {
     if (!parseTopic(arg, &g_topicStrs, &g_topicFields)) {
       argp_error(state, "malformed mqtttopic");
     }
+    if (g_batchMode != BM_NONE && hasFieldTopic()) {
+      argp_error(state, "mqtttopic with %%field not supported by mqttbatch");
+      return EINVAL;
+    }
     break;
 
   case O_RETA:  // --mqttretain
@@ -213,6 +251,38 @@ static error_t mqtt_parse_opt(int key, char *arg, struct argp_state *state) {
     g_onlyChanges = true;
     break;
 
+  case O_COAL:  // --mqttcoalesce=500
+    g_coalesceMillis = parseInt(arg, 10, 0, 60000, &result);
+    if (result != RESULT_OK) {
+      argp_error(state, "invalid mqttcoalesce");
+      return EINVAL;
+    }
+    break;
+
+  case O_RATE:  // --mqttmaxrate=50
+    g_maxRate = parseInt(arg, 10, 0, 100000, &result);
+    if (result != RESULT_OK) {
+      argp_error(state, "invalid mqttmaxrate");
+      return EINVAL;
+    }
+    break;
+
+  case O_BTCH:  // --mqttbatch=circuit
+    if (arg == nullptr || (strcmp(arg, "circuit") != 0 && strcmp(arg, "all") != 0)) {
+      argp_error(state, "invalid mqttbatch");
+      return EINVAL;
+    }
+    if (hasFieldTopic()) {
+      argp_error(state, "mqttbatch not supported with %%field in mqtttopic");
+      return EINVAL;
+    }
+    g_batchMode = strcmp(arg, "all") == 0 ? BM_ALL : BM_CIRCUIT;
+    break;
+
+  case O_DEDU:
+    g_dedup = true;
+    break;
+
 #if (LIBMOSQUITTO_MAJOR >= 1)
     case O_CAFI:  // --mqttca=file or --mqttca=dir/
       if (arg == nullptr || arg[0] == 0) {
@@ -440,8 +510,10 @@ void on_message(
 
 
 MqttHandler::MqttHandler(UserInfo* userInfo, BusHandler* busHandler, MessageMap* messages)
-  : DataSink(userInfo, "mqtt"), DataSource(busHandler), WaitThread(), m_messages(messages), m_connected(false),
-    m_initialConnectFailed(false), m_lastUpdateCheckResult("."), m_lastScanStatus("."), m_lastErrorLogTime(0) {
+  : DataSink(userInfo, "mqtt"), DataSource(busHandler), WaitThread(), m_messages(messages),
+    m_definitionVersion(0), m_connected(false),
+    m_initialConnectFailed(false), m_lastUpdateCheckResult("."), m_lastScanStatus("."), m_lastErrorLogTime(0),
+    m_updatesPending(true), m_updateSequence(0), m_queue(g_coalesceMillis, g_maxRate, g_dedup), m_batchDue(0) {
   m_publishByField = false;
   m_mosquitto = nullptr;
   if (g_topicFields.empty()) {
@@ -457,15 +529,11 @@ MqttHandler::MqttHandler(UserInfo* userInfo, BusHandler* busHandler, MessageMap*
     g_topicStrs.push_back("/");
     g_topicFields.push_back("name");
   } else {
-    for (size_t i = 0; i < g_topicFields.size(); i++) {
-      if (g_topicFields[i] == "field") {
-        m_publishByField = true;
-        break;
-      }
-    }
+    m_publishByField = hasFieldTopic();
   }
   m_globalTopic = getTopic(nullptr, "global/");
   m_subscribeTopic = getTopic(nullptr, "#");
+  m_batchTopicPrefix = getTopic(nullptr);
   if (check(mosquitto_lib_init(), "unable to initialize")) {
     signal(SIGPIPE, SIG_IGN);  // needed before libmosquitto v. 1.1.3
     ostringstream clientId;
@@ -550,6 +618,7 @@ MqttHandler::MqttHandler(UserInfo* userInfo, BusHandler* busHandler, MessageMap*
 }
 
 MqttHandler::~MqttHandler() {
+  m_messages->removeUpdateListener(this);
   join();
   if (m_mosquitto) {
     mosquitto_destroy(m_mosquitto);
@@ -560,11 +629,19 @@ MqttHandler::~MqttHandler() {
 
 void MqttHandler::start() {
   if (m_mosquitto) {
+    m_messages->addUpdateListener(this);
     WaitThread::start("MQTT");
   }
 }
 
+void MqttHandler::notifyMessageUpdate(bool changed) {
+  if ((changed || !g_onlyChanges) && !m_updatesPending.exchange(true)) {
+    m_notify.notify();  // wake up the thread once for all updates until handled
+  }
+}
+
 void MqttHandler::notifyConnected() {
+  m_queue.clearTaken();  // the retained or last seen data of the broker is unknown after reconnect
   if (m_mosquitto && isRunning()) {
     const string sep = (g_publishFormat & OF_JSON) ? "\"" : "";
     publishTopic(m_globalTopic+"version", sep + (PACKAGE_STRING "." REVISION) + sep, true);
@@ -574,6 +651,17 @@ void MqttHandler::notifyConnected() {
 }
 
 void MqttHandler::notifyTopic(const string& topic, const string& data) {
+  // the looked up Message is used while waiting for the bus, so keep it alive when replaced by a reload meanwhile
+  uint64_t hold = m_messages->holdDefinitions();
+  uint64_t version = m_messages->getDefinitionVersion();
+  handleTopic(topic, data);
+  if (m_messages->getDefinitionVersion() != version) {
+    m_messageTopics.clear();  // might refer to replaced instances to be freed after releasing them
+  }
+  m_messages->releaseDefinitions(hold);
+}
+
+void MqttHandler::handleTopic(const string& topic, const string& data) {
   size_t pos = topic.rfind('/');
   if (pos == string::npos) {
     return;
@@ -589,104 +677,128 @@ void MqttHandler::notifyTopic(const string& topic, const string& data) {
   }
 
   logOtherDebug("mqtt", "received topic %s with data %s", topic.c_str(), data.c_str());
-  string remain = topic.substr(0, pos);
-  size_t last = 0;
-  string circuit, name;
-  bool finalField = false;
-  for (size_t idx = 0; idx < g_topicStrs.size()+1 && !finalField; idx++) {
-    string field;
-    string chk;
-    if (idx < g_topicStrs.size()) {
-      chk = g_topicStrs[idx];
-      pos = remain.find(chk, last);
-      if (pos == string::npos) {
-        if (!isList) {
-          return;
-        }
-        if (idx == 0 && remain+"/" == chk) {  // check for only first prefix, e.g. "ebusd/"
-          break;
-        }
-        pos = remain.size();
-        finalField = true;
+  Message* message = nullptr;
+  const mqttRoute_t* route = nullptr;
+  string routeTopic = topic;  // circuit and name are matched case-insensitively
+  FileReader::tolower(&routeTopic);
+  if (!isList) {
+    m_messages->lockShared();
+    checkDefinitionVersion();
+    const auto it = m_routes.find(routeTopic);
+    if (it != m_routes.end()) {
+      route = &it->second;
+      message = MessageMap::findAvailable(route->active, m_levels);
+      if (message == nullptr) {
+        message = MessageMap::findAvailable(route->passive, m_levels);
       }
-    } else if (idx-1 < g_topicFields.size()) {
-      pos = remain.size();
-    } else if (last < remain.size()) {
-      if (!isList) {
-        return;
-      }
-      break;
-    } else {
-      break;
     }
-    field = remain.substr(last, pos-last);
-    last = pos+chk.size();
-    if (idx == 0) {
-      if (pos > 0) {
-        return;
-      }
-    } else {
-      if (field.empty()) {
+    m_messages->unlockShared();
+  }
+  if (!route) {
+    string remain = topic.substr(0, pos);
+    size_t last = 0;
+    string circuit, name;
+    bool finalField = false;
+    for (size_t idx = 0; idx < g_topicStrs.size()+1 && !finalField; idx++) {
+      string field;
+      string chk;
+      if (idx < g_topicStrs.size()) {
+        chk = g_topicStrs[idx];
+        pos = remain.find(chk, last);
+        if (pos == string::npos) {
+          if (!isList) {
+            return;
+          }
+          if (idx == 0 && remain+"/" == chk) {  // check for only first prefix, e.g. "ebusd/"
+            break;
+          }
+          pos = remain.size();
+          finalField = true;
+        }
+      } else if (idx-1 < g_topicFields.size()) {
+        pos = remain.size();
+      } else if (last < remain.size()) {
         if (!isList) {
           return;
         }
-        continue;
+        break;
+      } else {
+        break;
       }
-      string fieldName = g_topicFields[idx-1];
-      if (fieldName == "circuit") {
-        circuit = field;
-      } else if (fieldName == "name") {
-        name = field;
-      } else if (fieldName == "field") {
-        // field = field;  // TODO add support for writing a single field
+      field = remain.substr(last, pos-last);
+      last = pos+chk.size();
+      if (idx == 0) {
+        if (pos > 0) {
+          return;
+        }
       } else {
-        return;
+        if (field.empty()) {
+          if (!isList) {
+            return;
+          }
+          continue;
+        }
+        string fieldName = g_topicFields[idx-1];
+        if (fieldName == "circuit") {
+          circuit = field;
+        } else if (fieldName == "name") {
+          name = field;
+        } else if (fieldName == "field") {
+          // field = field;  // TODO add support for writing a single field
+        } else {
+          return;
+        }
       }
     }
-  }
-  if (isList) {
-    logOtherInfo("mqtt", "received list topic for %s %s", circuit.c_str(), name.c_str());
-    deque<Message*> messages;
-    bool circuitPrefix = circuit.length() > 0 && circuit.find_last_of('*') == circuit.length()-1;
-    if (circuitPrefix) {
-      circuit = circuit.substr(0, circuit.length()-1);
-    }
-    bool namePrefix = name.length() > 0 && name.find_last_of('*') == name.length()-1;
-    if (namePrefix) {
-      name = name.substr(0, name.length()-1);
-    }
-    m_messages->findAll(circuit, name, m_levels, !(circuitPrefix || namePrefix), true, true,
-                        true, true, true, 0, 0, false, &messages);
-    bool onlyWithData = !data.empty();
-    for (const auto message : messages) {
-      if ((circuitPrefix && (
-          message->getCircuit().substr(0, circuit.length()) != circuit
-          || (!namePrefix && name.length() > 0 && message->getName() != name)))
-      || (namePrefix && (
-          message->getName().substr(0, name.length()) != name
-          || (!circuitPrefix && circuit.length() > 0 && message->getCircuit() != circuit)))
-      ) {
-        continue;
+    if (isList) {
+      logOtherInfo("mqtt", "received list topic for %s %s", circuit.c_str(), name.c_str());
+      deque<Message*> messages;
+      bool circuitPrefix = circuit.length() > 0 && circuit.find_last_of('*') == circuit.length()-1;
+      if (circuitPrefix) {
+        circuit = circuit.substr(0, circuit.length()-1);
+      }
+      bool namePrefix = name.length() > 0 && name.find_last_of('*') == name.length()-1;
+      if (namePrefix) {
+        name = name.substr(0, name.length()-1);
       }
-      time_t lastup = message->getLastUpdateTime();
-      if (onlyWithData && lastup == 0) {
-        continue;
+      m_messages->findAll(circuit, name, m_levels, !(circuitPrefix || namePrefix), true, true,
+                          true, true, true, 0, 0, false, &messages);
+      bool onlyWithData = !data.empty();
+      OutputBuffer updates;
+      for (const auto message : messages) {
+        if ((circuitPrefix && (
+            message->getCircuit().substr(0, circuit.length()) != circuit
+            || (!namePrefix && name.length() > 0 && message->getName() != name)))
+        || (namePrefix && (
+            message->getName().substr(0, name.length()) != name
+            || (!circuitPrefix && circuit.length() > 0 && message->getCircuit() != circuit)))
+        ) {
+          continue;
+        }
+        time_t lastup = message->getLastUpdateTime();
+        if (onlyWithData && lastup == 0) {
+          continue;
+        }
+        updates.reset();
+        publishMessage(message, &updates, true);
       }
-      ostringstream ostream;
-      publishMessage(message, &ostream, true);
+      return;
+    }
+    if (name.empty()) {
+      return;
+    }
+    route = addRoute(routeTopic, circuit, name, isWrite, &message);
+    if (!route) {
+      logOtherInfo("mqtt", "received %s topic for %s %s", direction.c_str(), circuit.c_str(), name.c_str());
+      logOtherError("mqtt", "%s message %s %s not found", isWrite?"write":"read", circuit.c_str(), name.c_str());
+      return;
     }
-    return;
-  }
-  if (name.empty()) {
-    return;
-  }
-  logOtherInfo("mqtt", "received %s topic for %s %s", direction.c_str(), circuit.c_str(), name.c_str());
-  Message* message = m_messages->find(circuit, name, m_levels, isWrite);
-  if (message == nullptr) {
-    message = m_messages->find(circuit, name, m_levels, isWrite, true);
   }
+  logOtherInfo("mqtt", "received %s topic for %s %s", direction.c_str(), route->circuit.c_str(),
+      route->name.c_str());
   if (message == nullptr) {
-    logOtherError("mqtt", "%s message %s %s not found", isWrite?"write":"read", circuit.c_str(), name.c_str());
+    logOtherError("mqtt", "%s message %s %s not found", isWrite?"write":"read", route->circuit.c_str(),
+        route->name.c_str());
     return;
   }
   if (!message->isPassive()) {
@@ -710,14 +822,38 @@ void MqttHandler::notifyTopic(const string& topic, const string& data) {
     }
     result_t result = m_busHandler->readFromBus(message, useData);
     if (result != RESULT_OK) {
-      logOtherError("mqtt", "%s %s %s: %s", isWrite?"write":"read", circuit.c_str(), name.c_str(),
+      logOtherError("mqtt", "%s %s %s: %s", isWrite?"write":"read", route->circuit.c_str(), route->name.c_str(),
           getResultCode(result));
       return;
     }
-    logOtherNotice("mqtt", "%s %s %s: %s", isWrite?"write":"read", circuit.c_str(), name.c_str(), data.c_str());
+    logOtherNotice("mqtt", "%s %s %s: %s", isWrite?"write":"read", route->circuit.c_str(), route->name.c_str(),
+        data.c_str());
+  }
+  OutputBuffer updates;
+  publishMessage(message, &updates);
+}
+
+const mqttRoute_t* MqttHandler::addRoute(const string& topic, const string& circuit, const string& name,
+    bool isWrite, Message** message) {
+  m_messages->lockShared();
+  checkDefinitionVersion();
+  const vector<Message*>* active = m_messages->findCandidates(circuit, name, isWrite);
+  const vector<Message*>* passive = m_messages->findCandidates(circuit, name, isWrite, true);
+  const mqttRoute_t* route = nullptr;
+  if (active || passive) {  // unknown topics are not kept
+    mqttRoute_t& added = m_routes[topic];
+    added.circuit = circuit;
+    added.name = name;
+    added.active = active;
+    added.passive = passive;
+    route = &added;
+    *message = MessageMap::findAvailable(active, m_levels);
+    if (*message == nullptr) {
+      *message = MessageMap::findAvailable(passive, m_levels);
+    }
   }
-  ostringstream ostream;
-  publishMessage(message, &ostream);
+  m_messages->unlockShared();
+  return route;
 }
 
 void MqttHandler::notifyUpdateCheckResult(const string& checkResult) {
@@ -725,6 +861,7 @@ void MqttHandler::notifyUpdateCheckResult(const string& checkResult) {
     m_lastUpdateCheckResult = checkResult;
     const string sep = (g_publishFormat & OF_JSON) ? "\"" : "";
     publishTopic(m_globalTopic+"updatecheck", sep + (checkResult.empty() ? "OK" : checkResult) + sep, true);
+    m_notify.notify();  // let the thread send the queued publish
   }
 }
 
@@ -733,6 +870,7 @@ void MqttHandler::notifyScanStatus(const string& scanStatus) {
     m_lastScanStatus = scanStatus;
     const string sep = (g_publishFormat & OF_JSON) ? "\"" : "";
     publishTopic(m_globalTopic+"scan", sep + (scanStatus.empty() ? "OK" : scanStatus) + sep, true);
+    m_notify.notify();  // let the thread send the queued publish
   }
 }
 
@@ -741,14 +879,23 @@ void MqttHandler::run() {
   bool signal = false;
   string signalTopic = m_globalTopic+"signal";
   string uptimeTopic = m_globalTopic+"uptime";
-  ostringstream updates;
+  OutputBuffer updates;
+  deque<Message*> messages;
 
   time(&now);
   start = lastTaskRun = now;
   bool allowReconnect = false;
   while (isRunning()) {
     bool wasConnected = m_connected;
-    bool needsWait = handleTraffic(allowReconnect);
+    int timeout = -1;
+    if (m_connected) {
+      timeout = flushQueuedTopics();
+      int batchTimeout = flushBatch(&updates);
+      if (batchTimeout >= 0 && (timeout < 0 || batchTimeout < timeout)) {
+        timeout = batchTimeout;
+      }
+    }
+    bool needsWait = handleTraffic(allowReconnect, timeout < 0 || timeout > 1000 ? 1000 : timeout);
     bool reconnected = !wasConnected && m_connected;
     allowReconnect = false;
     time(&now);
@@ -763,9 +910,8 @@ void MqttHandler::run() {
       allowReconnect = true;
       sendSignal = true;
       time_t uptime = now-start;
-      updates.str("");
-      updates.clear();
-      updates << dec << static_cast<unsigned>(uptime);
+      updates.reset();
+      OutputBuffer::appendUnsigned(static_cast<unsigned>(uptime), &updates);
       publishTopic(uptimeTopic, updates.str());
       time(&lastTaskRun);
     }
@@ -783,29 +929,40 @@ void MqttHandler::run() {
         }
       }
     }
-    if (!m_updatedMessages.empty()) {
-      m_messages->lock();
-      if (m_connected) {
-        for (auto it = m_updatedMessages.begin(); it != m_updatedMessages.end(); ) {
-          const vector<Message*>* messages = m_messages->getByKey(it->first);
-          if (messages) {
-            for (auto message : *messages) {
-              if (message->getLastChangeTime() > 0 && message->isAvailable()
-              && (!g_onlyChanges || message->getLastChangeTime() > lastUpdates)) {
-                updates.str("");
-                updates.clear();
-                updates << dec;
-                publishMessage(message, &updates);
-              }
+    if (m_updatesPending.exchange(false)) {
+      // only collect the updated messages under the lock and keep them alive while decoding and publishing
+      uint64_t hold = m_messages->holdDefinitions();
+      uint64_t version = m_messages->getDefinitionVersion();
+      bool connected = m_connected;
+      messages.clear();
+      m_messages->lockShared();
+      if (connected) {
+        if (!m_messages->findUpdates(m_levels, g_onlyChanges, &m_updateSequence, &messages)) {
+          // journal overrun: fall back to checking the update time of all messages
+          m_messages->findAll("", "", m_levels, false, true, true, true, true, true, lastUpdates, 0, g_onlyChanges,
+              &messages);
+        }
+      } else {
+        m_updateSequence = m_messages->getUpdateSequence();  // skip the updates while not connected
+      }
+      m_messages->unlockShared();
+      if (connected) {
+        if (g_batchMode != BM_NONE) {
+          collectBatch(messages, &updates);
+        } else {
+          for (const auto message : messages) {
+            if (message->getLastChangeTime() > 0) {
+              updates.reset();
+              publishMessage(message, &updates);
             }
           }
-          it = m_updatedMessages.erase(it);
         }
         time(&lastUpdates);
-      } else {
-        m_updatedMessages.clear();
       }
-      m_messages->unlock();
+      if (m_messages->getDefinitionVersion() != version) {
+        m_messageTopics.clear();  // might refer to replaced instances to be freed after releasing them
+      }
+      m_messages->releaseDefinitions(hold);
     }
     if ((!m_connected && !Wait(5)) || (needsWait && !Wait(1))) {
       break;
@@ -815,13 +972,47 @@ void MqttHandler::run() {
   publishTopic(m_globalTopic+"scan", "", true);  // clear retain of scan status
 }
 
-bool MqttHandler::handleTraffic(bool allowReconnect) {
+bool MqttHandler::handleTraffic(bool allowReconnect, int timeout) {
   if (!m_mosquitto) {
     return false;
   }
   int ret;
 #if (LIBMOSQUITTO_MAJOR >= 1)
-  ret = mosquitto_loop(m_mosquitto, -1, 1);  // waits up to 1 second for network traffic
+  // wait for network traffic or a message update
+  struct pollfd fds[2];
+  memset(fds, 0, sizeof(fds));
+  fds[0].fd = m_notify.notifyFD();
+  fds[0].events = POLLIN;
+  nfds_t nfds = 1;
+  int sock = mosquitto_socket(m_mosquitto);
+  if (sock >= 0) {
+    fds[1].fd = sock;
+    fds[1].events = static_cast<short>(POLLIN | (mosquitto_want_write(m_mosquitto) ? POLLOUT : 0));
+    nfds++;
+  }
+  ret = poll(fds, nfds, timeout);
+  if (ret > 0 && (fds[0].revents & POLLIN)) {
+    char buf[64];
+    if (read(fds[0].fd, buf, sizeof(buf)) < 0) {
+      // ignore, update handling is triggered by the flag only
+    }
+  }
+  if (sock < 0) {
+    ret = MOSQ_ERR_NO_CONN;
+  } else if (ret < 0) {
+    ret = MOSQ_ERR_ERRNO;
+  } else {
+    ret = MOSQ_ERR_SUCCESS;
+    if (fds[1].revents & (POLLIN | POLLERR | POLLHUP)) {
+      ret = mosquitto_loop_read(m_mosquitto, 1);
+    }
+    if (ret == MOSQ_ERR_SUCCESS && (fds[1].revents & POLLOUT)) {
+      ret = mosquitto_loop_write(m_mosquitto, 1);
+    }
+    if (ret == MOSQ_ERR_SUCCESS) {
+      ret = mosquitto_loop_misc(m_mosquitto);
+    }
+  }
 #else
   ret = mosquitto_loop(m_mosquitto, -1);  // waits up to 1 second for network traffic
 #endif
@@ -885,17 +1076,45 @@ string MqttHandler::getTopic(const Message* message, const string& suffix, const
   return ret.str();
 }
 
-void MqttHandler::publishMessage(const Message* message, ostringstream* updates, bool includeWithoutData) {
+void MqttHandler::checkDefinitionVersion() {
+  uint64_t version = m_messages->getDefinitionVersion();
+  if (version != m_definitionVersion) {
+    // instances might have been replaced
+    m_messageTopics.clear();
+    m_routes.clear();
+    m_definitionVersion = version;
+  }
+}
+
+const vector<string>& MqttHandler::getMessageTopics(const Message* message) {
+  checkDefinitionVersion();
+  const auto it = m_messageTopics.find(message);
+  if (it != m_messageTopics.end()) {
+    return it->second;
+  }
+  vector<string>& topics = m_messageTopics[message];
+  if (m_publishByField) {
+    for (size_t index = 0; index < message->getFieldCount(); index++) {
+      topics.push_back(getTopic(message, "", message->getFieldName(index)));
+    }
+  } else {
+    topics.push_back(getTopic(message));
+  }
+  return topics;
+}
+
+void MqttHandler::publishMessage(const Message* message, OutputBuffer* updates, bool includeWithoutData) {
   OutputFormat outputFormat = g_publishFormat;
   bool json = outputFormat & OF_JSON;
   bool noData = includeWithoutData && message->getLastUpdateTime() == 0;
+  const vector<string>& topics = getMessageTopics(message);
   if (!m_publishByField) {
     if (noData) {
-      publishEmptyTopic(getTopic(message));  // alternatively: , json ? "null" : "");
+      publishEmptyTopic(topics[0]);  // alternatively: , json ? "null" : "");
       return;
     }
     if (json) {
-      *updates << "{";
+      OutputBuffer::append('{', updates);
     }
     result_t result = message->decodeLastData(false, nullptr, -1, outputFormat, updates);
     if (result != RESULT_OK) {
@@ -904,30 +1123,94 @@ void MqttHandler::publishMessage(const Message* message, ostringstream* updates,
       return;
     }
     if (json) {
-      *updates << "}";
+      OutputBuffer::append('}', updates);
     }
-    publishTopic(getTopic(message), updates->str());
+    queueTopic(topics[0], updates->str());
     return;
   }
   if (json) {
     outputFormat |= OF_SHORT;
   }
-  for (size_t index = 0; index < message->getFieldCount(); index++) {
-    string name = message->getFieldName(index);
+  for (size_t index = 0; index < topics.size(); index++) {
     if (noData) {
-      publishEmptyTopic(getTopic(message, "", name));  // alternatively: , json ? "null" : "");
+      publishEmptyTopic(topics[index]);  // alternatively: , json ? "null" : "");
       continue;
     }
-    result_t result = message->decodeLastData(false, nullptr, index, outputFormat, updates);
+    result_t result = message->decodeLastData(false, nullptr, static_cast<ssize_t>(index), outputFormat, updates);
     if (result != RESULT_OK) {
       logOtherError("mqtt", "decode %s %s %s: %s", message->getCircuit().c_str(), message->getName().c_str(),
-          name.c_str(), getResultCode(result));
+          message->getFieldName(index).c_str(), getResultCode(result));
       return;
     }
-    publishTopic(getTopic(message, "", name), updates->str());
-    updates->str("");
-    updates->clear();
+    queueTopic(topics[index], updates->str());
+    updates->reset();
+  }
+}
+
+/**
+ * Get the current time in milliseconds.
+ * @return the current time in milliseconds.
+ */
+static uint64_t getMillis() {
+  struct timespec t;
+  clockGettime(&t);
+  return static_cast<uint64_t>(t.tv_sec) * 1000 + static_cast<uint64_t>(t.tv_nsec / 1000000);
+}
+
+void MqttHandler::queueTopic(const string& topic, const string& data) {
+  if (m_queue.add(topic, data, getMillis())) {
+    publishTopic(topic, data);
+  }
+}
+
+void MqttHandler::collectBatch(const deque<Message*>& messages, OutputBuffer* updates) {
+  bool wasEmpty = m_batch.empty();
+  for (const auto message : messages) {
+    if (message->getLastChangeTime() == 0) {
+      continue;
+    }
+    result_t result = m_batch.add(message, g_publishFormat, updates);
+    if (result != RESULT_OK) {
+      logOtherError("mqtt", "decode %s %s: %s", message->getCircuit().c_str(), message->getName().c_str(),
+          getResultCode(result));
+    }
+  }
+  if (wasEmpty && !m_batch.empty()) {
+    m_batchDue = getMillis() + (g_coalesceMillis > 0 ? g_coalesceMillis : DEFAULT_BATCH_MILLIS);
+  }
+}
+
+int MqttHandler::flushBatch(OutputBuffer* updates) {
+  if (m_batch.empty()) {
+    return -1;
+  }
+  uint64_t now = getMillis();
+  if (m_batchDue > now) {
+    return static_cast<int>(m_batchDue - now);
+  }
+  vector<pair<string, string>> documents;
+  m_batch.build(g_batchMode == BM_CIRCUIT, updates, &documents);
+  for (const auto& document : documents) {
+    if (!document.first.empty()) {
+      publishTopic(m_batchTopicPrefix+document.first, document.second);
+      continue;
+    }
+    string topic = m_batchTopicPrefix;
+    if (topic.length() > 1 && topic[topic.length()-1] == '/') {
+      topic.resize(topic.length()-1);
+    }
+    publishTopic(topic.empty() ? PACKAGE : topic, document.second);
+  }
+  return -1;
+}
+
+int MqttHandler::flushQueuedTopics() {
+  vector<pair<string, string>> updates;
+  int timeout = m_queue.take(getMillis(), &updates);
+  for (const auto& update : updates) {
+    publishTopic(update.first, update.second);
   }
+  return timeout;
 }
 
 void MqttHandler::publishTopic(const string& topic, const string& data, bool retain) {
@@ -20,6 +20,8 @@
 #define EBUSD_MQTTHANDLER_H_
 
 #include <mosquitto.h>
+#include <atomic>
+#include <deque>
 #include <map>
 #include <string>
 #include <list>
@@ -27,6 +29,9 @@
 #include "ebusd/datahandler.h"
 #include "ebusd/bushandler.h"
 #include "lib/ebus/message.h"
+#include "lib/ebus/outputbuffer.h"
+#include "lib/utils/notify.h"
+#include "lib/utils/clock.h"
 
 namespace ebusd {
 
@@ -34,10 +39,31 @@ namespace ebusd {
  * A data handler enabling MQTT support via mosquitto.
  */
 
+using std::deque;
 using std::map;
+using std::pair;
 using std::string;
 using std::vector;
 
+/** the mode for publishing message updates in batches. */
+enum BatchMode {
+  BM_NONE,     //!< publish each message separately
+  BM_CIRCUIT,  //!< publish one JSON document per circuit
+  BM_ALL,      //!< publish one JSON document for all circuits
+};
+
+/** the @a Message instances an inbound get or set topic is routed to (see @a MqttHandler::notifyTopic()). */
+typedef struct mqttRoute {
+  /** the circuit name extracted from the topic. */
+  string circuit;
+  /** the message name extracted from the topic. */
+  string name;
+  /** the active @a Message candidates (see @a MessageMap::findCandidates()), or nullptr. */
+  const vector<Message*>* active;
+  /** the passive @a Message candidates (see @a MessageMap::findCandidates()), or nullptr. */
+  const vector<Message*>* passive;
+} mqttRoute_t;
+
 /**
  * Helper function for getting the argp definition for MQTT.
  * @return a pointer to the argp_child structure.
@@ -58,7 +84,7 @@ bool mqtthandler_register(UserInfo* userInfo, BusHandler* busHandler, MessageMap
 /**
  * The main class supporting MQTT data handling.
  */
-class MqttHandler : public DataSink, public DataSource, public WaitThread {
+class MqttHandler : public DataSink, public DataSource, public WaitThread, public MessageUpdateListener {
  public:
   /**
    * Constructor.
@@ -88,6 +114,16 @@ class MqttHandler : public DataSink, public DataSource, public WaitThread {
    */
   void notifyTopic(const string& topic, const string& data);
 
+  /**
+   * Notify the sink of an updated @a Message (ignored as the updates are taken from the @a MessageMap journal
+   * directly when signalled via @a notifyMessageUpdate()).
+   * @param message the updated @a Message.
+   */
+  void notifyUpdate(Message* message) override {}
+
+  // @copydoc
+  void notifyMessageUpdate(bool changed) override;
+
   // @copydoc
   void notifyUpdateCheckResult(const string& checkResult) override;
 
@@ -101,11 +137,12 @@ class MqttHandler : public DataSink, public DataSource, public WaitThread {
 
  private:
   /**
-   * Called regularly to handle MQTT traffic.
+   * Called regularly to handle MQTT traffic, waiting up to 1 second for network traffic or a @a Message update.
    * @param allowReconnect true when reconnecting to the broker is allowed.
+   * @param timeout the maximum time in milliseconds to wait.
    * @return true on error for waiting a bit until next call, or false otherwise.
    */
-  bool handleTraffic(bool allowReconnect);
+  bool handleTraffic(bool allowReconnect, int timeout);
 
   /**
    * Build the MQTT topic string for the @a Message.
@@ -116,13 +153,71 @@ class MqttHandler : public DataSink, public DataSource, public WaitThread {
    */
   string getTopic(const Message* message, const string& suffix = "", const string& fieldName = "");
 
+  /**
+   * Handle a received MQTT message while the definitions are held.
+   * @param topic the topic string.
+   * @param data the data string.
+   */
+  void handleTopic(const string& topic, const string& data);
+
+  /**
+   * Resolve the @a Message candidates for an inbound get or set topic and keep them as route for the topic.
+   * @param topic the lowercase topic string.
+   * @param circuit the circuit name extracted from the topic.
+   * @param name the message name extracted from the topic.
+   * @param isWrite whether this is a set topic.
+   * @param message pointer to the variable in which to store the available @a Message, or nullptr if none.
+   * @return the added @a mqttRoute_t, or nullptr if the topic does not match any @a Message.
+   */
+  const mqttRoute_t* addRoute(const string& topic, const string& circuit, const string& name, bool isWrite,
+      Message** message);
+
+  /**
+   * Drop the built topic strings and inbound routes when the @a MessageMap definitions changed.
+   */
+  void checkDefinitionVersion();
+
+  /**
+   * Get the MQTT topic strings for the @a Message, built once per version of the definitions.
+   * @param message the @a Message to get the topic strings for.
+   * @return the topic string of each field when publishing by field, or the single topic string of the @a Message.
+   */
+  const vector<string>& getMessageTopics(const Message* message);
+
   /**
    * Prepare a @a Message and publish as topic.
    * @param message the @a Message to publish.
-   * @param updates the @a ostringstream for preparation.
+   * @param updates the empty @a OutputBuffer for preparation.
    * @param includeWithoutData whether to publish messages without data as well.
    */
-  void publishMessage(const Message* message, ostringstream* updates, bool includeWithoutData = false);
+  void publishMessage(const Message* message, OutputBuffer* updates, bool includeWithoutData = false);
+
+  /**
+   * Collect the data of the updated @a Message instances for publishing them in a batch after the batch interval.
+   * @param messages the updated @a Message instances.
+   * @param updates the @a OutputBuffer for preparation.
+   */
+  void collectBatch(const deque<Message*>& messages, OutputBuffer* updates);
+
+  /**
+   * Publish the collected batch as JSON document per circuit or for all circuits when the batch interval elapsed.
+   * @param updates the @a OutputBuffer for preparation.
+   * @return the time in milliseconds until the batch is due, or -1 if nothing is collected.
+   */
+  int flushBatch(OutputBuffer* updates);
+
+  /**
+   * Queue a message topic update for publishing, combining it with a still pending update of the same topic.
+   * @param topic the topic string.
+   * @param data the data string.
+   */
+  void queueTopic(const string& topic, const string& data);
+
+  /**
+   * Publish the queued message topic updates that are due within the publish rate limit.
+   * @return the time in milliseconds until the next queued update is due, or -1 if none is queued.
+   */
+  int flushQueuedTopics();
 
   /**
    * Publish a topic update to MQTT.
@@ -147,9 +242,21 @@ class MqttHandler : public DataSink, public DataSource, public WaitThread {
   /** the topic to subscribe to. */
   string m_subscribeTopic;
 
+  /** the topic prefix for publishing in batches (followed by the circuit name unless publishing all at once). */
+  string m_batchTopicPrefix;
+
   /** whether to publish a separate topic for each message field. */
   bool m_publishByField;
 
+  /** the built topic strings by @a Message (see @a getMessageTopics()). */
+  map<const Message*, vector<string>> m_messageTopics;
+
+  /** the inbound routes by lowercase get or set topic, resolved once per version of the definitions. */
+  map<string, mqttRoute_t> m_routes;
+
+  /** the version of the @a MessageMap definitions @a m_messageTopics and @a m_routes were built for. */
+  uint64_t m_definitionVersion;
+
   /** the mosquitto structure if initialized, or nullptr. */
   struct mosquitto* m_mosquitto;
 
@@ -167,6 +274,24 @@ class MqttHandler : public DataSink, public DataSource, public WaitThread {
 
   /** the last system time when a communication error was logged. */
   time_t m_lastErrorLogTime;
+
+  /** the @a Notify for waking up the thread on a @a Message update. */
+  Notify m_notify;
+
+  /** whether a @a Message update was signalled but not yet handled. */
+  std::atomic<bool> m_updatesPending;
+
+  /** the journal sequence number of the last handled @a Message update. */
+  uint64_t m_updateSequence;
+
+  /** the @a PublishQueue for the message topic updates. */
+  PublishQueue m_queue;
+
+  /** the @a MessageBatch collecting the message updates to publish in batches. */
+  MessageBatch m_batch;
+
+  /** the due time in milliseconds of the collected batch. */
+  uint64_t m_batchDue;
 };
 
 }  // namespace ebusd
@@ -21,9 +21,15 @@
 #endif
 
 #include "ebusd/network.h"
+#ifdef HAVE_EPOLL
+#  include <sys/epoll.h>
+#else
 #ifdef HAVE_PPOLL
 #  include <poll.h>
 #endif
+#endif
+#include <fcntl.h>
+#include <errno.h>
 #include <cstring>
 #include "lib/utils/log.h"
 
@@ -31,34 +37,82 @@ namespace ebusd {
 
 int Connection::m_ids = 0;
 
-#ifndef POLLRDHUP
-#define POLLRDHUP 0
-#endif
+/** watch for readable data. */
+#define WATCH_READ 1
+
+/** watch for writability. */
+#define WATCH_WRITE 2
+
+/** readable data event. */
+#define EVENT_READ 1
+
+/** writability event. */
+#define EVENT_WRITE 2
+
+/** error or hangup event. */
+#define EVENT_ERROR 4
+
+/** the maximum number of events to handle in one round. */
+#define MAX_EVENTS 32
+
+/** the interval in seconds for checking updates of listening clients. */
+#define LISTEN_INTERVAL 2
+
+/** the time in seconds after which an idle HTTP connection is closed. */
+#define HTTP_IDLE_TIMEOUT 15
 
 bool NetMessage::add(const char* request) {
+  if (m_isHttp && m_request.empty() && !m_pendingInput.empty()) {
+    m_request.swap(m_pendingInput);  // continue with pipelined request
+  }
   if (request && request[0]) {
     string add = request;
     add.erase(remove(add.begin(), add.end(), '\r'), add.end());
     m_request.append(add);
   }
+  if (m_isHttp) {
+    size_t pos = m_request.find_first_not_of('\n');
+    if (pos != 0) {
+      m_request.erase(0, pos);  // skip empty lines between requests
+    }
+  }
   size_t pos = m_request.find(m_isHttp ? "\n\n" : "\n");
   if (pos != string::npos) {
     if (m_isHttp) {
+      m_pendingInput = m_request.substr(pos+2);  // keep pipelined requests
+      m_request.resize(pos);
+      string headers;
       pos = m_request.find("\n");
-      m_request.resize(pos);  // reduce to first line
+      if (pos != string::npos) {
+        headers = m_request.substr(pos);
+        transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+        m_request.resize(pos);  // reduce to first line
+      }
       // typical first line: GET /ehp/outsidetemp HTTP/1.1
       pos = m_request.rfind(" HTTP/");
+      m_keepAlive = pos != string::npos && m_request.compare(pos+6, string::npos, "1.0") != 0;
       if (pos != string::npos) {
         m_request.resize(pos);  // remove "HTTP/x.x" suffix
       }
+      pos = headers.find("\nconnection:");
+      if (pos != string::npos) {
+        size_t endPos = headers.find('\n', pos+1);
+        string value = headers.substr(pos+12, endPos == string::npos ? string::npos : endPos-pos-12);
+        if (value.find("close") != string::npos) {
+          m_keepAlive = false;
+        } else if (value.find("keep-alive") != string::npos) {
+          m_keepAlive = true;
+        }
+      }
       pos = 0;
-      while ((pos=m_request.find('%', pos)) != string::npos && pos+2 <= m_request.length()) {
+      while ((pos=m_request.find('%', pos)) != string::npos && pos+2 < m_request.length()) {
         unsigned int value1, value2;
-        if (sscanf("%1x%1x", m_request.c_str()+pos+1, &value1, &value2) < 2) {
+        if (sscanf(m_request.c_str()+pos+1, "%1x%1x", &value1, &value2) < 2) {
           break;
         }
         m_request[pos] = static_cast<char>(((value1&0x0f) << 4) | (value2&0x0f));
         m_request.erase(pos+1, 2);
+        pos++;
       }
     } else if (pos+1 == m_request.length()) {
       m_request.resize(pos);  // reduce to complete lines
@@ -69,128 +123,86 @@ bool NetMessage::add(const char* request) {
 }
 
 
-void Connection::run() {
-  int ret;
-  struct timespec tdiff;
-
-  // set timeout
-  tdiff.tv_sec = 2;
-  tdiff.tv_nsec = 0;
-  int notifyFD = m_notify.notifyFD();
-  int sockFD = m_socket->getFD();
-
-#ifdef HAVE_PPOLL
-  nfds_t nfds = 2;
-  struct pollfd fds[nfds];
-
-  memset(fds, 0, sizeof(fds));
-
-  fds[0].fd = notifyFD;
-  fds[0].events = POLLIN | POLLERR | POLLHUP | POLLRDHUP;
-
-  fds[1].fd = sockFD;
-  fds[1].events = POLLIN | POLLERR | POLLHUP | POLLRDHUP;
-#else
-#ifdef HAVE_PSELECT
-  int maxfd = (notifyFD > sockFD) ? notifyFD : sockFD;
-  fd_set checkfds, exceptfds;
+void Connection::queueRequest() {
+  m_waiting = true;
+  m_netQueue->push(&m_message);
+  logDebug(lf_network, "[%05d] wait for result", getID());
+}
 
-  FD_ZERO(&checkfds);
-  FD_SET(notifyFD, &checkfds);
-  FD_SET(sockFD, &checkfds);
+bool Connection::receive() {
+  char data[256];
+  ssize_t datalen = m_socket->recv(data, sizeof(data)-1);
+  if (datalen < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+    return true;
+  }
+  // remove closed socket
+  if (datalen <= 0) {
+    return false;
+  }
+  data[datalen] = '\0';
+  m_lastActive = time(nullptr);
 
-  FD_ZERO(&exceptfds);
-  FD_SET(notifyFD, &exceptfds);
-  FD_SET(sockFD, &exceptfds);
-#endif
-#endif
+  // decode client data
+  if (m_message.add(data)) {
+    queueRequest();
+  }
+  return true;
+}
 
-  bool closed = false;
-  NetMessage message(m_isHttp);
+bool Connection::checkResult(time_t now) {
+  if (!m_waiting) {
+    return true;
+  }
+  string result;
+  if (!m_message.getResult(&result)) {
+    return true;
+  }
+  m_waiting = false;
+  m_listenAt = now + LISTEN_INTERVAL;
+  if (m_closed) {
+    return false;
+  }
+  m_output.append(result);
+  if (!send()) {
+    return false;
+  }
+  if (m_message.isHttp() && m_message.add(nullptr)) {
+    queueRequest();  // pipelined request
+  }
+  return true;
+}
 
-  while (!closed) {
-#ifdef HAVE_PPOLL
-    // wait for new fd event
-    ret = ppoll(fds, nfds, &tdiff, nullptr);
-#else
-#ifdef HAVE_PSELECT
-    // set readfds to inital checkfds
-    fd_set readfds = checkfds;
-    // wait for new fd event
-    ret = pselect(maxfd + 1, &readfds, nullptr, &exceptfds, &tdiff, nullptr);
-#endif
-#endif
-    bool newData = false;
-    if (ret != 0) {
-#ifdef HAVE_PPOLL
-      // new data from notify
-      if (ret < 0 || (fds[0].revents & (POLLIN | POLLERR | POLLHUP | POLLRDHUP))
-          || (fds[1].revents & (POLLERR | POLLHUP))) {
-        break;
+bool Connection::send() {
+  while (m_outputPos < m_output.length()) {
+    ssize_t sent = m_socket->send(m_output.data()+m_outputPos, m_output.length()-m_outputPos);
+    if (sent < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        return true;
       }
-      // new data from socket
-      newData = fds[1].revents & POLLIN;
-      closed = fds[1].revents & POLLRDHUP;
-#else
-#ifdef HAVE_PSELECT
-      // new data from notify
-      if (ret < 0 || FD_ISSET(notifyFD, &readfds) || FD_ISSET(notifyFD, &exceptfds)) {
-        break;
-      }
-      // new data from socket
-      newData = FD_ISSET(sockFD, &readfds);
-      closed = FD_ISSET(sockFD, &exceptfds);
-#endif
-#endif
+      return false;
     }
+    m_outputPos += sent;
+    m_lastActive = time(nullptr);
+  }
+  m_output.clear();
+  m_outputPos = 0;
+  return !m_message.isDisconnect();
+}
 
-    if (newData || message.isListeningMode()) {
-      char data[256];
-
-      if (!m_socket->isValid()) {
-        break;
-      }
-      if (newData) {
-        ssize_t datalen = m_socket->recv(data, sizeof(data)-1);
-
-        // remove closed socket
-        if (datalen <= 0) {
-          break;
-        }
-        data[datalen] = '\0';
-      } else {
-        data[0] = '\0';
-      }
-
-      // decode client data
-      if (message.add(data)) {
-        m_netQueue->push(&message);
-
-        // wait for result
-        logDebug(lf_network, "[%05d] wait for result", getID());
-        string result;
-        message.getResult(&result);
-
-        if (!m_socket->isValid()) {
-          break;
-        }
-        m_socket->send(result.c_str(), result.size());
-      }
+bool Connection::checkIdle(time_t now) const {
+  return !m_message.isHttp() || m_waiting || now < m_lastActive + HTTP_IDLE_TIMEOUT;
+}
 
-      if (message.isDisconnect() || !m_socket->isValid()) {
-        break;
-      }
-    }
+void Connection::checkListen(time_t now) {
+  if (!m_waiting && !m_closed && !hasOutput() && now >= m_listenAt && m_message.isListeningMode()
+      && m_message.add(nullptr)) {
+    queueRequest();
   }
-
-  delete m_socket;
-  m_socket = nullptr;
-  logInfo(lf_network, "[%05d] connection closed", getID());
 }
 
 
 Network::Network(const bool local, const uint16_t port, const uint16_t httpPort, Queue<NetMessage*>* netQueue)
-  : Thread(), m_netQueue(netQueue), m_listening(false) {
+  : Thread(), m_netQueue(netQueue), m_epollFd(-1), m_listening(false) {
   m_tcpServer = new TCPServer(port, local ? "127.0.0.1" : "0.0.0.0");
 
   if (m_tcpServer != nullptr && m_tcpServer->start() == 0) {
@@ -202,21 +214,28 @@ Network::Network(const bool local, const uint16_t port, const uint16_t httpPort,
   } else {
     m_httpServer = nullptr;
   }
+#ifdef HAVE_EPOLL
+  if (m_listening) {
+    m_epollFd = epoll_create1(0);
+    if (m_epollFd < 0) {
+      logError(lf_network, "unable to create epoll instance");
+      m_listening = false;
+    }
+  }
+#endif
 }
 
 Network::~Network() {
   stop();
+  join();
   NetMessage* netMsg;
   while ((netMsg = m_netQueue->pop()) != nullptr) {
-    netMsg->setResult("ERR: shutdown", "", nullptr, 0, true);
+    netMsg->setResult("ERR: shutdown", "", nullptr, 0, 0, true);
   }
-  while (!m_connections.empty()) {
-    Connection* connection = m_connections.back();
-    m_connections.pop_back();
-    connection->stop();
-    connection->join();
-    delete connection;
+  for (const auto& it : m_connections) {
+    delete it.second;
   }
+  m_connections.clear();
 
   if (m_tcpServer != nullptr) {
     delete m_tcpServer;
@@ -224,124 +243,239 @@ Network::~Network() {
   if (m_httpServer != nullptr) {
     delete m_httpServer;
   }
-  join();
+  if (m_epollFd >= 0) {
+    close(m_epollFd);
+  }
 }
 
 void Network::run() {
   if (!m_listening) {
     return;
   }
-  int ret;
-  struct timespec tdiff;
-
-  // set timeout
-  tdiff.tv_sec = 1;
-  tdiff.tv_nsec = 0;
-#ifdef HAVE_PPOLL
-  int socketCount = m_httpServer ? 2 : 1;
-  nfds_t nfds = 1+socketCount;
-  struct pollfd fds[nfds];
-
-  memset(fds, 0, sizeof(fds));
+  int notifyFD = m_notify.notifyFD();
+  int resultFD = m_resultNotify.notifyFD();
+  int tcpFD = m_tcpServer->getFD();
+  int httpFD = m_httpServer ? m_httpServer->getFD() : -1;
+  watch(notifyFD, WATCH_READ);
+  watch(resultFD, WATCH_READ);
+  watch(tcpFD, WATCH_READ);
+  if (m_httpServer) {
+    watch(httpFD, WATCH_READ);
+  }
+  vector<pair<int, int>> events;
+  time_t now, lastCheck = 0;
+  while (true) {
+    // wait for new fd event
+    if (waitEvents(1000, &events) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      logError(lf_network, "waiting for events failed: %s", strerror(errno));
+      return;
+    }
+    time(&now);
+    bool checkResults = false;
+    for (const auto& event : events) {
+      int fd = event.first;
+      int flags = event.second;
+      if (fd == notifyFD) {
+        return;
+      }
+      if (fd == resultFD) {
+        char buf[32];
+        if (read(resultFD, buf, sizeof(buf)) < 0) {
+          // ignore
+        }
+        checkResults = true;
+        continue;
+      }
+      if (fd == tcpFD || fd == httpFD) {
+        acceptConnection(fd == httpFD);
+        continue;
+      }
+      const auto it = m_connections.find(fd);
+      if (it == m_connections.end()) {
+        continue;
+      }
+      Connection* connection = it->second;
+      bool keep;
+      if (flags & EVENT_ERROR) {
+        keep = false;
+        if (connection->isWaiting()) {
+          // defer until the result was set
+          connection->setClosed();
+          unwatch(fd);
+          continue;
+        }
+      } else {
+        keep = true;
+        if (flags & EVENT_WRITE) {
+          keep = connection->send();
+        }
+        if (keep && (flags & EVENT_READ) && !connection->isWaiting() && !connection->hasOutput()) {
+          keep = connection->receive();
+        }
+      }
+      if (keep) {
+        updateConnection(connection);
+      } else {
+        closeConnection(connection);
+      }
+    }
+    bool tick = now != lastCheck;
+    if (checkResults || tick) {
+      lastCheck = now;
+      for (auto it = m_connections.begin(); it != m_connections.end(); ) {
+        Connection* connection = it->second;
+        it++;  // connection might get removed
+        if (!connection->checkResult(now) || (tick && !connection->checkIdle(now))) {
+          closeConnection(connection);
+          continue;
+        }
+        if (tick) {
+          connection->checkListen(now);
+        }
+        if (!connection->isClosed()) {
+          updateConnection(connection);
+        }
+      }
+    }
+  }
+}
 
-  fds[0].fd = m_notify.notifyFD();
-  fds[0].events = POLLIN;
+void Network::acceptConnection(bool isHttp) {
+  TCPSocket* socket = (isHttp ? m_httpServer : m_tcpServer)->newSocket();
+  if (socket == nullptr) {
+    return;
+  }
+  int fd = socket->getFD();
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  Connection* connection = new Connection(socket, isHttp, m_netQueue, &m_resultNotify);
+  m_connections[fd] = connection;
+  updateConnection(connection);
+  string ip = socket->getIP();
+  logInfo(lf_network, "[%05d] %s connection opened %s", connection->getID(), isHttp ? "HTTP" : "client",
+      ip.c_str());
+}
 
-  fds[1].fd = m_tcpServer->getFD();
-  fds[1].events = POLLIN;
+void Network::closeConnection(Connection* connection) {
+  int fd = connection->getFD();
+  unwatch(fd);
+  m_connections.erase(fd);
+  logInfo(lf_network, "[%05d] connection closed", connection->getID());
+  delete connection;
+}
 
-  if (m_httpServer) {
-    fds[2].fd = m_httpServer->getFD();
-    fds[2].events = POLLIN;
+void Network::updateConnection(Connection* connection) {
+  int flags;
+  if (connection->hasOutput()) {
+    flags = WATCH_WRITE;
+  } else if (connection->isWaiting()) {
+    flags = 0;  // still watched for errors
+  } else {
+    flags = WATCH_READ;
   }
-#else
-#ifdef HAVE_PSELECT
-  int maxfd;
-  fd_set checkfds;
+  watch(connection->getFD(), flags);
+}
 
-  FD_ZERO(&checkfds);
-  FD_SET(m_notify.notifyFD(), &checkfds);
-  FD_SET(m_tcpServer->getFD(), &checkfds);
-  if (m_httpServer) {
-    FD_SET(m_httpServer->getFD(), &checkfds);
+void Network::watch(int fd, int flags) {
+  const auto it = m_watched.find(fd);
+  bool add = it == m_watched.end();
+  if (!add && it->second == flags) {
+    return;
   }
-
-  maxfd = (m_notify.notifyFD() > m_tcpServer->getFD()) ?
-    m_notify.notifyFD() : m_tcpServer->getFD();
-  if (m_httpServer && m_httpServer->getFD() > maxfd) {
-    maxfd = m_httpServer->getFD();
+  m_watched[fd] = flags;
+#ifdef HAVE_EPOLL
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  if (flags & WATCH_READ) {
+    event.events |= EPOLLIN;
+  }
+  if (flags & WATCH_WRITE) {
+    event.events |= EPOLLOUT;
   }
+  event.data.fd = fd;
+  epoll_ctl(m_epollFd, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event);
 #endif
+}
+
+void Network::unwatch(int fd) {
+  if (m_watched.erase(fd) == 0) {
+    return;
+  }
+#ifdef HAVE_EPOLL
+  struct epoll_event event;  // non-null for older kernels
+  epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, &event);
 #endif
-  while (true) {
-#ifdef HAVE_PPOLL
-    // wait for new fd event
-    ret = ppoll(fds, nfds, &tdiff, nullptr);
+}
+
+int Network::waitEvents(int timeout, vector<pair<int, int>>* events) {
+  events->clear();
+#ifdef HAVE_EPOLL
+  struct epoll_event epollEvents[MAX_EVENTS];
+  int ret = epoll_wait(m_epollFd, epollEvents, MAX_EVENTS, timeout);
+  for (int i = 0; i < ret; i++) {
+    int fd = epollEvents[i].data.fd;
+    uint32_t revents = epollEvents[i].events;
+    events->push_back(pair<int, int>(fd,
+        ((revents & EPOLLIN) ? EVENT_READ : 0) | ((revents & EPOLLOUT) ? EVENT_WRITE : 0)
+        | ((revents & (EPOLLERR | EPOLLHUP)) ? EVENT_ERROR : 0)));
+  }
+  return ret;
 #else
-#ifdef HAVE_PSELECT
-    // set readfds to inital checkfds
-    fd_set readfds = checkfds;
-    // wait for new fd event
-    ret = pselect(maxfd + 1, &readfds, nullptr, nullptr, &tdiff, nullptr);
-#endif
-#endif
-    if (ret == 0) {
-      cleanConnections();
-      continue;
-    }
-    bool newData = false, isHttp = false;
+  struct timespec tdiff;
+  tdiff.tv_sec = timeout/1000;
+  tdiff.tv_nsec = (timeout%1000)*1000000;
 #ifdef HAVE_PPOLL
-    // new data from notify
-    if (fds[0].revents & POLLIN) {
-      return;
-    }
-    // new data from socket
-    if (fds[1].revents & POLLIN) {
-      newData = true;
-    } else if (m_httpServer && fds[2].revents & POLLIN) {
-      newData = isHttp = true;
+  vector<struct pollfd> fds;
+  for (const auto& it : m_watched) {
+    struct pollfd fd;
+    memset(&fd, 0, sizeof(fd));
+    fd.fd = it.first;
+    fd.events = ((it.second & WATCH_READ) ? POLLIN : 0) | ((it.second & WATCH_WRITE) ? POLLOUT : 0);
+    fds.push_back(fd);
+  }
+  int ret = ppoll(fds.data(), fds.size(), &tdiff, nullptr);
+  if (ret > 0) {
+    for (const auto& fd : fds) {
+      if (fd.revents) {
+        events->push_back(pair<int, int>(fd.fd,
+            ((fd.revents & POLLIN) ? EVENT_READ : 0) | ((fd.revents & POLLOUT) ? EVENT_WRITE : 0)
+            | ((fd.revents & (POLLERR | POLLHUP | POLLNVAL)) ? EVENT_ERROR : 0)));
+      }
     }
+  }
+  return ret < 0 ? ret : static_cast<int>(events->size());
 #else
 #ifdef HAVE_PSELECT
-    // new data from notify
-    if (FD_ISSET(m_notify.notifyFD(), &readfds)) {
-      return;
+  int maxfd = 0;
+  fd_set readfds, writefds;
+  FD_ZERO(&readfds);
+  FD_ZERO(&writefds);
+  for (const auto& it : m_watched) {
+    if (it.second & WATCH_READ) {
+      FD_SET(it.first, &readfds);
     }
-    // new data from socket
-    if (FD_ISSET(m_tcpServer->getFD(), &readfds)) {
-      newData = true;
-    } else if (m_httpServer && FD_ISSET(m_httpServer->getFD(), &readfds)) {
-      newData = isHttp = true;
+    if (it.second & WATCH_WRITE) {
+      FD_SET(it.first, &writefds);
     }
-#endif
-#endif
-    if (newData) {
-      TCPSocket* socket = (isHttp ? m_httpServer : m_tcpServer)->newSocket();
-      if (socket == nullptr) {
-        continue;
-      }
-      Connection* connection = new Connection(socket, isHttp, m_netQueue);
-      connection->start("connection");
-      m_connections.push_back(connection);
-      string ip = socket->getIP();
-      logInfo(lf_network, "[%05d] %s connection opened %s", connection->getID(), isHttp ? "HTTP" : "client",
-          ip.c_str());
+    if (it.first > maxfd) {
+      maxfd = it.first;
     }
   }
-}
-
-void Network::cleanConnections() {
-  auto it = m_connections.begin();
-  while (it != m_connections.end()) {
-    if (!(*it)->isRunning()) {
-      Connection* connection = *it;
-      it = m_connections.erase(it);
-      delete connection;
-      logDebug(lf_network, "dead connection removed - %d", m_connections.size());
-    } else {
-      it++;
+  int ret = pselect(maxfd + 1, &readfds, &writefds, nullptr, &tdiff, nullptr);
+  if (ret > 0) {
+    for (const auto& it : m_watched) {
+      int flags = (FD_ISSET(it.first, &readfds) ? EVENT_READ : 0) | (FD_ISSET(it.first, &writefds) ? EVENT_WRITE : 0);
+      if (flags) {
+        events->push_back(pair<int, int>(it.first, flags));
+      }
     }
   }
+  return ret < 0 ? ret : static_cast<int>(events->size());
+#endif
+#endif
+#endif
 }
 
 }  // namespace ebusd
@@ -22,7 +22,9 @@
 #include <string>
 #include <cstdio>
 #include <algorithm>
-#include <list>
+#include <map>
+#include <utility>
+#include <vector>
 #include "lib/ebus/datatype.h"
 #include "lib/utils/tcpsocket.h"
 #include "lib/utils/queue.h"
@@ -35,6 +37,10 @@ namespace ebusd {
  * The TCP and HTTP client request handling.
  */
 
+using std::map;
+using std::pair;
+using std::vector;
+
 /** Forward declaration for @a Connection. */
 class Connection;
 
@@ -63,15 +69,16 @@ class NetMessage {
   /**
    * Constructor.
    * @param isHttp whether this is a HTTP message.
+   * @param resultNotify the @a Notify instance to notify when the result was set, or nullptr.
    */
-  explicit NetMessage(bool isHttp)
-    : m_isHttp(isHttp), m_resultSet(false), m_disconnect(false), m_listenSince(0) {
+  explicit NetMessage(bool isHttp, const Notify* resultNotify = nullptr)
+    : m_isHttp(isHttp), m_resultNotify(resultNotify), m_keepAlive(false), m_busRequired(false), m_resultSet(false),
+      m_disconnect(false), m_listenSince(0), m_listenSequence(0) {
     m_settings.mode = cm_normal;
     m_settings.format = 0;
     m_settings.listenWithUnknown = false;
     m_settings.listenOnlyUnknown = false;
     pthread_mutex_init(&m_mutex, nullptr);
-    pthread_cond_init(&m_cond, nullptr);
   }
 
   /**
@@ -80,7 +87,6 @@ class NetMessage {
   ~NetMessage() {
     m_resultSet = true;
     pthread_mutex_destroy(&m_mutex);
-    pthread_cond_destroy(&m_cond);
   }
 
 
@@ -95,7 +101,7 @@ class NetMessage {
  public:
   /**
    * Add request data received from the client.
-   * @param request the request data from the client.
+   * @param request the request data from the client, or nullptr to check for a complete pipelined HTTP request.
    * @return true when the request is complete and the response shall be prepared.
    */
   bool add(const char* request);
@@ -106,6 +112,23 @@ class NetMessage {
    */
   bool isHttp() const { return m_isHttp; }
 
+  /**
+   * Return whether the HTTP connection shall be kept open after the response.
+   * @return whether the HTTP connection shall be kept open after the response.
+   */
+  bool isKeepAlive() const { return m_keepAlive; }
+
+  /**
+   * Mark the request as not being answerable from cached data only.
+   */
+  void setBusRequired() { m_busRequired = true; }
+
+  /**
+   * Return whether the request was marked as not being answerable from cached data only.
+   * @return true when the request was marked as not being answerable from cached data only.
+   */
+  bool isBusRequired() const { return m_busRequired; }
+
   /**
    * Return the request string.
    * @return the request string.
@@ -119,32 +142,35 @@ class NetMessage {
   const string& getUser() const { return m_user; }
 
   /**
-   * Wait for the result being set and return the result string.
+   * Get the result string if it was already set.
    * @param result the variable in which to store the result string.
+   * @return true when the result was set, false when it is still pending.
    */
-  void getResult(string* result) {
+  bool getResult(string* result) {
     pthread_mutex_lock(&m_mutex);
-
     if (!m_resultSet) {
-      pthread_cond_wait(&m_cond, &m_mutex);
+      pthread_mutex_unlock(&m_mutex);
+      return false;
     }
     m_request.clear();
     *result = m_result;
     m_result.clear();
     m_resultSet = false;
     pthread_mutex_unlock(&m_mutex);
+    return true;
   }
 
   /**
-   * Set the result string and notify the waiting thread.
+   * Set the result string and notify the waiting @a Network.
    * @param result the result string.
    * @param user the new user name.
    * @param settings the new client settings.
    * @param listenUntil the end time to which to updates were added (exclusive).
+   * @param listenSequence the journal sequence number of the last update added.
    * @param disconnect true when the client shall be disconnected.
    */
   void setResult(const string& result, const string& user, ClientSettings* settings, time_t listenUntil,
-      bool disconnect) {
+      uint64_t listenSequence, bool disconnect) {
     pthread_mutex_lock(&m_mutex);
     m_result = result;
     m_user = user;
@@ -153,20 +179,28 @@ class NetMessage {
       m_settings = *settings;
     }
     m_listenSince = listenUntil;
+    m_listenSequence = listenSequence;
+    m_busRequired = false;
     m_resultSet = true;
-    pthread_cond_signal(&m_cond);
     pthread_mutex_unlock(&m_mutex);
+    if (m_resultNotify) {
+      m_resultNotify->notify();
+    }
   }
 
   /**
    * Return the client settings.
    * @param listenSince set listening to the specified start time from which to add updates (inclusive).
+   * @param listenSequence set to the journal sequence number of the last update already added.
    * @return the client settings.
    */
-  ClientSettings getSettings(time_t* listenSince = nullptr) {
+  ClientSettings getSettings(time_t* listenSince = nullptr, uint64_t* listenSequence = nullptr) {
     if (listenSince) {
       *listenSince = m_listenSince;
     }
+    if (listenSequence) {
+      *listenSequence = m_listenSequence;
+    }
     return m_settings;
   }
 
@@ -187,9 +221,21 @@ class NetMessage {
   /** whether this is a HTTP message. */
   const bool m_isHttp;
 
+  /** the @a Notify instance to notify when the result was set, or nullptr. */
+  const Notify* m_resultNotify;
+
   /** the request string. */
   string m_request;
 
+  /** the HTTP input received after the current request. */
+  string m_pendingInput;
+
+  /** whether the HTTP connection shall be kept open after the response. */
+  bool m_keepAlive;
+
+  /** whether the request is not answerable from cached data only. */
+  bool m_busRequired;
+
   /** the current user name. */
   string m_user;
 
@@ -205,53 +251,113 @@ class NetMessage {
   /** mutex variable for exclusive lock. */
   pthread_mutex_t m_mutex;
 
-  /** condition variable for exclusive lock. */
-  pthread_cond_t m_cond;
-
   /** the client settings. */
   ClientSettings m_settings;
 
   /** start timestamp of listening update. */
   time_t m_listenSince;
+
+  /** the journal sequence number of the last listening update. */
+  uint64_t m_listenSequence;
 };
 
 /**
- * class connection which handle client and baseloop communication.
+ * A single client connection served by the @a Network event loop.
  */
-class Connection : public Thread {
+class Connection {
  public:
   /**
    * Constructor.
    * @param socket the @a TCPSocket for communication.
    * @param isHttp whether this is a HTTP message.
    * @param netQueue the reference to the @a NetMessage @a Queue.
+   * @param resultNotify the @a Notify instance to notify when a result was set.
    */
-  Connection(TCPSocket* socket, const bool isHttp, Queue<NetMessage*>* netQueue)
-    : Thread(), m_isHttp(isHttp), m_socket(socket), m_netQueue(netQueue) {
+  Connection(TCPSocket* socket, const bool isHttp, Queue<NetMessage*>* netQueue, const Notify* resultNotify)
+    : m_socket(socket), m_netQueue(netQueue), m_message(isHttp, resultNotify), m_waiting(false), m_closed(false),
+      m_outputPos(0), m_listenAt(0) {
     m_id = ++m_ids;
+    m_lastActive = time(nullptr);
   }
 
-  virtual ~Connection() { if (m_socket) delete m_socket; }
   /**
-   * endless loop for connection instance.
+   * Destructor.
    */
-  virtual void run();
+  ~Connection() { if (m_socket) delete m_socket; }
 
   /**
-   * Stop this connection.
+   * Return the ID of this connection.
+   * @return the ID of this connection.
    */
-  virtual void stop() { m_notify.notify(); Thread::stop(); }
+  int getID() const { return m_id; }
 
   /**
-   * Return the ID of this connection.
-   * @return the ID of this connection.
+   * Return the file descriptor of the socket.
+   * @return the file descriptor of the socket.
+   */
+  int getFD() const { return m_socket->getFD(); }
+
+  /**
+   * Return whether a request was passed to the @a MainLoop and the result is still pending.
+   * @return true when the result is still pending.
+   */
+  bool isWaiting() const { return m_waiting; }
+
+  /**
+   * Return whether there is output left to send.
+   * @return true when there is output left to send.
+   */
+  bool hasOutput() const { return m_outputPos < m_output.length(); }
+
+  /**
+   * Return whether the socket was closed by the client while waiting for the result.
+   * @return true when the socket was closed by the client.
+   */
+  bool isClosed() const { return m_closed; }
+
+  /**
+   * Mark the socket as closed by the client.
+   */
+  void setClosed() { m_closed = true; }
+
+  /**
+   * Receive available data from the socket and pass a complete request to the @a MainLoop.
+   * @return false when the connection shall be closed.
+   */
+  bool receive();
+
+  /**
+   * Take over the result if it was set and send it to the client.
+   * @param now the current time.
+   * @return false when the connection shall be closed.
    */
-  int getID() { return m_id; }
+  bool checkResult(time_t now);
+
+  /**
+   * Send pending output to the client.
+   * @return false when the connection shall be closed.
+   */
+  bool send();
+
+  /**
+   * Check whether the HTTP connection was idle for too long.
+   * @param now the current time.
+   * @return false when the connection shall be closed.
+   */
+  bool checkIdle(time_t now) const;
+
+  /**
+   * Pass an empty request to the @a MainLoop when in listening mode and an update check is due.
+   * @param now the current time.
+   */
+  void checkListen(time_t now);
 
 
  private:
-  /** whether this is a HTTP connection. */
-  const bool m_isHttp;
+  /**
+   * Pass the request to the @a MainLoop.
+   */
+  void queueRequest();
 
   /** the @a TCPSocket for communication. */
   TCPSocket* m_socket;
@@ -259,8 +365,26 @@ class Connection : public Thread {
   /** the reference to the @a NetMessage @a Queue. */
   Queue<NetMessage*>* m_netQueue;
 
-  /** notification object for shutdown procedure. */
-  Notify m_notify;
+  /** the @a NetMessage for transfer to the @a MainLoop. */
+  NetMessage m_message;
+
+  /** whether the result of the request passed to the @a MainLoop is pending. */
+  bool m_waiting;
+
+  /** whether the socket was closed by the client while waiting for the result. */
+  bool m_closed;
+
+  /** the output to send to the client. */
+  string m_output;
+
+  /** the position in @a m_output of the next character to send. */
+  size_t m_outputPos;
+
+  /** the time when to check for listening updates next. */
+  time_t m_listenAt;
+
+  /** the time of the last data received from or sent to the client. */
+  time_t m_lastActive;
 
   /** the ID of this connection. */
   int m_id;
@@ -270,7 +394,8 @@ class Connection : public Thread {
 };
 
 /**
- * class network which listening on tcp socket for incoming connections.
+ * class network which listening on tcp socket for incoming connections and serves all client connections in a single
+ * event loop.
  */
 class Network : public Thread {
  public:
@@ -300,8 +425,47 @@ class Network : public Thread {
 
 
  private:
-  /** the list of active @a Connection instances. */
-  list<Connection*> m_connections;
+  /**
+   * Accept a new client connection.
+   * @param isHttp whether this is a HTTP connection.
+   */
+  void acceptConnection(bool isHttp);
+
+  /**
+   * Close the client connection and free it.
+   * @param connection the @a Connection to close.
+   */
+  void closeConnection(Connection* connection);
+
+  /**
+   * Update the events to watch for the client connection depending on its state.
+   * @param connection the @a Connection to update.
+   */
+  void updateConnection(Connection* connection);
+
+  /**
+   * Start or change watching a file descriptor.
+   * @param fd the file descriptor to watch.
+   * @param flags the events to watch for (combination of WATCH_* flags).
+   */
+  void watch(int fd, int flags);
+
+  /**
+   * Stop watching a file descriptor.
+   * @param fd the file descriptor to stop watching.
+   */
+  void unwatch(int fd);
+
+  /**
+   * Wait for events on the watched file descriptors.
+   * @param timeout the maximum time to wait in milliseconds.
+   * @param events the vector to fill with the file descriptors and their events (combination of EVENT_* flags).
+   * @return the number of events, or -1 on error.
+   */
+  int waitEvents(int timeout, vector<pair<int, int>>* events);
+
+  /** the active @a Connection instances by file descriptor. */
+  map<int, Connection*> m_connections;
 
   /** the reference to the @a NetMessage @a Queue. */
   Queue<NetMessage*>* m_netQueue;
@@ -315,13 +479,17 @@ class Network : public Thread {
   /** @a Notify object for shutdown procedure. */
   Notify m_notify;
 
+  /** @a Notify object for results set by the @a MainLoop. */
+  Notify m_resultNotify;
+
+  /** the watched file descriptors with the events to watch for (combination of WATCH_* flags). */
+  map<int, int> m_watched;
+
+  /** the epoll file descriptor, or -1. */
+  int m_epollFd;
+
   /** true if this instance is listening. */
   bool m_listening;
-
-  /**
-   * clean inactive connections from container.
-   */
-  void cleanConnections();
 };
 
 }  // namespace ebusd
@@ -90,21 +90,23 @@ void AttributedItem::appendJson(bool prependFieldSeparator, const string& name,
     }
   }
   if (prependFieldSeparator) {
-    *output << FIELD_SEPARATOR;
+    OutputBuffer::append(FIELD_SEPARATOR, output);
   }
-  *output << " \"" << name << "\": ";
+  OutputBuffer::append(" \"", 2, output);
+  OutputBuffer::append(name, output);
+  OutputBuffer::append("\": ", 3, output);
   if (plain) {
-    *output << value;
+    OutputBuffer::append(value, output);
   } else {
-    *output << '"';
+    OutputBuffer::append('"', output);
     if (value.find_first_of('"') == string::npos) {  // check for nested '"'
-      *output << value;
+      OutputBuffer::append(value, output);
     } else {
       string replaced = value;
       replace(replaced.begin(), replaced.end(), '"', '\'');
-      *output << replaced;
+      OutputBuffer::append(replaced, output);
     }
-    *output << '"';
+    OutputBuffer::append('"', output);
   }
 }
 
@@ -136,7 +138,10 @@ bool AttributedItem::appendAttribute(OutputFormat outputFormat, const string& na
   if (outputFormat & OF_JSON) {
     appendJson(true, name, value, false, output);
   } else {
-    *output << " " << prefix << value << suffix;
+    OutputBuffer::append(' ', output);
+    OutputBuffer::append(prefix, output);
+    OutputBuffer::append(value, output);
+    OutputBuffer::append(suffix, output);
   }
   return true;
 }
@@ -535,32 +540,39 @@ result_t SingleDataField::read(const SymbolString& data, size_t offset,
   bool shortFormat = outputFormat & OF_SHORT;
   if (outputFormat & OF_JSON) {
     if (leadingSeparator) {
-      *output << ",";
+      OutputBuffer::append(',', output);
     }
     if (fieldIndex < 0 && !shortFormat) {
-      *output << "\n     ";
+      OutputBuffer::append("\n     ", 6, output);
     }
     if (outputIndex >= 0 || m_name.empty() || !(outputFormat & OF_NAMES)) {
       if (fieldIndex < 0) {
-        *output << "\"" << static_cast<signed int>(outputIndex < 0 ? 0 : outputIndex) << "\":";
+        OutputBuffer::append('"', output);
+        OutputBuffer::appendInt(static_cast<signed int>(outputIndex < 0 ? 0 : outputIndex), output);
+        OutputBuffer::append("\":", 2, output);
       }
       if (!shortFormat) {
-        *output << " {\"name\": \"" << m_name << "\"" << ", \"value\": ";
+        OutputBuffer::append(" {\"name\": \"", 11, output);
+        OutputBuffer::append(m_name, output);
+        OutputBuffer::append("\", \"value\": ", 12, output);
       }
     } else {
       if (fieldIndex < 0) {
-        *output << "\"" << m_name << "\":";
+        OutputBuffer::append('"', output);
+        OutputBuffer::append(m_name, output);
+        OutputBuffer::append("\":", 2, output);
       }
       if (!shortFormat) {
-        *output << " {\"value\": ";
+        OutputBuffer::append(" {\"value\": ", 11, output);
       }
     }
   } else {
     if (leadingSeparator) {
-      *output << UI_FIELD_SEPARATOR;
+      OutputBuffer::append(UI_FIELD_SEPARATOR, output);
     }
     if (outputFormat & OF_NAMES) {
-      *output << m_name << "=";
+      OutputBuffer::append(m_name, output);
+      OutputBuffer::append('=', output);
     }
   }
 
@@ -572,7 +584,7 @@ result_t SingleDataField::read(const SymbolString& data, size_t offset,
     appendAttributes(outputFormat, output);
   }
   if (!shortFormat && (outputFormat & OF_JSON)) {
-    *output << "}";
+    OutputBuffer::append('}', output);
   }
   return RESULT_OK;
 }
@@ -588,6 +600,24 @@ result_t SingleDataField::write(char separator, size_t offset, istringstream* in
   return writeSymbols(offset, input, data, usedLength);
 }
 
+void SingleDataField::readValues(const SymbolString& data, size_t offset, size_t valueIndex,
+    vector<NumericValue>* values) const {
+  if (isIgnored() || m_partType != (data.isMaster() ? pt_masterData : pt_slaveData) || valueIndex >= values->size()) {
+    return;
+  }
+  NumericValue& value = (*values)[valueIndex];
+  bool remainder = m_length == REMAIN_LEN && m_dataType->isAdjustableLength();
+  if (offset + (remainder?1:m_length) > data.getDataSize()
+      || (readValue(data, offset, &value) != RESULT_OK && value.m_type != nv_raw)) {
+    value.m_type = nv_none;
+    value.m_value = 0;
+  }
+}
+
+result_t SingleDataField::readValue(const SymbolString& input, size_t offset, NumericValue* value) const {
+  return m_dataType->readValue(offset, m_length, input, value);
+}
+
 result_t SingleDataField::readSymbols(const SymbolString& input, size_t offset,
     OutputFormat outputFormat, ostream* output) const {
   return m_dataType->readSymbols(offset, m_length, input, outputFormat, output);
@@ -677,6 +707,10 @@ size_t SingleDataField::getCount(PartType partType, const char* fieldName) const
   ? 0 : 1;
 }
 
+ssize_t SingleDataField::getIndex(const char* fieldName, ssize_t fieldIndex, PartType partType) const {
+  return getCount(partType, fieldName) == 0 || fieldIndex > 0 ? -1 : 0;
+}
+
 
 const ValueListDataField* ValueListDataField::clone() const {
   return new ValueListDataField(*this);
@@ -734,6 +768,14 @@ void ValueListDataField::dump(bool prependFieldSeparator, bool asJson, ostream*
   dumpSuffix(asJson, output);
 }
 
+result_t ValueListDataField::readValue(const SymbolString& input, size_t offset, NumericValue* value) const {
+  result_t result = SingleDataField::readValue(input, offset, value);
+  if (result == RESULT_OK && value->m_type == nv_int && m_values.find(value->m_raw) != m_values.end()) {
+    value->m_type = nv_enum;
+  }
+  return result;
+}
+
 result_t ValueListDataField::readSymbols(const SymbolString& input, size_t offset,
     OutputFormat outputFormat, ostream* output) const {
   unsigned int value = 0;
@@ -745,7 +787,8 @@ result_t ValueListDataField::readSymbols(const SymbolString& input, size_t offse
   const auto it = m_values.find(value);
   if (it == m_values.end() && value != m_dataType->getReplacement()) {
     // fall back to raw value in input
-    *output << setw(0) << dec << value;
+    *output << setw(0) << dec;
+    OutputBuffer::appendUnsigned(value, output);
     return RESULT_OK;
   }
   if (it == m_values.end()) {
@@ -755,19 +798,25 @@ result_t ValueListDataField::readSymbols(const SymbolString& input, size_t offse
       *output << NULL_VALUE;
     }
   } else if (outputFormat & OF_NUMERIC) {
-    *output << setw(0) << dec << value;
+    *output << setw(0) << dec;
+    OutputBuffer::appendUnsigned(value, output);
   } else if (outputFormat & OF_JSON) {
     if (outputFormat & OF_VALUENAME) {
-      *output << "{\"value\":" << setw(0) << dec << value;
+      *output << "{\"value\":" << setw(0) << dec;
+      OutputBuffer::appendUnsigned(value, output);
       *output << ",\"name\":\"" << it->second << "\"}";
     } else {
-      *output << '"' << it->second << '"';
+      OutputBuffer::append('"', output);
+      OutputBuffer::append(it->second, output);
+      OutputBuffer::append('"', output);
     }
   } else {
     if (outputFormat & OF_VALUENAME) {
-      *output << setw(0) << dec << value << '=';
+      *output << setw(0) << dec;
+      OutputBuffer::appendUnsigned(value, output);
+      OutputBuffer::append('=', output);
     }
-    *output << it->second;
+    OutputBuffer::append(it->second, output);
   }
   return RESULT_OK;
 }
@@ -985,6 +1034,23 @@ string DataFieldSet::getName(ssize_t fieldIndex) const {
   return ostream.str();
 }
 
+ssize_t DataFieldSet::getIndex(const char* fieldName, ssize_t fieldIndex, PartType partType) const {
+  ssize_t index = 0;
+  for (const auto field : m_fields) {
+    if (field->isIgnored()) {
+      continue;
+    }
+    if (field->getCount(partType, fieldName) > 0) {
+      if (fieldIndex <= 0) {
+        return index;
+      }
+      fieldIndex--;
+    }
+    index++;
+  }
+  return -1;
+}
+
 result_t DataFieldSet::derive(const string& name, PartType partType, int divisor,
     const map<unsigned int, string>& values, map<string, string>* attributes,
     vector<const SingleDataField*>* fields) const {
@@ -1019,24 +1085,58 @@ void DataFieldSet::dump(bool prependFieldSeparator, bool asJson, ostream* output
   }
 }
 
+void DataFieldSet::compilePlan() {
+  m_masterPlan.clear();
+  m_slavePlan.clear();
+  for (PartType partType : {pt_masterData, pt_slaveData}) {
+    vector<DataFieldStep>& plan = partType == pt_masterData ? m_masterPlan : m_slavePlan;
+    bool previousFullByteOffset = true, fromEnd = false;
+    int16_t previousFirstBit = -1;
+    ssize_t offset = 0, outputIndex = 0;
+    for (const auto field : m_fields) {
+      if (field->getPartType() != partType) {
+        if (!field->isIgnored()) {
+          outputIndex++;
+        }
+        continue;
+      }
+      if (!previousFullByteOffset && !field->hasFullByteOffset(false, previousFirstBit)) {
+        offset--;
+      }
+      DataFieldStep step;
+      step.m_field = field;
+      step.m_fromEnd = fromEnd;
+      step.m_offset = offset;
+      step.m_outputIndex = outputIndex;
+      plan.push_back(step);
+      size_t length = field->getLength(partType, REMAIN_LEN);
+      if (length == REMAIN_LEN) {
+        // the field consumes the remaining data, so any further field starts at the end
+        fromEnd = true;
+        offset = 0;
+      } else {
+        offset += static_cast<ssize_t>(length);
+      }
+      previousFullByteOffset = field->hasFullByteOffset(true, previousFirstBit);
+      if (!field->isIgnored()) {
+        outputIndex++;
+      }
+    }
+  }
+}
+
 result_t DataFieldSet::read(const SymbolString& data, size_t offset,
     const char* fieldName, ssize_t fieldIndex, unsigned int* output) const {
-  bool previousFullByteOffset = true, found = false, findFieldIndex = fieldIndex >= 0;
-  int16_t previousFirstBit = -1;
-  PartType partType = data.isMaster() ? pt_masterData : pt_slaveData;
-  for (const auto field : m_fields) {
-    if (field->getPartType() != partType) {
-      continue;
-    }
-    if (!previousFullByteOffset && !field->hasFullByteOffset(false, previousFirstBit)) {
-      offset--;
-    }
-    result_t result = field->read(data, offset, fieldName, fieldIndex, output);
+  bool found = false, findFieldIndex = fieldIndex >= 0;
+  const vector<DataFieldStep>& plan = data.isMaster() ? m_masterPlan : m_slavePlan;
+  ssize_t start = static_cast<ssize_t>(offset), end = static_cast<ssize_t>(data.getDataSize());
+  for (const auto& step : plan) {
+    const SingleDataField* field = step.m_field;
+    result_t result = field->read(data, static_cast<size_t>((step.m_fromEnd ? end : start) + step.m_offset),
+        fieldName, fieldIndex, output);
     if (result < RESULT_OK) {
       return result;
     }
-    offset += field->getLength(partType, data.getDataSize()-offset);
-    previousFullByteOffset = field->hasFullByteOffset(true, previousFirstBit);
     if (result != RESULT_EMPTY) {
       found = true;
     }
@@ -1061,29 +1161,20 @@ result_t DataFieldSet::read(const SymbolString& data, size_t offset,
 result_t DataFieldSet::read(const SymbolString& data, size_t offset,
     bool leadingSeparator, const char* fieldName, ssize_t fieldIndex,
     OutputFormat outputFormat, ssize_t outputIndex, ostream* output) const {
-  bool previousFullByteOffset = true, found = false, findFieldIndex = fieldIndex >= 0;
-  int16_t previousFirstBit = -1;
+  bool found = false, findFieldIndex = fieldIndex >= 0;
   if (outputIndex < 0 && (!m_uniqueNames || ((outputFormat & OF_JSON) && !(outputFormat & OF_NAMES)))) {
     outputIndex = 0;
   }
-  PartType partType = data.isMaster() ? pt_masterData : pt_slaveData;
-  for (const auto field : m_fields) {
-    if (field->getPartType() != partType) {
-      if (outputIndex >= 0 && !field->isIgnored()) {
-        outputIndex++;
-      }
-      continue;
-    }
-    if (!previousFullByteOffset && !field->hasFullByteOffset(false, previousFirstBit)) {
-      offset--;
-    }
-    result_t result = field->read(data, offset, leadingSeparator, fieldName, fieldIndex,
-        outputFormat, outputIndex, output);
+  const vector<DataFieldStep>& plan = data.isMaster() ? m_masterPlan : m_slavePlan;
+  ssize_t start = static_cast<ssize_t>(offset), end = static_cast<ssize_t>(data.getDataSize());
+  for (const auto& step : plan) {
+    const SingleDataField* field = step.m_field;
+    result_t result = field->read(data, static_cast<size_t>((step.m_fromEnd ? end : start) + step.m_offset),
+        leadingSeparator, fieldName, fieldIndex, outputFormat, outputIndex < 0 ? -1 : outputIndex + step.m_outputIndex,
+        output);
     if (result < RESULT_OK) {
       return result;
     }
-    offset += field->getLength(partType, data.getDataSize()-offset);
-    previousFullByteOffset = field->hasFullByteOffset(true, previousFirstBit);
     if (result != RESULT_EMPTY) {
       found = true;
       leadingSeparator = true;
@@ -1097,9 +1188,6 @@ result_t DataFieldSet::read(const SymbolString& data, size_t offset,
       }
       fieldIndex--;
     }
-    if (outputIndex >= 0 && !field->isIgnored()) {
-      outputIndex++;
-    }
   }
 
   if (!found) {
@@ -1108,6 +1196,16 @@ result_t DataFieldSet::read(const SymbolString& data, size_t offset,
   return RESULT_OK;
 }
 
+void DataFieldSet::readValues(const SymbolString& data, size_t offset, size_t valueIndex,
+    vector<NumericValue>* values) const {
+  const vector<DataFieldStep>& plan = data.isMaster() ? m_masterPlan : m_slavePlan;
+  ssize_t start = static_cast<ssize_t>(offset), end = static_cast<ssize_t>(data.getDataSize());
+  for (const auto& step : plan) {
+    step.m_field->readValues(data, static_cast<size_t>((step.m_fromEnd ? end : start) + step.m_offset),
+        valueIndex + static_cast<size_t>(step.m_outputIndex), values);
+  }
+}
+
 result_t DataFieldSet::write(char separator, size_t offset, istringstream* input,
     SymbolString* data, size_t* usedLength) const {
   string token;
@@ -1214,6 +1312,15 @@ result_t LoadableDataFieldSet::getFieldMap(const string& preferLanguage, vector<
   return RESULT_OK;
 }
 
+result_t LoadableDataFieldSet::readFromStream(istream* stream, const string& filename, const time_t& mtime,
+    bool verbose, map<string, string>* defaults, string* errorDescription, bool replace, size_t* hash, size_t* size) {
+  result_t result = MappedFileReader::readFromStream(stream, filename, mtime, verbose, defaults, errorDescription,
+      replace, hash, size);
+  // compile the plans once for all the added fields
+  compilePlan();
+  return result;
+}
+
 result_t LoadableDataFieldSet::addFromFile(const string& filename, unsigned int lineNo, map<string, string>* row,
     vector< map<string, string> >* subRows, string* errorDescription, bool replace) {
   const DataField* field = nullptr;
@@ -270,6 +270,15 @@ class DataField : public AttributedItem {
    */
   virtual string getName(ssize_t fieldIndex) const = 0;
 
+  /**
+   * Get the index of the specified field.
+   * @param fieldName the name of the field to find, or nullptr for any.
+   * @param fieldIndex the optional index of the field (either named or overall), or -1.
+   * @param partType the @a PartType of the field to find, or @a pt_any for any.
+   * @return the overall index of the field (excluding ignored fields), or -1 if not available.
+   */
+  virtual ssize_t getIndex(const char* fieldName, ssize_t fieldIndex, PartType partType = pt_any) const = 0;
+
   /**
    * Dump the field settings to the output.
    * @param prependFieldSeparator whether to start with a @a FIELD_SEPARATOR.
@@ -319,6 +328,18 @@ class DataField : public AttributedItem {
     bool leadingSeparator, const char* fieldName, ssize_t fieldIndex,
     OutputFormat outputFormat, ssize_t outputIndex, ostream* output) const = 0;
 
+  /**
+   * Reads the numeric values of all fields stored in the @a SymbolString without formatting.
+   * @param data the data @a SymbolString for reading binary data.
+   * @param offset the additional offset to add for reading binary data.
+   * @param valueIndex the index in @a values for the first field.
+   * @param values the @a NumericValue instances by overall field index (excluding ignored fields) in which to store
+   * the values. Values of fields stored in the other part are left untouched, values of fields that can not be
+   * read are set to @a nv_none, and values out of range are set to @a nv_raw.
+   */
+  virtual void readValues(const SymbolString& data, size_t offset, size_t valueIndex,
+      vector<NumericValue>* values) const = 0;
+
   /**
    * Writes the value to the master or slave @a SymbolString.
    * @param input the @a istringstream to parse the formatted value from.
@@ -417,6 +438,9 @@ class SingleDataField : public DataField {
     return isIgnored() || fieldIndex > 0 ? "" : m_name;
   }
 
+  // @copydoc
+  ssize_t getIndex(const char* fieldName, ssize_t fieldIndex, PartType partType = pt_any) const override;
+
   /**
    * Dump the common prefix field settings to the output (name and part type).
    * @param prependFieldSeparator whether to start with a @a FIELD_SEPARATOR.
@@ -447,12 +471,25 @@ class SingleDataField : public DataField {
       bool leadingSeparator, const char* fieldName, ssize_t fieldIndex,
       OutputFormat outputFormat, ssize_t outputIndex, ostream* output) const override;
 
+  // @copydoc
+  void readValues(const SymbolString& data, size_t offset, size_t valueIndex,
+      vector<NumericValue>* values) const override;
+
   // @copydoc
   result_t write(char separator, size_t offset, istringstream* input,
       SymbolString* data, size_t* usedLength) const override;
 
 
  protected:
+  /**
+   * Internal method for reading the numeric value of the field from a @a SymbolString.
+   * @param input the @a SymbolString to read the binary value from.
+   * @param offset the offset in the @a SymbolString.
+   * @param value the @a NumericValue in which to store the value.
+   * @return @a RESULT_OK on success, @a RESULT_EMPTY for a non-numeric field, or an error code.
+   */
+  virtual result_t readValue(const SymbolString& input, size_t offset, NumericValue* value) const;
+
   /**
    * Internal method for reading the field from a @a SymbolString.
    * @param input the @a SymbolString to read the binary value from.
@@ -523,6 +560,9 @@ class ValueListDataField : public SingleDataField {
 
 
  protected:
+  // @copydoc
+  result_t readValue(const SymbolString& input, size_t offset, NumericValue* value) const override;
+
   // @copydoc
   result_t readSymbols(const SymbolString& input, size_t offset,
       const OutputFormat outputFormat, ostream* output) const override;
@@ -594,6 +634,24 @@ class ConstantDataField : public SingleDataField {
 };
 
 
+/**
+ * A single step of the compiled decode plan of a @a DataFieldSet.
+ */
+struct DataFieldStep {
+  /** the @a SingleDataField to read. */
+  const SingleDataField* m_field;
+
+  /** whether @a m_offset is relative to the end of the data (after a field with remaining length). */
+  bool m_fromEnd;
+
+  /** the offset of the field relative to the start (or end) of the data. */
+  ssize_t m_offset;
+
+  /** the number of non-ignored fields in the set before this field (for the output index). */
+  ssize_t m_outputIndex;
+};
+
+
 /**
  * A set of @a DataField instances.
  */
@@ -636,6 +694,7 @@ class DataFieldSet : public DataField {
     }
     m_uniqueNames = uniqueNames;
     m_ignoredCount = ignoredCount;
+    compilePlan();
   }
 
   /**
@@ -658,6 +717,9 @@ class DataFieldSet : public DataField {
   // @copydoc
   string getName(ssize_t fieldIndex) const override;
 
+  // @copydoc
+  ssize_t getIndex(const char* fieldName, ssize_t fieldIndex, PartType partType = pt_any) const override;
+
   // @copydoc
   result_t derive(const string& name, PartType partType, int divisor,
       const map<unsigned int, string>& values, map<string, string>* attributes,
@@ -696,6 +758,10 @@ class DataFieldSet : public DataField {
       bool leadingSeparator, const char* fieldName, ssize_t fieldIndex,
       OutputFormat outputFormat, ssize_t outputIndex, ostream* output) const override;
 
+  // @copydoc
+  void readValues(const SymbolString& data, size_t offset, size_t valueIndex,
+      vector<NumericValue>* values) const override;
+
   // @copydoc
   result_t write(char separator, size_t offset, istringstream* input,
       SymbolString* data, size_t* usedLength) const override;
@@ -714,6 +780,20 @@ class DataFieldSet : public DataField {
 
   /** the number of ignored fields. */
   size_t m_ignoredCount;
+
+  /**
+   * Compile the decode plans from the fields, i.e. determine the offset and output index of each field once instead
+   * of on every read.
+   */
+  void compilePlan();
+
+
+ private:
+  /** the compiled decode plan for the master data. */
+  vector<DataFieldStep> m_masterPlan;
+
+  /** the compiled decode plan for the slave data. */
+  vector<DataFieldStep> m_slavePlan;
 };
 
 
@@ -731,6 +811,11 @@ class LoadableDataFieldSet : public DataFieldSet, public MappedFileReader {
     : DataFieldSet(name, vector<const SingleDataField*>()), MappedFileReader(false), m_templates(templates) {
   }
 
+  // @copydoc
+  result_t readFromStream(istream* stream, const string& filename, const time_t& mtime, bool verbose,
+      map<string, string>* defaults, string* errorDescription, bool replace = false, size_t* hash = nullptr,
+      size_t* size = nullptr) override;
+
   // @copydoc
   result_t getFieldMap(const string& preferLanguage, vector<string>* row, string* errorDescription) const override;
 
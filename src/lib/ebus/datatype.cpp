@@ -42,6 +42,13 @@ using std::setw;
 using std::endl;
 
 
+result_t DataType::readValue(size_t offset, size_t length, const SymbolString& input,
+    NumericValue* value) const {
+  value->m_type = nv_none;
+  value->m_value = 0;
+  return RESULT_EMPTY;
+}
+
 bool DataType::dump(bool asJson, size_t length, bool appendDivisor, ostream* output) const {
   if (asJson) {
     *output << "\"type\": \"" << m_id << "\"" << FIELD_SEPARATOR << " \"isbits\": "
@@ -89,17 +96,17 @@ result_t StringDataType::readSymbols(size_t offset, size_t length, const SymbolS
     incr = -1;
   }
 
+  *output << setfill('0') << (m_isHex ? hex : dec);
   if (outputFormat & OF_JSON) {
-    *output << '"';
+    OutputBuffer::append('"', output);
   }
-  *output << setfill('0') << (m_isHex ? hex : dec);
   for (size_t index = start, i = 0; i < count; index += incr, i++) {
     symbol = input.dataAt(offset + index);
     if (m_isHex) {
       if (i > 0) {
-        *output << ' ';
+        OutputBuffer::append(' ', output);
       }
-      *output << setw(2) << static_cast<unsigned>(symbol);
+      OutputBuffer::appendHex(symbol, output);
     } else {
       if (symbol == 0x00) {
         terminated = true;
@@ -110,15 +117,15 @@ result_t StringDataType::readSymbols(size_t offset, size_t length, const SymbolS
           symbol = '?';
         } else if (outputFormat & OF_JSON) {
           if (symbol == '"' || symbol == '\\') {
-            *output << '\\';  // escape
+            OutputBuffer::append('\\', output);  // escape
           }
         }
-        *output << static_cast<char>(symbol);
+        OutputBuffer::append(static_cast<char>(symbol), output);
       }
     }
   }
   if (outputFormat & OF_JSON) {
-    *output << '"';
+    OutputBuffer::append('"', output);
   }
   return RESULT_OK;
 }
@@ -639,37 +646,34 @@ result_t NumberDataType::readRawValue(size_t offset, size_t length, const Symbol
   return RESULT_OK;
 }
 
-result_t NumberDataType::readSymbols(size_t offset, size_t length, const SymbolString& input,
-    OutputFormat outputFormat, ostream* output) const {
-  unsigned int value = 0;
+result_t NumberDataType::readValue(size_t offset, size_t length, const SymbolString& input,
+    NumericValue* value) const {
+  unsigned int rawValue = 0;
   int signedValue;
 
-  result_t result = readRawValue(offset, length, input, &value);
+  result_t result = readRawValue(offset, length, input, &rawValue);
   if (result != RESULT_OK) {
     return result;
   }
-  *output << setw(0) << dec;  // initialize output
-
-  if (!hasFlag(REQ) && value == m_replacement) {
-    if (outputFormat & OF_JSON) {
-      *output << "null";
-    } else {
-      *output << NULL_VALUE;
-    }
+  value->m_raw = rawValue;
+  value->m_value = 0;
+  if (!hasFlag(REQ) && rawValue == m_replacement) {
+    value->m_type = nv_null;
     return RESULT_OK;
   }
 
+  value->m_type = nv_raw;  // replaced below once the value is known to be in range
   bool negative;
   if (hasFlag(SIG)) {  // signed value
-    negative = (value & (1 << (m_bitCount - 1))) != 0;
+    negative = (rawValue & (1 << (m_bitCount - 1))) != 0;
     if (negative) {  // negative signed value
-      if (value < m_minValue) {
+      if (rawValue < m_minValue) {
         return RESULT_ERR_OUT_OF_RANGE;  // value out of range
       }
-    } else if (value > m_maxValue) {
+    } else if (rawValue > m_maxValue) {
       return RESULT_ERR_OUT_OF_RANGE;  // value out of range
     }
-  } else if (value < m_minValue || value > m_maxValue) {
+  } else if (rawValue < m_minValue || rawValue > m_maxValue) {
     return RESULT_ERR_OUT_OF_RANGE;  // value out of range
   } else {
     negative = false;
@@ -679,17 +683,17 @@ result_t NumberDataType::readSymbols(size_t offset, size_t length, const SymbolS
       float val;
 #ifdef HAVE_DIRECT_FLOAT_FORMAT
 #  if HAVE_DIRECT_FLOAT_FORMAT == 2
-      value = __builtin_bswap32(value);
+      rawValue = __builtin_bswap32(rawValue);
 #  endif
-      symbol_t* pval = reinterpret_cast<symbol_t*>(&value);
+      symbol_t* pval = reinterpret_cast<symbol_t*>(&rawValue);
       val = *reinterpret_cast<float*>(pval);
 #else
-      int exp = (value >> 23) & 0xff;  // 8 bits, signed
+      int exp = (rawValue >> 23) & 0xff;  // 8 bits, signed
       if (exp == 0) {
         val = 0.0;
       } else {
         exp -= 127;
-        unsigned int sig = value & ((1 << 23) - 1);
+        unsigned int sig = rawValue & ((1 << 23) - 1);
         val = (1.0f + static_cast<float>(sig / exp2(23))) * static_cast<float>(exp2(exp));
         if (negative) {
           val = -val;
@@ -697,11 +701,7 @@ result_t NumberDataType::readSymbols(size_t offset, size_t length, const SymbolS
       }
 #endif
       if (val != val) {  // !isnan(val)
-        if (outputFormat & OF_JSON) {
-          *output << "null";
-        } else {
-          *output << NULL_VALUE;
-        }
+        value->m_type = nv_null;
         return RESULT_OK;
       }
       if (val != 0.0) {
@@ -711,47 +711,99 @@ result_t NumberDataType::readSymbols(size_t offset, size_t length, const SymbolS
           val /= static_cast<float>(m_divisor);
         }
       }
-      if (m_precision != 0) {
-        *output << fixed << setprecision(static_cast<int>(m_precision+6));
-      } else if (val == 0) {
-        *output << fixed << setprecision(1);
-      }
-      *output << static_cast<double>(val);
+      value->m_type = nv_float;
+      value->m_value = val;
       return RESULT_OK;
     }
     if (!negative) {
       if (m_divisor < 0) {
-        *output << (static_cast<float>(value) * static_cast<float>(-m_divisor));
+        value->m_type = nv_int;
+        value->m_value = static_cast<float>(rawValue) * static_cast<float>(-m_divisor);
       } else if (m_divisor <= 1) {
-        *output << value;
+        value->m_type = nv_int;
+        value->m_value = rawValue;
       } else {
-        *output << setprecision(static_cast<int>(m_precision))
-                << fixed << (static_cast<float>(value) / static_cast<float>(m_divisor));
+        value->m_type = nv_float;
+        value->m_value = static_cast<float>(rawValue) / static_cast<float>(m_divisor);
       }
       return RESULT_OK;
     }
-    signedValue = static_cast<int>(value);  // negative signed value
+    signedValue = static_cast<int>(rawValue);  // negative signed value
   } else if (negative) {  // negative signed value
-    signedValue = static_cast<int>(value) - (1 << m_bitCount);
+    signedValue = static_cast<int>(rawValue) - (1 << m_bitCount);
   } else {
-    signedValue = static_cast<int>(value);
+    signedValue = static_cast<int>(rawValue);
   }
   if (m_divisor < 0) {
-    *output << fixed << setprecision(0)
-        << (static_cast<float>(signedValue) * static_cast<float>(-m_divisor));
+    value->m_type = nv_int;
+    value->m_value = static_cast<float>(signedValue) * static_cast<float>(-m_divisor);
   } else if (m_divisor <= 1) {
+    value->m_type = nv_int;
+    value->m_value = signedValue;
+  } else {
+    value->m_type = nv_float;
+    value->m_value = static_cast<float>(signedValue) / static_cast<float>(m_divisor);
+  }
+  return RESULT_OK;
+}
+
+result_t NumberDataType::readSymbols(size_t offset, size_t length, const SymbolString& input,
+    OutputFormat outputFormat, ostream* output) const {
+  NumericValue value;
+  result_t result = readValue(offset, length, input, &value);
+  if (result != RESULT_OK) {
+    return result;
+  }
+  *output << setw(0) << dec;  // initialize output
+
+  if (value.m_type == nv_null) {
+    if (outputFormat & OF_JSON) {
+      *output << "null";
+    } else {
+      *output << NULL_VALUE;
+    }
+    return RESULT_OK;
+  }
+  if (m_bitCount == 32 && hasFlag(EXP)) {  // IEEE 754 binary32
+    float val = static_cast<float>(value.m_value);
+    if (m_precision != 0) {
+      *output << fixed << setprecision(static_cast<int>(m_precision+6));
+    } else if (val == 0) {
+      *output << fixed << setprecision(1);
+    }
+    *output << static_cast<double>(val);
+    return RESULT_OK;
+  }
+  bool negative = value.m_value < 0;  // only possible for signed values
+  if (m_bitCount == 32 && !negative) {
+    if (m_divisor < 0) {
+      *output << static_cast<float>(value.m_value);
+    } else if (m_divisor <= 1) {
+      OutputBuffer::appendUnsigned(value.m_raw, output);
+    } else {
+      *output << setprecision(static_cast<int>(m_precision)) << fixed;
+      OutputBuffer::appendFixed(value.m_value, static_cast<int>(m_precision), output);
+    }
+    return RESULT_OK;
+  }
+  if (m_divisor < 0) {
+    *output << fixed << setprecision(0);
+    OutputBuffer::appendFixed(value.m_value, 0, output);
+  } else if (m_divisor <= 1) {
+    int signedValue = static_cast<int>(value.m_value);
     if (hasFlag(FIX) && hasFlag(BCD)) {
       if (outputFormat & OF_JSON) {
         *output << '"' << setw(static_cast<int>(length * 2))
                 << setfill('0') << signedValue << setw(0) << '"';
         return RESULT_OK;
       }
-      *output << setw(static_cast<int>(length * 2)) << setfill('0');
+      *output << setw(static_cast<int>(length * 2)) << setfill('0') << signedValue << setw(0);
+      return RESULT_OK;
     }
-    *output << signedValue << setw(0);
+    OutputBuffer::appendInt(signedValue, output);
   } else {
-    *output << setprecision(static_cast<int>(m_precision))
-            << fixed << (static_cast<float>(signedValue) / static_cast<float>(m_divisor));
+    *output << setprecision(static_cast<int>(m_precision)) << fixed;
+    OutputBuffer::appendFixed(value.m_value, static_cast<int>(m_precision), output);
   }
   return RESULT_OK;
 }
@@ -30,6 +30,7 @@
 #include "lib/ebus/symbol.h"
 #include "lib/ebus/result.h"
 #include "lib/ebus/filereader.h"
+#include "lib/ebus/outputbuffer.h"
 
 namespace ebusd {
 
@@ -116,6 +117,36 @@ enum PartType {
   pt_slaveData,    //!< stored in slave data
 };
 
+/** the type of a @a NumericValue. */
+enum NumericValueType {
+  nv_none,   //!< no numeric value available (non-numeric type or invalid data)
+  nv_null,   //!< replacement value (or not a number)
+  nv_int,    //!< integral value
+  nv_float,  //!< floating point value
+  nv_enum,   //!< integral value with a known name in a value list
+  nv_raw,    //!< only the raw value is available as it is out of range
+};
+
+/**
+ * A numeric value decoded from a field without formatting.
+ */
+class NumericValue {
+ public:
+  /**
+   * Constructs a new instance without value.
+   */
+  NumericValue() : m_type(nv_none), m_raw(0), m_value(0) {}
+
+  /** the @a NumericValueType. */
+  NumericValueType m_type;
+
+  /** the raw value as read from the symbols. */
+  unsigned int m_raw;
+
+  /** the value with sign and divisor applied (0 for @a nv_none, @a nv_null, and @a nv_raw). */
+  double m_value;
+};
+
 /** bit flag for @a DataType: adjustable length, bitCount is maximum length. */
 #define ADJ 0x01
 
@@ -238,6 +269,17 @@ class DataType {
   virtual result_t readRawValue(size_t offset, size_t length, const SymbolString& input,
       unsigned int* value) const = 0;
 
+  /**
+   * Internal method for reading the numeric value from a @a SymbolString without formatting.
+   * @param offset the offset in the @a SymbolString.
+   * @param length the number of symbols to read.
+   * @param input the @a SymbolString to read the binary value from.
+   * @param value the @a NumericValue in which to store the value (of type @a nv_raw when out of range).
+   * @return @a RESULT_OK on success, @a RESULT_EMPTY for a non-numeric type, or an error code.
+   */
+  virtual result_t readValue(size_t offset, size_t length, const SymbolString& input,
+      NumericValue* value) const;
+
   /**
    * Internal method for reading the field from a @a SymbolString.
    * @param offset the offset in the data of the @a SymbolString.
@@ -479,6 +521,10 @@ class NumberDataType : public DataType {
   result_t readRawValue(size_t offset, size_t length, const SymbolString& input,
       unsigned int* value) const override;
 
+  // @copydoc
+  result_t readValue(size_t offset, size_t length, const SymbolString& input,
+      NumericValue* value) const override;
+
   // @copydoc
   result_t readSymbols(size_t offset, size_t length, const SymbolString& input,
       const OutputFormat outputFormat, ostream* output) const override;
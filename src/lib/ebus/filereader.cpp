@@ -18,6 +18,9 @@
 
 #include "lib/ebus/filereader.h"
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -25,10 +28,13 @@
 #include <climits>
 #include <fstream>
 #include <functional>
+#include <cstdio>
+#include <cstring>
 
 namespace ebusd {
 
 using std::ifstream;
+using std::ofstream;
 using std::ostringstream;
 using std::cout;
 using std::endl;
@@ -36,6 +42,51 @@ using std::setw;
 using std::dec;
 
 
+BufferStream::~BufferStream() {
+  if (m_owned) {
+    delete[] m_owned;
+    m_owned = nullptr;
+  }
+}
+
+BufferStream* BufferStream::readFile(const string& filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return nullptr;
+  }
+  size_t length = static_cast<size_t>(st.st_size);
+  if (length == 0) {
+    close(fd);
+    return new BufferStream("", 0);
+  }
+  // read instead of mapping the file, as accessing a mapping beyond a concurrent truncation raises SIGBUS
+  char* data = new char[length];
+  size_t pos = 0;
+  while (pos < length) {
+    ssize_t got = ::read(fd, data + pos, length - pos);
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got < 0) {
+      close(fd);
+      delete[] data;
+      return nullptr;
+    }
+    if (got == 0) {
+      break;  // truncated in the meantime
+    }
+    pos += static_cast<size_t>(got);
+  }
+  close(fd);
+  return new BufferStream(data, pos, true);
+}
+
+
 istream* FileReader::openFile(const string& filename, string* errorDescription, time_t* time) {
   struct stat st;
   if (stat(filename.c_str(), &st) != 0) {
@@ -46,12 +97,16 @@ istream* FileReader::openFile(const string& filename, string* errorDescription,
     *errorDescription = filename+" is a directory";
     return nullptr;
   }
-  ifstream* stream = new ifstream();
-  stream->open(filename.c_str(), ifstream::in);
-  if (!stream->is_open()) {
-    *errorDescription = filename;
-    delete(stream);
-    return nullptr;
+  istream* stream = S_ISREG(st.st_mode) ? BufferStream::readFile(filename) : nullptr;
+  if (!stream) {
+    ifstream* fileStream = new ifstream();
+    fileStream->open(filename.c_str(), ifstream::in);
+    if (!fileStream->is_open()) {
+      *errorDescription = filename;
+      delete(fileStream);
+      return nullptr;
+    }
+    stream = fileStream;
   }
   if (time) {
     *time = st.st_mtime;
@@ -61,6 +116,32 @@ istream* FileReader::openFile(const string& filename, string* errorDescription,
 
 result_t FileReader::readFromStream(istream* stream, const string& filename, const time_t& mtime, bool verbose,
     map<string, string>* defaults, string* errorDescription, bool replace, size_t* hash, size_t* size) {
+  CachedFileRows* cachedRows = m_cachedRows;
+  m_cachedRows = nullptr;
+  result_t result = RESULT_OK;
+  if (cachedRows && cachedRows->m_complete) {
+    if (hash) {
+      *hash = cachedRows->m_hash;
+    }
+    if (size) {
+      *size = cachedRows->m_size;
+    }
+    vector<string> row;
+    for (size_t index = 0; index < cachedRows->m_rows.size() && result == RESULT_OK; index++) {
+      row = cachedRows->m_rows[index];
+      result = addRow(filename, verbose, cachedRows->m_lineNos[index], &row, errorDescription, replace);
+    }
+    return result;
+  }
+  size_t localHash, localSize;
+  if (cachedRows) {
+    if (!hash) {
+      hash = &localHash;
+    }
+    if (!size) {
+      size = &localSize;
+    }
+  }
   if (hash) {
     *hash = 0;
   }
@@ -69,33 +150,69 @@ result_t FileReader::readFromStream(istream* stream, const string& filename, con
   }
   unsigned int lineNo = 0;
   vector<string> row;
-  result_t result = RESULT_OK;
-  while (stream->peek() != EOF && result == RESULT_OK) {
-    result = readLineFromStream(stream, filename, verbose, &lineNo, &row, errorDescription, replace, hash, size);
+  m_cachedRows = cachedRows;
+  BufferStream* bufferStream = dynamic_cast<BufferStream*>(stream);
+  if (bufferStream) {
+    const char* pos = bufferStream->getPos();
+    const char* end = bufferStream->getEnd();
+    while (pos < end && result == RESULT_OK) {
+      bool split = splitFields(&pos, end, &row, &lineNo, hash, size);
+      result = addSplitRow(split, filename, verbose, lineNo, &row, errorDescription, replace);
+    }
+    bufferStream->setPos(pos);
+  } else {
+    while (stream->peek() != EOF && result == RESULT_OK) {
+      result = readLineFromStream(stream, filename, verbose, &lineNo, &row, errorDescription, replace, hash, size);
+    }
+  }
+  m_cachedRows = nullptr;
+  if (cachedRows && result == RESULT_OK) {
+    cachedRows->m_hash = *hash;
+    cachedRows->m_size = *size;
+    cachedRows->m_complete = true;
   }
   return result;
 }
 
 result_t FileReader::readLineFromStream(istream* stream, const string& filename, bool verbose,
     unsigned int* lineNo, vector<string>* row, string* errorDescription, bool replace, size_t* hash, size_t* size) {
-  result_t result;
-  if (!splitFields(stream, row, lineNo, hash, size)) {
+  bool split = splitFields(stream, row, lineNo, hash, size);
+  return addSplitRow(split, filename, verbose, *lineNo, row, errorDescription, replace);
+}
+
+result_t FileReader::addSplitRow(bool split, const string& filename, bool verbose, unsigned int lineNo,
+    vector<string>* row, string* errorDescription, bool replace) {
+  if (!split) {
     *errorDescription = "blank line";
-    result = RESULT_ERR_EOF;
-  } else {
-    *errorDescription = "";
-    result = addFromFile(filename, *lineNo, row, errorDescription, replace);
+    string error;
+    formatError(filename, lineNo, RESULT_ERR_EOF, *errorDescription, &error);
+    *errorDescription = error;
+    if (verbose) {
+      cout << error << endl;
+    }
+    return RESULT_ERR_EOF;
   }
+  if (m_cachedRows) {
+    m_cachedRows->m_lineNos.push_back(lineNo);
+    m_cachedRows->m_rows.push_back(*row);
+  }
+  return addRow(filename, verbose, lineNo, row, errorDescription, replace);
+}
+
+result_t FileReader::addRow(const string& filename, bool verbose, unsigned int lineNo, vector<string>* row,
+    string* errorDescription, bool replace) {
+  *errorDescription = "";
+  result_t result = addFromFile(filename, lineNo, row, errorDescription, replace);
   if (result != RESULT_OK) {
     if (!errorDescription->empty()) {
       string error;
-      formatError(filename, *lineNo, result, *errorDescription, &error);
+      formatError(filename, lineNo, result, *errorDescription, &error);
       *errorDescription = error;
       if (verbose) {
         cout << error << endl;
       }
     } else if (!verbose) {
-      return formatError(filename, *lineNo, result, "", errorDescription);
+      return formatError(filename, lineNo, result, "", errorDescription);
     }
   } else if (!verbose) {
     *errorDescription = "";
@@ -118,34 +235,79 @@ void FileReader::tolower(string* str) {
   transform(str->begin(), str->end(), str->begin(), ::tolower);
 }
 
-static size_t hashFunction(const string& str) {
+static size_t hashFunction(const char* str, size_t length) {
   size_t hash = 0;
-  for (unsigned char c : str) {
-    hash = (31 * hash) ^ c;
+  for (size_t pos = 0; pos < length; pos++) {
+    hash = (31 * hash) ^ static_cast<unsigned char>(str[pos]);
   }
   return hash;
 }
 
-bool FileReader::splitFields(istream* stream, vector<string>* row, unsigned int* lineNo,
-    size_t* hash, size_t* size) {
+/**
+ * Left and right trim the character range equal to @a FileReader::trim().
+ * @param str the start of the range to trim (updated).
+ * @param length the length of the range to trim (updated).
+ */
+static void trimRange(const char** str, size_t* length) {
+  const char* start = *str;
+  const char* end = start + *length;
+  while (start < end && (*start == ' ' || *start == '\t')) {
+    start++;
+  }
+  if (start == end) {
+    return;  // nothing to trim without any other character
+  }
+  while (end[-1] == ' ' || end[-1] == '\t') {
+    end--;
+  }
+  *str = start;
+  *length = static_cast<size_t>(end - start);
+}
+
+/**
+ * Add the trimmed field to the row.
+ * @param field the field to add.
+ * @param row the @a vector to add the field to.
+ * @return whether the trimmed field is empty.
+ */
+static bool addTrimmedField(const string& field, vector<string>* row) {
+  const char* str = field.data();
+  size_t length = field.length();
+  trimRange(&str, &length);
+  row->emplace_back(str, length);
+  return length == 0;
+}
+
+/**
+ * Split the next line(s) into fields.
+ * @param getLine the function for getting the next line taking a pointer to the start and a pointer to the length of
+ * the line and returning false when there are no more lines left.
+ * @param row the @a vector to which to add the fields. This will be empty for completely empty and comment lines.
+ * @param lineNo the current line number (incremented with each line read).
+ * @param hash optional pointer to a @a size_t value for combining the hash of the line with, or nullptr.
+ * @param size optional pointer to a @a size_t value to add the trimmed line length to, or nullptr.
+ * @return true if there are more lines to read, false when there are no more lines left.
+ */
+template <typename GetLine>
+static bool splitLines(GetLine getLine, vector<string>* row, unsigned int* lineNo, size_t* hash, size_t* size) {
   row->clear();
-  string line;
+  const char* line;
+  size_t length;
   bool quotedText = false, wasQuoted = false;
-  ostringstream field;
+  string field;
   char prev = FIELD_SEPARATOR;
   bool empty = true, read = false;
-  while (getline(*stream, line)) {
+  while (getLine(&line, &length)) {
     read = true;
     ++(*lineNo);
-    trim(&line);
-    size_t length = line.size();
+    trimRange(&line, &length);
     if (size) {
       *size += length + 1;  // normalized with trailing endl
     }
     if (hash) {
-      *hash ^= (hashFunction(line) ^ (length << (7 * (*lineNo % 5)))) & 0xffffffff;
+      *hash ^= (hashFunction(line, length) ^ (length << (7 * (*lineNo % 5)))) & 0xffffffff;
     }
-    if (!quotedText && (length == 0 || line[0] == '#' || (line.length() > 1 && line[0] == '/' && line[1] == '/'))) {
+    if (!quotedText && (length == 0 || line[0] == '#' || (length > 1 && line[0] == '/' && line[1] == '/'))) {
       if (*lineNo == 1) {
         break;  // keep empty first line for applying default header
       }
@@ -156,38 +318,35 @@ bool FileReader::splitFields(istream* stream, vector<string>* row, unsigned int*
       switch (ch) {
       case FIELD_SEPARATOR:
         if (quotedText) {
-          field << ch;
+          field.push_back(ch);
         } else {
-          string str = field.str();
-          trim(&str);
-          empty &= str.empty();
-          row->push_back(str);
-          field.str("");
+          empty &= addTrimmedField(field, row);
+          field.clear();
           wasQuoted = false;
         }
         break;
       case TEXT_SEPARATOR:
         if (prev == TEXT_SEPARATOR && !quotedText) {  // double dquote
-          field << ch;
+          field.push_back(ch);
           quotedText = true;
         } else if (quotedText) {
           quotedText = false;
         } else if (prev == FIELD_SEPARATOR) {
           quotedText = wasQuoted = true;
         } else {
-          field << ch;
+          field.push_back(ch);
         }
         break;
       case '\r':
         break;
       default:
         if (prev == TEXT_SEPARATOR && !quotedText && wasQuoted) {
-          field << TEXT_SEPARATOR;  // single dquote in the middle of formerly quoted text
+          field.push_back(TEXT_SEPARATOR);  // single dquote in the middle of formerly quoted text
           quotedText = true;
-        } else if (quotedText && pos == 0 && field.tellp() > 0 && *(field.str().end()-1) != VALUE_SEPARATOR) {
-          field << VALUE_SEPARATOR;  // add separator in between multiline field parts
+        } else if (quotedText && pos == 0 && !field.empty() && field.back() != VALUE_SEPARATOR) {
+          field.push_back(VALUE_SEPARATOR);  // add separator in between multiline field parts
         }
-        field << ch;
+        field.push_back(ch);
         break;
       }
       prev = ch;
@@ -196,16 +355,45 @@ bool FileReader::splitFields(istream* stream, vector<string>* row, unsigned int*
       break;
     }
   }
-  string str = field.str();
-  trim(&str);
-  if (empty && str.empty()) {
+  if (addTrimmedField(field, row) && empty) {
     row->clear();
     return read;
   }
-  row->push_back(str);
   return true;
 }
 
+bool FileReader::splitFields(istream* stream, vector<string>* row, unsigned int* lineNo,
+    size_t* hash, size_t* size) {
+  string buffer;
+  return splitLines([stream, &buffer](const char** line, size_t* length) {
+    if (!getline(*stream, buffer)) {
+      return false;
+    }
+    *line = buffer.data();
+    *length = buffer.length();
+    return true;
+  }, row, lineNo, hash, size);
+}
+
+bool FileReader::splitFields(const char** pos, const char* end, vector<string>* row, unsigned int* lineNo,
+    size_t* hash, size_t* size) {
+  return splitLines([pos, end](const char** line, size_t* length) {
+    const char* start = *pos;
+    if (start >= end) {
+      return false;
+    }
+    const char* lineEnd = static_cast<const char*>(memchr(start, '\n', static_cast<size_t>(end - start)));
+    if (lineEnd) {
+      *pos = lineEnd + 1;
+    } else {
+      *pos = lineEnd = end;
+    }
+    *line = start;
+    *length = static_cast<size_t>(lineEnd - start);
+    return true;
+  }, row, lineNo, hash, size);
+}
+
 result_t FileReader::formatError(const string& filename, unsigned int lineNo, result_t result,
     const string& error, string* errorDescription) {
   ostringstream str;
@@ -221,6 +409,255 @@ result_t FileReader::formatError(const string& filename, unsigned int lineNo, re
 }
 
 
+void FileSplitter::run() {
+  RowRecorder recorder;
+  string errorDescription;
+  size_t index;
+  while ((index = (*m_next)++) < m_files.size()) {
+    const string path = m_prefix + m_files[index];
+    CachedFileRows* rows = &(*m_rows)[index];
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+      continue;
+    }
+    istream* stream = FileReader::openFile(path, &errorDescription);
+    if (!stream) {
+      continue;
+    }
+    rows->m_stamp = static_cast<uint64_t>(st.st_mtim.tv_sec)*1000000000ULL
+        + static_cast<uint64_t>(st.st_mtim.tv_nsec);
+    rows->m_fileSize = static_cast<size_t>(st.st_size);
+    recorder.setCachedRows(rows);
+    recorder.readFromStream(stream, m_files[index], st.st_mtime, false, nullptr, &errorDescription);
+    delete(stream);
+  }
+}
+
+size_t FileSplitter::splitFiles(const string& prefix, const vector<string>& files, size_t maxThreads,
+    map<string, CachedFileRows>* rows) {
+  size_t count = maxThreads > files.size() ? files.size() : maxThreads;
+  vector<CachedFileRows> split(files.size());
+  std::atomic<size_t> next(0);
+  vector<FileSplitter*> splitters;
+  for (size_t i = 0; i < count; i++) {
+    FileSplitter* splitter = new FileSplitter(prefix, files, &split, &next);
+    if (splitter->start("filesplitter")) {
+      splitters.push_back(splitter);
+    } else {
+      delete splitter;
+    }
+  }
+  for (auto splitter : splitters) {
+    splitter->join();
+    delete splitter;
+  }
+  for (size_t index = 0; index < files.size(); index++) {
+    if (split[index].m_complete) {
+      (*rows)[files[index]] = std::move(split[index]);
+    }
+  }
+  return splitters.size();
+}
+
+
+/** the magic at the beginning of the binary file of the @a FileRowsCache. */
+#define ROWS_CACHE_MAGIC "ebusdrow"
+
+/** the version of the binary file format of the @a FileRowsCache (to be increased on each change). */
+#define ROWS_CACHE_VERSION 1
+
+/**
+ * Append a number in native byte order to the binary cache.
+ * @param value the number to append.
+ * @param out the @a string to append to.
+ */
+template <typename T>
+static void appendBinary(T value, string* out) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * Append a string with its length to the binary cache.
+ * @param value the @a string to append.
+ * @param out the @a string to append to.
+ */
+static void appendBinary(const string& value, string* out) {
+  appendBinary(static_cast<uint32_t>(value.length()), out);
+  out->append(value);
+}
+
+/**
+ * Read a number in native byte order from the binary cache.
+ * @param in the @a string to read from.
+ * @param pos the position to read from (updated on success).
+ * @param value the variable to store the number in.
+ * @return true on success, false if the data is too short.
+ */
+template <typename T>
+static bool readBinary(const string& in, size_t* pos, T* value) {
+  if (in.length() - *pos < sizeof(T)) {
+    return false;
+  }
+  memcpy(value, in.data() + *pos, sizeof(T));
+  *pos += sizeof(T);
+  return true;
+}
+
+/**
+ * Read a string with its length from the binary cache.
+ * @param in the @a string to read from.
+ * @param pos the position to read from (updated on success).
+ * @param value the @a string to store the read value in.
+ * @return true on success, false if the data is too short.
+ */
+static bool readBinary(const string& in, size_t* pos, string* value) {
+  uint32_t length;
+  if (!readBinary(in, pos, &length) || in.length() - *pos < length) {
+    return false;
+  }
+  value->assign(in, *pos, length);
+  *pos += length;
+  return true;
+}
+
+bool FileRowsCache::load() {
+  m_files.clear();
+  m_used.clear();
+  m_modified = false;
+  if (m_filename.empty()) {
+    return false;
+  }
+  ifstream stream(m_filename.c_str(), ifstream::in | ifstream::binary);
+  if (!stream.is_open()) {
+    return false;
+  }
+  ostringstream content;
+  content << stream.rdbuf();
+  const string in = content.str();
+  size_t pos = strlen(ROWS_CACHE_MAGIC);
+  uint32_t version = 0, byteOrder = 0, fileCount = 0;
+  if (in.compare(0, pos, ROWS_CACHE_MAGIC) != 0 || !readBinary(in, &pos, &version) || version != ROWS_CACHE_VERSION
+      || !readBinary(in, &pos, &byteOrder) || byteOrder != 0x01020304 || !readBinary(in, &pos, &fileCount)) {
+    return false;
+  }
+  for (uint32_t fileIndex = 0; fileIndex < fileCount; fileIndex++) {
+    string name;
+    uint64_t stamp, fileSize, hash, size;
+    uint32_t rowCount;
+    if (!readBinary(in, &pos, &name) || !readBinary(in, &pos, &stamp) || !readBinary(in, &pos, &fileSize)
+        || !readBinary(in, &pos, &hash) || !readBinary(in, &pos, &size) || !readBinary(in, &pos, &rowCount)) {
+      m_files.clear();
+      return false;
+    }
+    CachedFileRows& rows = m_files[name];
+    rows.m_stamp = stamp;
+    rows.m_fileSize = static_cast<size_t>(fileSize);
+    rows.m_hash = static_cast<size_t>(hash);
+    rows.m_size = static_cast<size_t>(size);
+    rows.m_lineNos.resize(rowCount);
+    rows.m_rows.resize(rowCount);
+    for (uint32_t rowIndex = 0; rowIndex < rowCount; rowIndex++) {
+      uint32_t fieldCount;
+      if (!readBinary(in, &pos, &rows.m_lineNos[rowIndex]) || !readBinary(in, &pos, &fieldCount)
+          || fieldCount > in.length() - pos) {
+        m_files.clear();
+        return false;
+      }
+      vector<string>& row = rows.m_rows[rowIndex];
+      row.resize(fieldCount);
+      for (auto& field : row) {
+        if (!readBinary(in, &pos, &field)) {
+          m_files.clear();
+          return false;
+        }
+      }
+    }
+    rows.m_complete = true;
+  }
+  return pos == in.length();
+}
+
+bool FileRowsCache::save() {
+  for (auto it = m_files.begin(); it != m_files.end(); ) {
+    if (m_used.find(it->first) == m_used.end()) {
+      it = m_files.erase(it);  // no longer loaded, e.g. after a device was replaced
+      m_modified = true;
+    } else {
+      it++;
+    }
+  }
+  if (!m_modified || m_filename.empty()) {
+    return true;
+  }
+  string out = ROWS_CACHE_MAGIC;
+  appendBinary(static_cast<uint32_t>(ROWS_CACHE_VERSION), &out);
+  appendBinary(static_cast<uint32_t>(0x01020304), &out);
+  appendBinary(static_cast<uint32_t>(m_files.size()), &out);
+  for (const auto& it : m_files) {
+    const CachedFileRows& rows = it.second;
+    appendBinary(it.first, &out);
+    appendBinary(rows.m_stamp, &out);
+    appendBinary(static_cast<uint64_t>(rows.m_fileSize), &out);
+    appendBinary(static_cast<uint64_t>(rows.m_hash), &out);
+    appendBinary(static_cast<uint64_t>(rows.m_size), &out);
+    appendBinary(static_cast<uint32_t>(rows.m_rows.size()), &out);
+    for (size_t rowIndex = 0; rowIndex < rows.m_rows.size(); rowIndex++) {
+      const vector<string>& row = rows.m_rows[rowIndex];
+      appendBinary(static_cast<uint32_t>(rows.m_lineNos[rowIndex]), &out);
+      appendBinary(static_cast<uint32_t>(row.size()), &out);
+      for (const auto& field : row) {
+        appendBinary(field, &out);
+      }
+    }
+  }
+  // write to a temporary file first in order to not leave a partially written cache behind
+  const string tempName = m_filename + ".tmp";
+  ofstream stream(tempName.c_str(), ofstream::out | ofstream::binary | ofstream::trunc);
+  if (!stream.is_open()) {
+    return false;
+  }
+  stream.write(out.data(), static_cast<std::streamsize>(out.length()));
+  stream.close();
+  if (stream.fail() || rename(tempName.c_str(), m_filename.c_str()) != 0) {
+    remove(tempName.c_str());
+    return false;
+  }
+  m_modified = false;
+  return true;
+}
+
+CachedFileRows* FileRowsCache::get(const string& name, uint64_t stamp, size_t fileSize) {
+  auto it = m_files.find(name);
+  if (it == m_files.end() || !it->second.m_complete || it->second.m_stamp != stamp
+      || it->second.m_fileSize != fileSize) {
+    return nullptr;
+  }
+  m_used.insert(name);
+  return &it->second;
+}
+
+CachedFileRows* FileRowsCache::prepare(const string& name, uint64_t stamp, size_t fileSize) {
+  CachedFileRows& rows = m_files[name];
+  rows = CachedFileRows();
+  rows.m_stamp = stamp;
+  rows.m_fileSize = fileSize;
+  return &rows;
+}
+
+void FileRowsCache::commit(const string& name) {
+  auto it = m_files.find(name);
+  if (it == m_files.end()) {
+    return;
+  }
+  if (it->second.m_complete) {
+    m_used.insert(name);
+    m_modified = true;
+  } else {
+    m_files.erase(it);
+  }
+}
+
+
 const string MappedFileReader::normalizeLanguage(const string& lang) {
   string normLang = lang;
   tolower(&normLang);
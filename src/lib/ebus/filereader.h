@@ -20,7 +20,9 @@
 #define LIB_EBUS_FILEREADER_H_
 
 #include <algorithm>
+#include <atomic>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <iomanip>
@@ -60,6 +62,127 @@ using std::istream;
 /** special marker string for skipping columns in @a MappedFileReader. */
 static const char SKIP_COLUMN[] = "\b";
 
+/**
+ * An @a istream reading from memory, i.e. from the read content of a file or from a buffer owned by the caller, that allows
+ * the @a FileReader to split the fields directly from the buffer.
+ */
+class BufferStream : public istream {
+ public:
+  /**
+   * Constructor.
+   * @param data the buffer to read from (has to stay valid during the lifetime of this instance).
+   * @param length the length of the buffer.
+   * @param owned true if the buffer was allocated with new[] and has to be deleted by this instance.
+   */
+  BufferStream(const char* data, size_t length, bool owned = false)
+    : istream(nullptr), m_buffer(data, length), m_owned(owned ? data : nullptr) {
+    rdbuf(&m_buffer);
+  }
+
+  /**
+   * Destructor.
+   */
+  virtual ~BufferStream();
+
+  /**
+   * Read the content of a file at once into a @a BufferStream.
+   * @param filename the name of the file to read.
+   * @return the @a BufferStream on success, or nullptr on error (e.g. if the file is not a regular file).
+   */
+  static BufferStream* readFile(const string& filename);
+
+  /**
+   * @return the current read position.
+   */
+  const char* getPos() const { return m_buffer.getPos(); }
+
+  /**
+   * @return the end of the buffer.
+   */
+  const char* getEnd() const { return m_buffer.getEnd(); }
+
+  /**
+   * Set the current read position.
+   * @param pos the new read position (between the current position and the end of the buffer).
+   */
+  void setPos(const char* pos) { m_buffer.setPos(pos); }
+
+
+ private:
+  /**
+   * The @a streambuf reading from the buffer.
+   */
+  class Buffer : public std::streambuf {
+   public:
+    /**
+     * Constructor.
+     * @param data the buffer to read from.
+     * @param length the length of the buffer.
+     */
+    Buffer(const char* data, size_t length) {
+      char* start = const_cast<char*>(data);
+      setg(start, start, start + length);
+    }
+
+    /**
+     * @return the current read position.
+     */
+    const char* getPos() const { return gptr(); }
+
+    /**
+     * @return the end of the buffer.
+     */
+    const char* getEnd() const { return egptr(); }
+
+    /**
+     * Set the current read position.
+     * @param pos the new read position.
+     */
+    void setPos(const char* pos) { setg(eback(), const_cast<char*>(pos), egptr()); }
+  };
+
+  /** the @a Buffer used as @a streambuf. */
+  Buffer m_buffer;
+
+  /** the buffer to delete, or nullptr. */
+  const char* m_owned;
+};
+
+
+/**
+ * The split rows of a single file read by a @a FileReader that allow adding the definitions again without parsing the
+ * file.
+ */
+class CachedFileRows {
+ public:
+  /**
+   * Constructor.
+   */
+  CachedFileRows() : m_stamp(0), m_fileSize(0), m_hash(0), m_size(0), m_complete(false) {}
+
+  /** the modification time of the file in nanoseconds since the epoch. */
+  uint64_t m_stamp;
+
+  /** the size of the file in bytes. */
+  size_t m_fileSize;
+
+  /** the hash of the file. */
+  size_t m_hash;
+
+  /** the normalized size of the file. */
+  size_t m_size;
+
+  /** the line number of each row. */
+  vector<unsigned int> m_lineNos;
+
+  /** the fields of each row. */
+  vector< vector<string> > m_rows;
+
+  /** whether all rows of the file were read successfully. */
+  bool m_complete;
+};
+
+
 /**
  * An abstract class that support reading definitions from a file.
  */
@@ -68,7 +191,7 @@ class FileReader {
   /**
    * Constructor.
    */
-  FileReader() {}
+  FileReader() : m_cachedRows(nullptr) {}
 
   /**
    * Destructor.
@@ -76,7 +199,7 @@ class FileReader {
   virtual ~FileReader() {}
 
   /**
-   * Open a file as stream for reading.
+   * Open a file as stream for reading (read at once into a @a BufferStream if possible).
    * @param filename the name of the file being read.
    * @param errorDescription a string in which to store the error description in case of error.
    * @param time optional pointer to a @a time_t value for storing the modification time of the file, or nullptr.
@@ -117,6 +240,13 @@ class FileReader {
   virtual result_t readLineFromStream(istream* stream, const string& filename, bool verbose,
       unsigned int* lineNo, vector<string>* row, string* errorDescription, bool replace, size_t* hash, size_t* size);
 
+  /**
+   * Set the @a CachedFileRows to use for the next call to @a readFromStream().
+   * @param rows the complete @a CachedFileRows to add instead of reading from the (then unused) stream, the empty
+   * @a CachedFileRows to record the rows read from the stream to, or nullptr.
+   */
+  void setCachedRows(CachedFileRows* rows) { m_cachedRows = rows; }
+
   /**
    * Add a definition that was read from a file.
    * @param filename the name of the file being read.
@@ -153,6 +283,19 @@ class FileReader {
   static bool splitFields(istream* stream, vector<string>* row, unsigned int* lineNo,
       size_t* hash = nullptr, size_t* size = nullptr);
 
+  /**
+   * Split the next line(s) from the buffer into fields.
+   * @param pos the current position in the buffer (updated to the beginning of the next line).
+   * @param end the end of the buffer.
+   * @param row the @a vector to which to add the fields. This will be empty for completely empty and comment lines.
+   * @param lineNo the current line number (incremented with each line read).
+   * @param hash optional pointer to a @a size_t value for combining the hash of the line with, or nullptr.
+   * @param size optional pointer to a @a size_t value to add the trimmed line length to, or nullptr.
+   * @return true if there are more lines to read, false when there are no more lines left.
+   */
+  static bool splitFields(const char** pos, const char* end, vector<string>* row, unsigned int* lineNo,
+      size_t* hash = nullptr, size_t* size = nullptr);
+
   /**
    * Format the specified hash as 8 hex digits to the output stream.
    * @param hash the hash code.
@@ -173,6 +316,174 @@ class FileReader {
    */
   static result_t formatError(const string& filename, unsigned int lineNo, result_t result,
       const string& error, string* errorDescription);
+
+ private:
+  /**
+   * Add a single split row and format the error description.
+   * @param filename the name of the file being read.
+   * @param verbose whether to verbosely log problems.
+   * @param lineNo the line number of the row.
+   * @param row the definition row (allowed to be modified).
+   * @param errorDescription a string in which to store the error description in case of error.
+   * @param replace whether to replace an already existing entry.
+   * @return @a RESULT_OK on success, or an error code.
+   */
+  result_t addRow(const string& filename, bool verbose, unsigned int lineNo, vector<string>* row,
+      string* errorDescription, bool replace);
+
+  /**
+   * Add the row split from the next line(s).
+   * @param split the result of @a splitFields().
+   * @param filename the name of the file being read.
+   * @param verbose whether to verbosely log problems.
+   * @param lineNo the current line number.
+   * @param row the split definition row (allowed to be modified).
+   * @param errorDescription a string in which to store the error description in case of error.
+   * @param replace whether to replace an already existing entry.
+   * @return @a RESULT_OK on success, or an error code.
+   */
+  result_t addSplitRow(bool split, const string& filename, bool verbose, unsigned int lineNo, vector<string>* row,
+      string* errorDescription, bool replace);
+
+  /** the @a CachedFileRows to add from or record to, or nullptr. */
+  CachedFileRows* m_cachedRows;
+};
+
+
+/**
+ * A @a FileReader only recording the split rows of a file.
+ */
+class RowRecorder : public FileReader {
+ public:
+  // @copydoc
+  result_t addFromFile(const string& filename, unsigned int lineNo, vector<string>* row,
+      string* errorDescription, bool replace) override {
+    return RESULT_OK;
+  }
+};
+
+
+/**
+ * A @a Thread splitting files into @a CachedFileRows together with other instances.
+ */
+class FileSplitter : public Thread {
+ public:
+  /**
+   * Constructor.
+   * @param prefix the prefix to put in front of each file name for opening the file.
+   * @param files the names of the files to split.
+   * @param rows the @a CachedFileRows to fill for each file (same size as @a files).
+   * @param next the index of the next file to split shared by all instances.
+   */
+  FileSplitter(const string& prefix, const vector<string>& files, vector<CachedFileRows>* rows,
+      std::atomic<size_t>* next)
+    : Thread(), m_prefix(prefix), m_files(files), m_rows(rows), m_next(next) {}
+
+  /**
+   * Split files in parallel into @a CachedFileRows for being added afterwards in the usual order.
+   * @param prefix the prefix to put in front of each file name for opening the file.
+   * @param files the names of the files to split.
+   * @param maxThreads the maximum number of threads to use.
+   * @param rows the @a map in which to store the @a CachedFileRows of each completely split file by name.
+   * @return the number of threads used.
+   */
+  static size_t splitFiles(const string& prefix, const vector<string>& files, size_t maxThreads,
+      map<string, CachedFileRows>* rows);
+
+
+ protected:
+  // @copydoc
+  void run() override;
+
+
+ private:
+  /** the prefix to put in front of each file name for opening the file. */
+  const string m_prefix;
+
+  /** the names of the files to split. */
+  const vector<string>& m_files;
+
+  /** the @a CachedFileRows to fill for each file. */
+  vector<CachedFileRows>* m_rows;
+
+  /** the index of the next file to split shared by all instances. */
+  std::atomic<size_t>* m_next;
+};
+
+
+/**
+ * A cache of @a CachedFileRows by file name that is stored in a binary file.
+ */
+class FileRowsCache {
+ public:
+  /**
+   * Constructor.
+   * @param filename the name of the binary file, or empty to keep the cache in memory only.
+   */
+  explicit FileRowsCache(const string& filename = "") : m_filename(filename), m_modified(false) {}
+
+  /**
+   * Destructor.
+   */
+  virtual ~FileRowsCache() {}
+
+  /**
+   * Load the cache from the binary file.
+   * @return true on success, false if the file was missing, invalid, or written by a different version.
+   */
+  bool load();
+
+  /**
+   * Save the cache to the binary file if it was modified, dropping the files that were neither got nor committed since
+   * loading.
+   * @return true on success or when unmodified, false on error.
+   */
+  bool save();
+
+  /**
+   * Get the complete @a CachedFileRows for a file.
+   * @param name the name of the file.
+   * @param stamp the current modification time of the file in nanoseconds since the epoch (or the hash of the content
+   * if the modification time is not reliable).
+   * @param fileSize the current size of the file in bytes.
+   * @return the complete @a CachedFileRows matching the modification time and size, or nullptr.
+   */
+  CachedFileRows* get(const string& name, uint64_t stamp, size_t fileSize);
+
+  /**
+   * Prepare new empty @a CachedFileRows for a file replacing the previous ones.
+   * @param name the name of the file.
+   * @param stamp the modification time of the file in nanoseconds since the epoch (or the hash of the content if the
+   * modification time is not reliable).
+   * @param fileSize the size of the file in bytes.
+   * @return the empty @a CachedFileRows to be recorded by @a FileReader::readFromStream().
+   */
+  CachedFileRows* prepare(const string& name, uint64_t stamp, size_t fileSize);
+
+  /**
+   * Mark the cache as modified when the prepared @a CachedFileRows were completed, or remove them otherwise.
+   * @param name the name of the file.
+   */
+  void commit(const string& name);
+
+  /**
+   * @return the number of cached files.
+   */
+  size_t size() const { return m_files.size(); }
+
+
+ private:
+  /** the name of the binary file, or empty. */
+  const string m_filename;
+
+  /** the @a CachedFileRows by file name. */
+  map<string, CachedFileRows> m_files;
+
+  /** whether the cache was modified since being loaded. */
+  bool m_modified;
+
+  /** the names of the files got or committed since loading (the ones to keep when saving). */
+  std::set<string> m_used;
 };
 
 
@@ -291,8 +602,8 @@ class MappedFileReader : public FileReader {
   static const string combineRow(const map<string, string>& row);
 
  protected:
-  /** a @a Mutex for access to defaults. */
-  Mutex m_mutex;
+  /** a @a SharedMutex for access to defaults and the data of derived classes. */
+  SharedMutex m_mutex;
 
  private:
   /** whether this instance supports rows with defaults (starting with a star). */
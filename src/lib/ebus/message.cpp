@@ -24,6 +24,7 @@
 #include <iomanip>
 #include <climits>
 #include "lib/ebus/data.h"
+#include "lib/ebus/outputbuffer.h"
 #include "lib/ebus/result.h"
 #include "lib/ebus/symbol.h"
 
@@ -42,8 +43,8 @@ using std::endl;
 /** the bit mask of the source master number in the message key. */
 #define ID_SOURCE_MASK (0x1fLL << (8 * 7))
 
-/** the bit mask for the ID length and combined ID bytes in the message key. */
-#define ID_LENGTH_AND_IDS_MASK ((7LL << (8 * 7 + 5)) | 0xffffffffLL)
+/** the bit mask for the combined ID bytes in the message key. */
+#define ID_IDS_MASK 0xffffffffLL
 
 /** the bits in the @a ID_SOURCE_MASK for arbitrary source and active write message. */
 #define ID_SOURCE_ACTIVE_WRITE (0x1fLL << (8 * 7))
@@ -66,6 +67,12 @@ using std::endl;
 /** special value for invalid message key. */
 #define INVALID_KEY 0xffffffffffffffffLL
 
+/** the maximum number of cached decoded values per @a Message. */
+#define MAX_DECODE_CACHE_ENTRIES 4
+
+/** the maximum number of entries kept in the @a MessageJournal. */
+#define MAX_JOURNAL_ENTRIES 4096
+
 /** the maximum poll priority for a @a Message referred to by a @a Condition. */
 #define POLL_PRIORITY_CONDITION 5
 
@@ -94,6 +101,12 @@ static const char* defaultMessageFieldMap[] = {  // access level not included in
 /** the m_pollOrder of the last polled message. */
 static unsigned int g_lastPollOrder = 0;
 
+/**
+ * the @a Mutex for the dependencies between @a Message and @a Condition instances, which are added while resolving
+ * conditions and followed on every data change.
+ */
+static Mutex s_dependencyMutex;
+
 extern DataFieldTemplates* getTemplates(const string& filename);
 
 extern result_t loadDefinitionsFromConfigPath(FileReader* reader, const string& filename, bool verbose,
@@ -114,7 +127,9 @@ Message::Message(const string& circuit, const string& level, const string& name,
       m_data(data), m_deleteData(deleteData),
       m_pollPriority(pollPriority),
       m_usedByCondition(false), m_isScanMessage(false), m_condition(condition),
-      m_lastUpdateTime(0), m_lastChangeTime(0), m_pollOrder(0), m_lastPollTime(0) {
+      m_lastUpdateTime(0), m_lastChangeTime(0), m_pollOrder(0), m_lastPollTime(0),
+      m_journal(nullptr), m_lastUpdateSequence(0), m_lastChangeSequence(0), m_dataVersion(0),
+      m_lastValuesVersion(0) {
   if (circuit == "scan") {
     setScanMessage();
     m_pollPriority = 0;
@@ -131,7 +146,9 @@ Message::Message(const string& circuit, const string& level, const string& name,
       m_data(data), m_deleteData(deleteData),
       m_pollPriority(0),
       m_usedByCondition(false), m_isScanMessage(true), m_condition(nullptr),
-      m_lastUpdateTime(0), m_lastChangeTime(0), m_pollOrder(0), m_lastPollTime(0) {
+      m_lastUpdateTime(0), m_lastChangeTime(0), m_pollOrder(0), m_lastPollTime(0),
+      m_journal(nullptr), m_lastUpdateSequence(0), m_lastChangeSequence(0), m_dataVersion(0),
+      m_lastValuesVersion(0) {
 }
 
 
@@ -645,6 +662,37 @@ void Message::setUsedByCondition() {
   }
 }
 
+void Message::addDependentCondition(Condition* condition) {
+  s_dependencyMutex.lock();
+  bool found = false;
+  for (const auto check : m_dependentConditions) {
+    if (check == condition) {
+      found = true;
+      break;
+    }
+  }
+  if (!found) {
+    m_dependentConditions.push_back(condition);
+    condition->invalidate();
+  }
+  s_dependencyMutex.unlock();
+}
+
+void Message::clearDependentConditions() {
+  s_dependencyMutex.lock();
+  m_dependentConditions.clear();
+  s_dependencyMutex.unlock();
+}
+
+void Message::dataChanged() {
+  m_dataVersion++;
+  s_dependencyMutex.lock();
+  for (const auto condition : m_dependentConditions) {
+    condition->invalidate();
+  }
+  s_dependencyMutex.unlock();
+}
+
 bool Message::isAvailable() {
   return (m_condition == nullptr) || m_condition->isTrue();
 }
@@ -709,10 +757,13 @@ result_t Message::prepareSlave(istringstream* input, SlaveSymbolString* slave) {
   }
   slave->adjustHeader();
   time(&m_lastUpdateTime);
-  if (*slave != m_lastSlaveData) {
+  bool changed = *slave != m_lastSlaveData;
+  if (changed) {
     m_lastChangeTime = m_lastUpdateTime;
     m_lastSlaveData = *slave;
+    dataChanged();
   }
+  journalUpdate(changed);
   return result;
 }
 
@@ -725,57 +776,135 @@ result_t Message::storeLastData(const MasterSymbolString& master, const SlaveSym
 }
 
 result_t Message::storeLastData(size_t index, const MasterSymbolString& data) {
+  bool updated = false, changed = false;
   if (data.size() > 0 && (m_isWrite || this->m_dstAddress == BROADCAST || isMaster(this->m_dstAddress)
       || data.getDataSize() + 2 > m_id.size())) {
     time(&m_lastUpdateTime);
+    updated = true;
   }
   switch (data.compareTo(m_lastMasterData)) {
   case 1:  // completely different
     m_lastChangeTime = m_lastUpdateTime;
     m_lastMasterData = data;
+    dataChanged();
+    changed = true;
     break;
   case 2:  // only master address is different
     m_lastMasterData = data;
+    dataChanged();
     break;
   // else: identical
   }
+  if (updated || changed) {
+    journalUpdate(changed);
+  }
   return RESULT_OK;
 }
 
 result_t Message::storeLastData(size_t index, const SlaveSymbolString& data) {
+  bool updated = false, changed = false;
   if (data.size() > 0) {
     time(&m_lastUpdateTime);
+    updated = true;
   }
   if (m_lastSlaveData != data) {
     m_lastChangeTime = m_lastUpdateTime;
     m_lastSlaveData = data;
+    dataChanged();
+    changed = true;
+  }
+  if (updated || changed) {
+    journalUpdate(changed);
   }
   return RESULT_OK;
 }
 
+void Message::journalUpdate(bool changed) {
+  if (m_journal) {
+    m_journal->add(this, changed);
+  }
+}
+
 result_t Message::decodeLastData(bool master, bool leadingSeparator, const char* fieldName,
     ssize_t fieldIndex, OutputFormat outputFormat, ostream* output) const {
-  result_t result;
-  if (master) {
-    result = m_data->read(m_lastMasterData, getIdLength(), leadingSeparator, fieldName, fieldIndex,
-        outputFormat, -1, output);
-  } else {
-    result = m_data->read(m_lastSlaveData, 0, leadingSeparator, fieldName, fieldIndex,
-        outputFormat, -1, output);
-  }
-  if (result < RESULT_OK) {
-    return result;
-  }
-  if (result == RESULT_EMPTY && (fieldName != nullptr || fieldIndex >= 0)) {
-    return RESULT_ERR_NOTFOUND;
-  }
-  return result;
+  return decodeLastDataCached(master ? pt_masterData : pt_slaveData, leadingSeparator, fieldName, fieldIndex,
+      outputFormat, output);
 }
 
 result_t Message::decodeLastData(bool leadingSeparator, const char* fieldName,
     ssize_t fieldIndex, const OutputFormat outputFormat, ostream* output) const {
+  return decodeLastDataCached(pt_any, leadingSeparator, fieldName, fieldIndex, outputFormat, output);
+}
+
+result_t Message::decodeLastDataCached(PartType partType, bool leadingSeparator, const char* fieldName,
+    ssize_t fieldIndex, OutputFormat outputFormat, ostream* output) const {
+  unsigned int dataVersion = m_dataVersion;  // taken before decoding so that a concurrent change is not hidden
+  m_decodeCacheMutex.lock();
+  DecodeCacheEntry* entry = nullptr;
+  for (auto& check : m_decodeCache) {
+    if (check.m_partType == partType && check.m_leadingSeparator == leadingSeparator
+        && check.m_fieldIndex == fieldIndex && check.m_outputFormat == outputFormat
+        && check.m_hasFieldName == (fieldName != nullptr) && (!fieldName || check.m_fieldName == fieldName)) {
+      if (check.m_dataVersion == dataVersion) {
+        OutputBuffer::append(check.m_output, output);
+        result_t result = check.m_result;
+        m_decodeCacheMutex.unlock();
+        return result;
+      }
+      entry = &check;
+      break;
+    }
+    if (!entry && check.m_dataVersion != dataVersion) {
+      entry = &check;  // outdated, so reuse it unless there is an entry for the same options
+    }
+  }
+  static thread_local OutputBuffer decoded;
+  decoded.reset();
+  result_t result = decodeLastDataUncached(partType, leadingSeparator, fieldName, fieldIndex, outputFormat,
+      &decoded);
+  OutputBuffer::append(decoded.str(), output);
+  if (result >= RESULT_OK) {
+    if (!entry) {
+      if (m_decodeCache.size() < MAX_DECODE_CACHE_ENTRIES) {
+        m_decodeCache.resize(m_decodeCache.size() + 1);
+      }
+      entry = &m_decodeCache.back();
+    }
+    entry->m_dataVersion = dataVersion;
+    entry->m_partType = partType;
+    entry->m_leadingSeparator = leadingSeparator;
+    entry->m_hasFieldName = fieldName != nullptr;
+    entry->m_fieldName = fieldName ? fieldName : "";
+    entry->m_fieldIndex = fieldIndex;
+    entry->m_outputFormat = outputFormat;
+    entry->m_result = result;
+    entry->m_output = decoded.str();
+  }
+  m_decodeCacheMutex.unlock();
+  return result;
+}
+
+result_t Message::decodeLastDataUncached(PartType partType, bool leadingSeparator, const char* fieldName,
+    ssize_t fieldIndex, OutputFormat outputFormat, ostream* output) const {
+  result_t result;
+  if (partType != pt_any) {
+    if (partType == pt_masterData) {
+      result = m_data->read(m_lastMasterData, getIdLength(), leadingSeparator, fieldName, fieldIndex,
+          outputFormat, -1, output);
+    } else {
+      result = m_data->read(m_lastSlaveData, 0, leadingSeparator, fieldName, fieldIndex,
+          outputFormat, -1, output);
+    }
+    if (result < RESULT_OK) {
+      return result;
+    }
+    if (result == RESULT_EMPTY && (fieldName != nullptr || fieldIndex >= 0)) {
+      return RESULT_ERR_NOTFOUND;
+    }
+    return result;
+  }
   ostream::pos_type startPos = output->tellp();
-  result_t result = m_data->read(m_lastMasterData, getIdLength(), leadingSeparator, fieldName, fieldIndex,
+  result = m_data->read(m_lastMasterData, getIdLength(), leadingSeparator, fieldName, fieldIndex,
       outputFormat, -1, output);
   if (result < RESULT_OK) {
     return result;
@@ -806,19 +935,52 @@ result_t Message::decodeLastData(bool leadingSeparator, const char* fieldName,
 }
 
 result_t Message::decodeLastDataNumField(const char* fieldName, ssize_t fieldIndex, unsigned int* output) const {
-  result_t result = m_data->read(m_lastMasterData, getIdLength(), fieldName, fieldIndex, output);
-  if (result < RESULT_OK) {
-    return result;
-  }
-  if (result == RESULT_EMPTY) {
-    result = m_data->read(m_lastSlaveData, 0, fieldName, fieldIndex, output);
+  ssize_t index = -1;
+  if (fieldIndex >= 0) {
+    index = m_data->getIndex(fieldName, fieldIndex);
+  } else {
+    // use the last matching field of the master data, or of the slave data if there is none in the master data
+    for (PartType partType : {pt_masterData, pt_slaveData}) {
+      size_t count = m_data->getCount(partType, fieldName);
+      if (count > 0) {
+        index = m_data->getIndex(fieldName, static_cast<ssize_t>(count - 1), partType);
+        break;
+      }
+    }
   }
-  if (result < RESULT_OK) {
-    return result;
+  NumericValue value;
+  result_t result = getLastValueAt(index, &value);
+  if (result == RESULT_OK || result == RESULT_ERR_OUT_OF_RANGE) {
+    *output = value.m_raw;  // raw value without range check
+    result = RESULT_OK;
+  } else if (result == RESULT_EMPTY) {
+    result = RESULT_ERR_NOTFOUND;
   }
-  if (result == RESULT_EMPTY) {
+  return result;
+}
+
+result_t Message::getLastValue(const char* fieldName, ssize_t fieldIndex, NumericValue* value) const {
+  return getLastValueAt(m_data->getIndex(fieldName, fieldIndex), value);
+}
+
+result_t Message::getLastValueAt(ssize_t index, NumericValue* value) const {
+  if (index < 0) {
     return RESULT_ERR_NOTFOUND;
   }
+  unsigned int dataVersion = m_dataVersion;  // taken before reading so that a concurrent change is not hidden
+  m_decodeCacheMutex.lock();
+  if (m_lastValues.empty() || m_lastValuesVersion != dataVersion) {
+    m_lastValues.assign(getFieldCount(), NumericValue());
+    m_data->readValues(m_lastMasterData, getIdLength(), 0, &m_lastValues);
+    m_data->readValues(m_lastSlaveData, 0, 0, &m_lastValues);
+    m_lastValuesVersion = dataVersion;
+  }
+  result_t result = RESULT_ERR_NOTFOUND;
+  if (static_cast<size_t>(index) < m_lastValues.size()) {
+    *value = m_lastValues[index];
+    result = value->m_type == nv_none ? RESULT_EMPTY : value->m_type == nv_raw ? RESULT_ERR_OUT_OF_RANGE : RESULT_OK;
+  }
+  m_decodeCacheMutex.unlock();
   return result;
 }
 
@@ -1461,6 +1623,26 @@ result_t Condition::create(const string& condName, const map<string, string>& ro
   return RESULT_OK;
 }
 
+void Condition::addDependent(Condition* dependent) {
+  s_dependencyMutex.lock();
+  m_dependents.push_back(dependent);
+  s_dependencyMutex.unlock();
+}
+
+void Condition::invalidate() {
+  m_needsCheck = true;
+  for (const auto dependent : m_dependents) {
+    dependent->invalidate();
+  }
+}
+
+bool Condition::isTrue() {
+  if (m_needsCheck.exchange(false)) {  // cleared before evaluating so that a concurrent invalidation is kept
+    m_isTrue = evaluate();
+  }
+  return m_isTrue;
+}
+
 SimpleCondition* SimpleCondition::derive(const string& valueList) const {
   if (valueList.empty()) {
     return nullptr;
@@ -1565,6 +1747,7 @@ result_t SimpleCondition::resolve(void (*readMessageFunc)(Message* message), Mes
     }
     m_message = message;
     message->setUsedByCondition();
+    message->addDependentCondition(this);
     if (m_name.length() > 0 && !message->isScanMessage()) {
       messages->addPollMessage(true, message);
     }
@@ -1575,19 +1758,11 @@ result_t SimpleCondition::resolve(void (*readMessageFunc)(Message* message), Mes
   return RESULT_OK;
 }
 
-bool SimpleCondition::isTrue() {
-  if (!m_message) {
+bool SimpleCondition::evaluate() {
+  if (!m_message || m_message->getLastChangeTime() == 0) {
     return false;
   }
-  if (m_message->getLastChangeTime() > m_lastCheckTime) {
-    bool isTrue = !m_hasValues;  // for message seen check
-    if (!isTrue) {
-      isTrue = checkValue(m_message, m_field);
-    }
-    m_isTrue = isTrue;
-    m_lastCheckTime = m_message->getLastChangeTime();
-  }
-  return m_isTrue;
+  return !m_hasValues || checkValue(m_message, m_field);  // without values for message seen check
 }
 
 
@@ -1641,7 +1816,7 @@ result_t CombinedCondition::resolve(void (*readMessageFunc)(Message* message), M
   return RESULT_OK;
 }
 
-bool CombinedCondition::isTrue() {
+bool CombinedCondition::evaluate() {
   for (const auto condition : m_conditions) {
     if (!condition->isTrue()) {
       return false;
@@ -1749,18 +1924,213 @@ result_t LoadInstruction::execute(MessageMap* messages, ostringstream* log) {
 }
 
 
+void MessageJournal::add(Message* message, bool changed) {
+  m_mutex.lock();
+  uint64_t sequence = ++m_sequence;
+  message->m_lastUpdateSequence = sequence;
+  if (changed) {
+    message->m_lastChangeSequence = sequence;
+  }
+  if (m_entries.size() >= MAX_JOURNAL_ENTRIES) {
+    m_droppedSequence = m_entries.front().m_sequence;
+    m_entries.pop_front();
+  }
+  MessageJournalEntry entry;
+  entry.m_sequence = sequence;
+  entry.m_message = message;
+  entry.m_changed = changed;
+  m_entries.push_back(entry);
+  for (const auto listener : m_listeners) {
+    listener->notifyMessageUpdate(changed);
+  }
+  m_mutex.unlock();
+}
+
+bool MessageJournal::find(uint64_t* sequence, bool changedOnly, deque<Message*>* messages) {
+  m_mutex.lock();
+  bool complete = *sequence >= m_droppedSequence;
+  if (complete && !m_entries.empty() && *sequence < m_sequence) {
+    // sequence numbers are contiguous, so skip the already seen entries directly
+    uint64_t first = m_entries.front().m_sequence;
+    auto it = m_entries.begin();
+    if (*sequence >= first) {
+      it += (ptrdiff_t)(*sequence - first + 1);
+    }
+    for (; it != m_entries.end(); ++it) {
+      Message* message = it->m_message;
+      if (!message) {
+        continue;
+      }
+      // only return each message once for its latest entry
+      if (changedOnly ? !it->m_changed || message->m_lastChangeSequence != it->m_sequence
+          : message->m_lastUpdateSequence != it->m_sequence) {
+        continue;
+      }
+      messages->push_back(message);
+    }
+  }
+  *sequence = m_sequence;
+  m_mutex.unlock();
+  return complete;
+}
+
+void MessageJournal::remove(const Message* message) {
+  m_mutex.lock();
+  if (message->m_lastUpdateSequence > m_droppedSequence) {
+    for (auto& entry : m_entries) {
+      if (entry.m_message == message) {
+        entry.m_message = nullptr;
+      }
+    }
+  }
+  m_mutex.unlock();
+}
+
+void MessageJournal::clear() {
+  m_mutex.lock();
+  m_entries.clear();
+  m_droppedSequence = ++m_sequence;
+  m_mutex.unlock();
+}
+
+void MessageJournal::addListener(MessageUpdateListener* listener) {
+  m_mutex.lock();
+  m_listeners.push_back(listener);
+  m_mutex.unlock();
+}
+
+void MessageJournal::removeListener(MessageUpdateListener* listener) {
+  m_mutex.lock();
+  for (auto it = m_listeners.begin(); it != m_listeners.end(); ) {
+    if (*it == listener) {
+      it = m_listeners.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  m_mutex.unlock();
+}
+
+
+result_t MessageBatch::add(const Message* message, OutputFormat outputFormat, OutputBuffer* buffer) {
+  buffer->reset();
+  result_t result = message->decodeLastData(false, nullptr, -1, outputFormat | OF_JSON | OF_NAMES, buffer);
+  if (result == RESULT_OK) {
+    m_circuits[message->getCircuit()][message->getName()] = buffer->str();
+  }
+  return result;
+}
+
+void MessageBatch::build(bool perCircuit, OutputBuffer* buffer, vector<pair<string, string>>* documents) {
+  if (m_circuits.empty()) {
+    return;
+  }
+  m_sequence++;
+  buffer->reset();
+  if (!perCircuit) {
+    OutputBuffer::append("{\"sequence\": ", buffer);
+    OutputBuffer::appendUnsigned(m_sequence, buffer);
+  }
+  for (const auto& circuit : m_circuits) {
+    if (perCircuit) {
+      buffer->reset();
+      OutputBuffer::append("{\"sequence\": ", buffer);
+      OutputBuffer::appendUnsigned(m_sequence, buffer);
+      OutputBuffer::append(", \"messages\": {", buffer);
+    } else {
+      OutputBuffer::append(", \"", buffer);
+      OutputBuffer::appendJsonString(circuit.first, buffer);
+      OutputBuffer::append("\": {\"messages\": {", buffer);
+    }
+    bool first = true;
+    for (const auto& message : circuit.second) {
+      OutputBuffer::append(first ? "\"" : ", \"", buffer);
+      OutputBuffer::appendJsonString(message.first, buffer);
+      OutputBuffer::append("\": {", buffer);
+      OutputBuffer::append(message.second, buffer);
+      OutputBuffer::append('}', buffer);
+      first = false;
+    }
+    OutputBuffer::append("}}", buffer);
+    if (perCircuit) {
+      documents->push_back(pair<string, string>(circuit.first, buffer->str()));
+    }
+  }
+  if (!perCircuit) {
+    OutputBuffer::append('}', buffer);
+    documents->push_back(pair<string, string>("", buffer->str()));
+  }
+  m_circuits.clear();
+}
+
+
+bool PublishQueue::add(const string& topic, const string& data, uint64_t now) {
+  if (m_coalesceMillis == 0 && m_maxRate == 0) {
+    return isChanged(topic, data);
+  }
+  const auto it = m_queued.find(topic);
+  if (it != m_queued.end()) {
+    it->second = data;  // combine with the pending update
+    return false;
+  }
+  m_queued[topic] = data;
+  m_queuedOrder.push_back(pair<uint64_t, string>(now + m_coalesceMillis, topic));
+  return false;
+}
+
+int PublishQueue::take(uint64_t now, vector<pair<string, string>>* updates) {
+  while (!m_queuedOrder.empty()) {
+    uint64_t due = m_queuedOrder.front().first;
+    if (due > now) {
+      return static_cast<int>(due - now);
+    }
+    if (m_maxRate > 0) {
+      if (now >= m_rateStart + 1000 || now < m_rateStart) {
+        m_rateStart = now;
+        m_rateCount = 0;
+      } else if (m_rateCount >= m_maxRate) {
+        return static_cast<int>(m_rateStart + 1000 - now);
+      }
+      m_rateCount++;
+    }
+    const auto it = m_queued.find(m_queuedOrder.front().second);
+    if (it != m_queued.end()) {
+      if (isChanged(it->first, it->second)) {
+        updates->push_back(*it);
+      }
+      m_queued.erase(it);
+    }
+    m_queuedOrder.pop_front();
+  }
+  return -1;
+}
+
+bool PublishQueue::isChanged(const string& topic, const string& data) {
+  if (!m_dedup) {
+    return true;
+  }
+  size_t hash = std::hash<string>()(data);
+  const auto it = m_takenHashes.find(topic);
+  if (it != m_takenHashes.end() && it->second == hash) {
+    return false;  // identical to the last taken data
+  }
+  m_takenHashes[topic] = hash;
+  return true;
+}
+
+
 vector<string> MessageMap::s_noFiles;
 
 result_t MessageMap::add(bool storeByName, Message* message, bool replace) {
   uint64_t key = message->getKey();
   bool conditional = message->isConditional();
+  lock();
   if (!m_addAll) {
-    lock();
-    const auto keyIt = m_messagesByKey.find(key);
-    if (keyIt != m_messagesByKey.end()) {
+    const vector<Message*>* keyMessages = m_messagesByKey.find(key);
+    if (keyMessages) {
       if (replace) {
         vector<Message*> removeMessages;
-        for (auto other : keyIt->second) {
+        for (auto other : *keyMessages) {
           if (!other || !message->checkId(*other)) {
             continue;
           }
@@ -1772,14 +2142,13 @@ result_t MessageMap::add(bool storeByName, Message* message, bool replace) {
           remove(other);
         }
       } else {
-        Message *other = getFirstAvailable(keyIt->second, message);
+        Message *other = getFirstAvailable(*keyMessages, message);
         if (other != nullptr && (!conditional || !other->isConditional())) {
           unlock();
           return RESULT_ERR_DUPLICATE;  // duplicate key
         }
       }
     }
-    unlock();
   }
   bool isPassive = message->isPassive();
   if (storeByName) {
@@ -1794,7 +2163,6 @@ result_t MessageMap::add(bool storeByName, Message* message, bool replace) {
     string suffix = FIELD_SEPARATOR + name + (isPassive ? "P" : (isWrite ? "W" : "R"));
     string nameKey = circuit + suffix;
     if (!m_addAll) {
-      lock();
       const auto nameIt = m_messagesByName.find(nameKey);
       if (nameIt != m_messagesByName.end()) {
         vector<Message*>* messages = &nameIt->second;
@@ -1816,7 +2184,6 @@ result_t MessageMap::add(bool storeByName, Message* message, bool replace) {
           return RESULT_ERR_DUPLICATE_NAME;  // duplicate key
         }
       }
-      unlock();
     }
     m_messagesByName[nameKey].push_back(message);
     nameKey = suffix;  // also store without circuit
@@ -1843,18 +2210,75 @@ result_t MessageMap::add(bool storeByName, Message* message, bool replace) {
       m_passiveMessageCount++;
     }
     addPollMessage(false, message);
-  }
-  size_t idLength = message->getIdLength();
-  if (message->getDstAddress() == BROADCAST && idLength > m_maxBroadcastIdLength) {
-    m_maxBroadcastIdLength = idLength;
-  }
-  if (idLength > m_maxIdLength) {
-    m_maxIdLength = idLength;
+    message->m_journal = &m_journal;
   }
   m_messagesByKey[key].push_back(message);
+  addDispatch(message);
+  m_definitionVersion++;
+  unlock();
   return RESULT_OK;
 }
 
+void MessageMap::addDispatch(Message* message) {
+  uint64_t key = message->getKey();
+  size_t idLength = Message::getKeyLength(key);
+  unsigned int source = (unsigned int)((key & ID_SOURCE_MASK) >> (8 * 7));
+  int rank;
+  if (source == (ID_SOURCE_ACTIVE_WRITE >> (8 * 7))) {
+    rank = 3;
+  } else if (source == (ID_SOURCE_ACTIVE_READ >> (8 * 7))) {
+    rank = 2;
+  } else {
+    rank = source == 0 ? 1 : 0;
+  }
+  vector<MessageDispatchEntry>* entries = &m_messagesByHeader[(key >> (8 * 4)) & 0xffffff];
+  auto it = entries->begin();
+  for (; it != entries->end(); ++it) {
+    if (it->m_key == key) {
+      it->m_messages.push_back(message);
+      return;
+    }
+    if (it->m_idLength < idLength || (it->m_idLength == idLength && it->m_rank > rank)) {
+      break;  // longest ID first, then in lookup order
+    }
+  }
+  MessageDispatchEntry entry;
+  entry.m_key = key;
+  entry.m_idLength = idLength;
+  entry.m_rank = rank;
+  entry.m_source = source;
+  entry.m_messages.push_back(message);
+  entries->insert(it, entry);
+}
+
+void MessageMap::removeDispatch(uint64_t key, const Message* message) {
+  uint64_t header = (key >> (8 * 4)) & 0xffffff;
+  vector<MessageDispatchEntry>* entries = m_messagesByHeader.find(header);
+  if (!entries) {
+    return;
+  }
+  for (auto it = entries->begin(); it != entries->end(); ++it) {
+    if (it->m_key != key) {
+      continue;
+    }
+    vector<Message*>* messages = &it->m_messages;
+    for (auto mit = messages->begin(); mit != messages->end(); ) {
+      if (*mit == message) {
+        mit = messages->erase(mit);
+      } else {
+        ++mit;
+      }
+    }
+    if (messages->empty()) {
+      entries->erase(it);
+      if (entries->empty()) {
+        m_messagesByHeader.erase(header);
+      }
+    }
+    break;
+  }
+}
+
 void MessageMap::remove(Message* message) {
   if (message == nullptr) {
     return;
@@ -1862,30 +2286,33 @@ void MessageMap::remove(Message* message) {
   lock();
   uint64_t key = message->getKey();
   bool conditional = message->isConditional();
-  const auto keyIt = m_messagesByKey.find(key);
+  bool isPassive = message->isPassive();
+  bool isPolled = message->getPollPriority() > 0;
+  m_journal.remove(message);
+  vector<Message*>* keyMessages = m_messagesByKey.find(key);
   bool deleted = false;
-  if (keyIt != m_messagesByKey.end()) {
-    vector<Message*> messages = keyIt->second;
-    for (auto it = messages.begin(); it != messages.end(); ) {
+  if (keyMessages) {
+    for (auto it = keyMessages->begin(); it != keyMessages->end(); ) {
       Message* other = *it;
       if (other == message) {
         if (!deleted) {
           deleted = true;
           delete(other);
         }
-        messages.erase(it);
+        it = keyMessages->erase(it);
       } else {
         ++it;
       }
     }
-    if (messages.empty()) {
-      m_messagesByKey.erase(keyIt);
+    if (keyMessages->empty()) {
+      m_messagesByKey.erase(key);
     }
   }
+  removeDispatch(key, message);
   bool storedByName = false;
   for (auto nameIt = m_messagesByName.begin(); nameIt != m_messagesByName.end(); ) {
-    vector<Message*> messages = nameIt->second;
-    for (auto it = messages.begin(); it != messages.end(); ) {
+    vector<Message*>* messages = &nameIt->second;
+    for (auto it = messages->begin(); it != messages->end(); ) {
       Message* other = *it;
       if (other == message) {
         storedByName = true;
@@ -1893,19 +2320,18 @@ void MessageMap::remove(Message* message) {
           deleted = true;
           delete(other);
         }
-        messages.erase(it);
+        it = messages->erase(it);
       } else {
         ++it;
       }
     }
-    if (messages.empty()) {
-      m_messagesByName.erase(nameIt);
+    if (messages->empty()) {
+      nameIt = m_messagesByName.erase(nameIt);
     } else {
       ++nameIt;
     }
   }
   if (storedByName) {
-    bool isPassive = message->isPassive();
     m_messageCount--;
     if (conditional) {
       m_conditionalMessageCount--;
@@ -1914,9 +2340,10 @@ void MessageMap::remove(Message* message) {
       m_passiveMessageCount--;
     }
   }
-  if (message->getPollPriority() > 0) {
+  if (isPolled) {
     m_pollMessages.remove(message);
   }
+  m_definitionVersion++;
   unlock();
 }
 
@@ -2488,36 +2915,35 @@ bool MessageMap::getLoadedFileInfo(const string& filename, string* comment, size
 }
 
 const vector<Message*>* MessageMap::getByKey(uint64_t key) const {
-  const auto it = m_messagesByKey.find(key);
-  if (it != m_messagesByKey.end()) {
-    return &it->second;
-  }
-  return nullptr;
+  return m_messagesByKey.find(key);
 }
 
 Message* MessageMap::find(const string& circuit, const string& name, const string& levels, bool isWrite,
     bool isPassive) const {
-  string lcircuit = circuit;
-  FileReader::tolower(&lcircuit);
+  return findAvailable(findCandidates(circuit, name, isWrite, isPassive), levels);
+}
+
+const vector<Message*>* MessageMap::findCandidates(const string& circuit, const string& name, bool isWrite,
+    bool isPassive) const {
+  string nameKey = circuit;
+  FileReader::tolower(&nameKey);
   string lname = name;
   FileReader::tolower(&lname);
-  string suffix = FIELD_SEPARATOR + lname + (isPassive ? "P" : (isWrite ? "W" : "R"));
-  for (int i = 0; i < 2; i++) {
-    string nameKey;
-    if (i == 0) {
-      nameKey = lcircuit + suffix;
-    } else if (lcircuit.empty()) {
-      nameKey = suffix;  // second try: without circuit
-    } else {
-      continue;  // not allowed without circuit
-    }
-    const auto it = m_messagesByName.find(nameKey);
-    if (it != m_messagesByName.end()) {
-      Message* message = getFirstAvailable(it->second);
-      if (message && message->hasLevel(levels)) {
-        return message;
-      }
-    }
+  nameKey += FIELD_SEPARATOR + lname + (isPassive ? "P" : (isWrite ? "W" : "R"));
+  const auto it = m_messagesByName.find(nameKey);
+  if (it == m_messagesByName.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+Message* MessageMap::findAvailable(const vector<Message*>* candidates, const string& levels) {
+  if (!candidates) {
+    return nullptr;
+  }
+  Message* message = getFirstAvailable(*candidates);
+  if (message && message->hasLevel(levels)) {
+    return message;
   }
   return nullptr;
 }
@@ -2584,12 +3010,25 @@ void MessageMap::findAll(const string& circuit, const string& name, const string
   }
 }
 
-Message* MessageMap::getFirstAvailableFromIterator(const map<uint64_t, vector<Message*> >::const_iterator& it,
-    const MasterSymbolString* sameIdExtAs, bool onlyAvailable) const {
-  if (it != m_messagesByKey.end()) {
-    return getFirstAvailable(it->second, sameIdExtAs, onlyAvailable);
+bool MessageMap::findUpdates(const string& levels, bool changedOnly, uint64_t* sequence,
+    deque<Message*>* messages) {
+  deque<Message*> updated;
+  if (!m_journal.find(sequence, changedOnly, &updated)) {
+    return false;
   }
-  return nullptr;
+  bool checkLevel = levels != "*";
+  for (const auto message : updated) {
+    if (checkLevel && !message->hasLevel(levels, true)) {
+      continue;
+    }
+    if (message->getDstAddress() == SYN) {
+      continue;
+    }
+    if (message->isAvailable()) {
+      messages->push_back(message);
+    }
+  }
+  return true;
 }
 
 Message* MessageMap::find(const MasterSymbolString& master, bool anyDestination,
@@ -2597,67 +3036,44 @@ Message* MessageMap::find(const MasterSymbolString& master, bool anyDestination,
   if (anyDestination && master.size() >= 5 && master[4] == 0 && master[2] == 0x07 && master[3] == 0x04) {
     return m_scanMessage;
   }
-  uint64_t baseKey = Message::createKey(master,
-      anyDestination || master[1] != BROADCAST ? m_maxIdLength : m_maxBroadcastIdLength, anyDestination);
-  if (baseKey == INVALID_KEY) {
+  if (master.size() < 5) {
     return nullptr;
   }
-  bool isWriteDest = isMaster(master[1]) || master[1] == BROADCAST;
-  size_t maxIdLength = Message::getKeyLength(baseKey);
-  for (size_t idLength = maxIdLength; true; idLength--) {
-    uint64_t key = baseKey;
-    if (idLength == maxIdLength) {
-      baseKey &= ~ID_LENGTH_AND_IDS_MASK;
-    } else {
-      key |= (uint64_t)idLength << (8 * 7 + 5);
-      int exp = 3;
-      for (size_t i = 0; i < idLength; i++) {
-        key ^= (uint64_t)master.dataAt(i) << (8 * exp--);
-        if (exp == 0) {
-          exp = 3;
-        }
-      }
-    }
-    Message* message;
-    if (withPassive) {
-      message = getFirstAvailableFromIterator(m_messagesByKey.find(key), &master, onlyAvailable);
-      if (message) {
-        return message;
-      }
-    }
-    if ((key & ID_SOURCE_MASK) != 0) {
-      key &= ~ID_SOURCE_MASK;
-      if (withPassive) {
-        // try again without specific source master
-        message = getFirstAvailableFromIterator(m_messagesByKey.find(key), &master, onlyAvailable);
-        if (message) {
-          return message;
-        }
-      }
+  const vector<MessageDispatchEntry>* entries = m_messagesByHeader.find(
+      (uint64_t)(anyDestination ? SYN : master[1]) << 16 | (uint64_t)master[2] << 8 | master[3]);
+  if (!entries) {
+    return nullptr;
+  }
+  // combine the ID bytes for each ID length the same way as in the key
+  size_t maxIdLength = master.getDataSize();
+  if (maxIdLength > 7) {
+    maxIdLength = 7;  // limited by the size of the length field in the key
+  }
+  uint64_t ids[8];
+  ids[0] = 0;
+  int exp = 3;
+  for (size_t i = 0; i < maxIdLength; i++) {
+    ids[i+1] = ids[i] ^ ((uint64_t)master.dataAt(i) << (8 * exp--));
+    if (exp == 0) {
+      exp = 3;
     }
-    if (withRead) {
-      // try again with special value for active read
-      message = getFirstAvailableFromIterator(
-        m_messagesByKey.find(key | (isWriteDest ? ID_SOURCE_ACTIVE_READ_MASTER : ID_SOURCE_ACTIVE_READ)),
-        &master, onlyAvailable);
-      if (message) {
-        return message;
-      }
+  }
+  unsigned int source = getMasterNumber(master[0]);
+  // the entries are sorted by ID length descending, then passive from source, passive from any source, active read,
+  // and active write
+  for (const auto& entry : *entries) {
+    if (entry.m_idLength > maxIdLength || (entry.m_key & ID_IDS_MASK) != ids[entry.m_idLength]) {
+      continue;
     }
-    if (withWrite) {
-      // try again with special value for active write
-      message = getFirstAvailableFromIterator(
-        m_messagesByKey.find(key | (isWriteDest ? ID_SOURCE_ACTIVE_WRITE_MASTER : ID_SOURCE_ACTIVE_WRITE)),
-        &master, onlyAvailable);
-      if (message) {
-        return message;
-      }
+    if (entry.m_rank == 0 ? !withPassive || entry.m_source != source
+        : entry.m_rank == 1 ? !withPassive : entry.m_rank == 2 ? !withRead : !withWrite) {
+      continue;
     }
-    if (idLength == 0) {
-      break;
+    Message* message = getFirstAvailable(entry.m_messages, &master, onlyAvailable);
+    if (message) {
+      return message;
     }
   }
-
   return nullptr;
 }
 
@@ -2700,6 +3116,7 @@ bool MessageMap::decodeCircuit(const string& circuit, OutputFormat outputFormat,
 }
 
 void MessageMap::clear() {
+  m_journal.clear();
   m_loadedFiles.clear();
   m_loadedFileInfos.clear();
   // clear poll messages
@@ -2714,9 +3131,8 @@ void MessageMap::clear() {
       continue;
     }
     for (Message* message : it.second) {
-      const auto keyIt = m_messagesByKey.find(message->getKey());
-      if (keyIt != m_messagesByKey.end()) {
-        vector<Message*>* keyMessages = &keyIt->second;
+      vector<Message*>* keyMessages = m_messagesByKey.find(message->getKey());
+      if (keyMessages) {
         if (!keyMessages->empty()) {
           auto kit = keyMessages->begin();
           while (kit != keyMessages->end()) {
@@ -2733,17 +3149,21 @@ void MessageMap::clear() {
     it.second.clear();
   }
   // free remaining message instances by key
-  for (const auto it : m_messagesByKey) {
-    vector<Message*> keyMessages = it.second;
-    for (auto message : keyMessages) {
+  for (size_t index = 0; index < m_messagesByKey.size(); index++) {
+    for (auto message : m_messagesByKey.getValue(index)) {
       delete message;
     }
-    keyMessages.clear();
   }
   // free condition instances
   for (const auto it : m_conditions) {
     delete it.second;
   }
+  if (m_scanMessage) {
+    m_scanMessage->clearDependentConditions();
+  }
+  if (m_broadcastScanMessage) {
+    m_broadcastScanMessage->clearDependentConditions();
+  }
   // free instruction instances
   for (const auto it : m_instructions) {
     vector<Instruction*> instructions = it.second;
@@ -2759,14 +3179,166 @@ void MessageMap::clear() {
   m_messagesByName.clear();
   // clear messages by key
   m_messagesByKey.clear();
+  m_messagesByHeader.clear();
   m_conditions.clear();
   m_instructions.clear();
   for (const auto it : m_circuitData) {
     delete it.second;
   }
   m_circuitData.clear();
-  m_maxIdLength = m_maxBroadcastIdLength = 0;
   m_additionalScanMessages = false;
+  m_definitionVersion++;
+}
+
+void MessageMap::swapDefinitions(MessageMap* other) {
+  // find the previous messages with the same key and definition up front, which stay valid until swapped as the
+  // current ones are only added to in the meantime
+  vector<pair<Message*, const Message*>> matches;
+  lockShared();
+  for (size_t index = 0; index < other->m_messagesByKey.size(); index++) {
+    const vector<Message*>* previous = m_messagesByKey.find(other->m_messagesByKey.getKey(index));
+    if (!previous) {
+      continue;
+    }
+    for (auto message : other->m_messagesByKey.getValue(index)) {
+      string definition;
+      for (auto check : *previous) {
+        if (check->getCircuit() != message->getCircuit() || check->getName() != message->getName()) {
+          continue;
+        }
+        if (definition.empty()) {
+          ostringstream out;
+          message->dump(nullptr, true, &out);
+          definition = out.str();
+        }
+        ostringstream out;
+        check->dump(nullptr, true, &out);
+        if (out.str() == definition) {
+          matches.push_back(pair<Message*, const Message*>(message, check));
+        }
+      }
+    }
+  }
+  unlockShared();
+  lock();
+  m_definitionVersion++;
+  m_journal.clear();
+  m_loadedFiles.swap(other->m_loadedFiles);
+  m_loadedFileInfos.swap(other->m_loadedFileInfos);
+  m_pollMessages.swap(other->m_pollMessages);
+  m_messagesByName.swap(other->m_messagesByName);
+  m_messagesByKey.swap(other->m_messagesByKey);
+  m_messagesByHeader.swap(other->m_messagesByHeader);
+  m_conditions.swap(other->m_conditions);
+  m_instructions.swap(other->m_instructions);
+  m_circuitData.swap(other->m_circuitData);
+  size_t count = m_messageCount;
+  m_messageCount = other->m_messageCount;
+  other->m_messageCount = count;
+  count = m_conditionalMessageCount;
+  m_conditionalMessageCount = other->m_conditionalMessageCount;
+  other->m_conditionalMessageCount = count;
+  count = m_passiveMessageCount;
+  m_passiveMessageCount = other->m_passiveMessageCount;
+  other->m_passiveMessageCount = count;
+  bool additional = m_additionalScanMessages;
+  m_additionalScanMessages = other->m_additionalScanMessages;
+  other->m_additionalScanMessages = additional;
+  // the new conditions might refer to the scan messages of the other instance, while the ident fields stay owned
+  // by the respective instance
+  Message* message = m_scanMessage;
+  m_scanMessage = other->m_scanMessage;
+  other->m_scanMessage = message;
+  bool deleteData = m_scanMessage->m_deleteData;
+  m_scanMessage->m_deleteData = message->m_deleteData;
+  message->m_deleteData = deleteData;
+  carryLastData(message, m_scanMessage);
+  message = m_broadcastScanMessage;
+  m_broadcastScanMessage = other->m_broadcastScanMessage;
+  other->m_broadcastScanMessage = message;
+  carryLastData(message, m_broadcastScanMessage);
+  // let the previous instances record in the other journal
+  for (size_t index = 0; index < other->m_messagesByKey.size(); index++) {
+    for (auto previous : other->m_messagesByKey.getValue(index)) {
+      if (previous->m_journal) {
+        previous->m_journal = &other->m_journal;
+      }
+    }
+  }
+  // record in this journal
+  for (size_t index = 0; index < m_messagesByKey.size(); index++) {
+    for (auto current : m_messagesByKey.getValue(index)) {
+      if (current->m_journal) {
+        current->m_journal = &m_journal;
+      }
+    }
+  }
+  // carry over the last data of unchanged messages from the first previous one seen
+  Message* carried = nullptr;
+  for (const auto& it : matches) {
+    if (it.first != carried && it.second->m_lastUpdateTime != 0) {
+      carryLastData(it.second, it.first);
+      carried = it.first;
+    }
+  }
+  unlock();
+  m_holdMutex.lock();
+  m_retiredDefinitions.push_back(pair<uint64_t, MessageMap*>(m_generation, other));
+  m_generation++;
+  m_holdMutex.unlock();
+}
+
+void MessageMap::carryLastData(const Message* previous, Message* message) {
+  if (previous->m_lastUpdateTime == 0) {
+    return;
+  }
+  message->m_lastMasterData = previous->m_lastMasterData;
+  message->m_lastSlaveData = previous->m_lastSlaveData;
+  message->m_lastUpdateTime = previous->m_lastUpdateTime;
+  message->m_lastChangeTime = previous->m_lastChangeTime;
+  message->dataChanged();
+}
+
+uint64_t MessageMap::holdDefinitions() {
+  m_holdMutex.lock();
+  uint64_t hold = m_generation;
+  m_definitionHolds[hold]++;
+  m_holdMutex.unlock();
+  return hold;
+}
+
+void MessageMap::releaseDefinitions(uint64_t hold) {
+  m_holdMutex.lock();
+  auto it = m_definitionHolds.find(hold);
+  if (it != m_definitionHolds.end() && it->second > 0) {
+    it->second--;
+  }
+  m_holdMutex.unlock();
+}
+
+size_t MessageMap::freeRetiredDefinitions() {
+  vector<MessageMap*> unused;
+  m_holdMutex.lock();
+  auto it = m_definitionHolds.begin();
+  while (it != m_definitionHolds.end()) {
+    if (it->second == 0) {
+      it = m_definitionHolds.erase(it);
+    } else {
+      it++;
+    }
+  }
+  // a hold protects the definitions current at the time it was taken and all later ones
+  uint64_t oldestHeld = m_definitionHolds.empty() ? m_generation : m_definitionHolds.begin()->first;
+  while (!m_retiredDefinitions.empty() && m_retiredDefinitions.front().first < oldestHeld) {
+    unused.push_back(m_retiredDefinitions.front().second);
+    m_retiredDefinitions.pop_front();
+  }
+  size_t remain = m_retiredDefinitions.size();
+  m_holdMutex.unlock();
+  for (const auto retired : unused) {
+    delete retired;  // outside of the lock as freeing might take a while
+  }
+  return remain;
 }
 
 Message* MessageMap::getNextPoll() {
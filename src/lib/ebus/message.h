@@ -20,12 +20,14 @@
 #define LIB_EBUS_MESSAGE_H_
 
 #include <stdint.h>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <deque>
 #include <map>
 #include <queue>
 #include <functional>
+#include <utility>
 #include "lib/ebus/data.h"
 #include "lib/ebus/result.h"
 #include "lib/ebus/symbol.h"
@@ -62,17 +64,54 @@ namespace ebusd {
 using std::binary_function;
 using std::priority_queue;
 using std::deque;
+using std::pair;
 
 class Condition;
 class SimpleCondition;
 class CombinedCondition;
+class MessageJournal;
 class MessageMap;
 
 
+/**
+ * Helper class for caching the formatted values decoded from the last data of a @a Message.
+ */
+class DecodeCacheEntry {
+ public:
+  /** the data version of the @a Message the cached output was decoded from. */
+  unsigned int m_dataVersion;
+
+  /** the @a PartType that was decoded (@a pt_any for master and slave data). */
+  PartType m_partType;
+
+  /** whether a separator was prepended before the formatted value. */
+  bool m_leadingSeparator;
+
+  /** whether the output was limited to a field name. */
+  bool m_hasFieldName;
+
+  /** the name of the field the output was limited to. */
+  string m_fieldName;
+
+  /** the index of the field the output was limited to, or -1. */
+  ssize_t m_fieldIndex;
+
+  /** the @a OutputFormat options used. */
+  OutputFormat m_outputFormat;
+
+  /** the result of the decoding. */
+  result_t m_result;
+
+  /** the formatted value(s). */
+  string m_output;
+};
+
+
 /**
  * Defines parameters of a message sent or received on the bus.
  */
 class Message : public AttributedItem {
+  friend class MessageJournal;
   friend class MessageMap;
  public:
   /**
@@ -377,6 +416,17 @@ class Message : public AttributedItem {
    */
   void setUsedByCondition();
 
+  /**
+   * Add a @a Condition referring to this @a Message that needs to be invalidated whenever the data changes.
+   * @param condition the dependent @a Condition.
+   */
+  void addDependentCondition(Condition* condition);
+
+  /**
+   * Remove all dependent @a Condition instances.
+   */
+  void clearDependentConditions();
+
   /**
    * Return whether this @a Message depends on a @a Condition.
    * @return true when this @a Message depends on a @a Condition.
@@ -488,13 +538,25 @@ class Message : public AttributedItem {
 
   /**
    * Decode a particular numeric field value from the last stored data.
-   * @param fieldName the name of the field to decode, or nullptr for the first field.
-   * @param fieldIndex the optional index of the field (either named or overall), or -1.
-   * @param output the variable in which to store the value.
+   * @param fieldName the name of the field to decode, or nullptr for any field.
+   * @param fieldIndex the optional index of the field (either named or overall), or -1 for the last matching field of
+   * the master data, or of the slave data if there is none in the master data.
+   * @param output the variable in which to store the raw value (even when out of range).
    * @return @a RESULT_OK on success, or an error code.
    */
   virtual result_t decodeLastDataNumField(const char* fieldName, ssize_t fieldIndex, unsigned int* output) const;
 
+  /**
+   * Get the numeric value of a particular field from the last stored data without formatting.
+   * @param fieldName the name of the field, or nullptr for the first field.
+   * @param fieldIndex the optional index of the field (either named or overall), or -1.
+   * @param value the @a NumericValue in which to store the value.
+   * @return @a RESULT_OK on success, @a RESULT_EMPTY if the field has no numeric value,
+   * @a RESULT_ERR_OUT_OF_RANGE if only the raw value is available, or @a RESULT_ERR_NOTFOUND if the field is not
+   * available.
+   */
+  result_t getLastValue(const char* fieldName, ssize_t fieldIndex, NumericValue* value) const;
+
   /**
    * Get the last seen master data.
    * @return the last seen @a MasterSymbolString.
@@ -615,8 +677,9 @@ class Message : public AttributedItem {
   /** the @a DataField for encoding/decoding the message. */
   const DataField* m_data;
 
-  /** whether to delete the @a DataField during destruction. */
-  const bool m_deleteData;
+  /** whether to delete the @a DataField during destruction (handed over with the scan @a Message of a
+   * @a MessageMap in @a MessageMap::swapDefinitions()). */
+  bool m_deleteData;
 
   /** the priority for polling, or 0 for no polling at all. */
   size_t m_pollPriority;
@@ -647,6 +710,80 @@ class Message : public AttributedItem {
 
   /** the system time when this message was last polled for, 0 for never. */
   time_t m_lastPollTime;
+
+  /** the @a MessageJournal to record updates in, or nullptr. */
+  MessageJournal* m_journal;
+
+  /** the journal sequence number of the last update, 0 for never. */
+  uint64_t m_lastUpdateSequence;
+
+  /** the journal sequence number of the last change, 0 for never. */
+  uint64_t m_lastChangeSequence;
+
+  /** the version of the last seen data, incremented whenever the data is modified (read without any lock). */
+  std::atomic<unsigned int> m_dataVersion;
+
+  /** the @a Mutex for accessing @a m_decodeCache and @a m_lastValues. */
+  mutable Mutex m_decodeCacheMutex;
+
+  /** the cached formatted values decoded from the last seen data (at most @a MAX_DECODE_CACHE_ENTRIES). */
+  mutable vector<DecodeCacheEntry> m_decodeCache;
+
+  /** the data version @a m_lastValues were read from. */
+  mutable unsigned int m_lastValuesVersion;
+
+  /** the numeric values read from the last seen data by field index (excluding ignored fields). */
+  mutable vector<NumericValue> m_lastValues;
+
+  /** the @a Condition instances referring to this message. */
+  vector<Condition*> m_dependentConditions;
+
+  /**
+   * Mark the last seen data as modified for invalidating the cached decoded values and dependent conditions.
+   */
+  void dataChanged();
+
+  /**
+   * Get the numeric value of the field at the specified overall index from the last stored data.
+   * @param index the overall index of the field (excluding ignored fields), or -1.
+   * @param value the @a NumericValue in which to store the value.
+   * @return @a RESULT_OK on success, @a RESULT_EMPTY if the field has no numeric value,
+   * @a RESULT_ERR_OUT_OF_RANGE if only the raw value is available, or @a RESULT_ERR_NOTFOUND if the field is not
+   * available.
+   */
+  result_t getLastValueAt(ssize_t index, NumericValue* value) const;
+
+  /**
+   * Decode the value from the last stored data without using the cache.
+   * @param partType the @a PartType to decode (@a pt_any for master and slave data).
+   * @param leadingSeparator whether to prepend a separator before the formatted value.
+   * @param fieldName the optional name of a field to limit the output to.
+   * @param fieldIndex the optional index of the field to limit the output to (either named or overall), or -1.
+   * @param outputFormat the @a OutputFormat options to use.
+   * @param output the @a ostream to append the formatted value to.
+   * @return @a RESULT_OK on success, or an error code.
+   */
+  result_t decodeLastDataUncached(PartType partType, bool leadingSeparator, const char* fieldName,
+      ssize_t fieldIndex, OutputFormat outputFormat, ostream* output) const;
+
+  /**
+   * Decode the value from the last stored data using the cache.
+   * @param partType the @a PartType to decode (@a pt_any for master and slave data).
+   * @param leadingSeparator whether to prepend a separator before the formatted value.
+   * @param fieldName the optional name of a field to limit the output to.
+   * @param fieldIndex the optional index of the field to limit the output to (either named or overall), or -1.
+   * @param outputFormat the @a OutputFormat options to use.
+   * @param output the @a ostream to append the formatted value to.
+   * @return @a RESULT_OK on success, or an error code.
+   */
+  result_t decodeLastDataCached(PartType partType, bool leadingSeparator, const char* fieldName,
+      ssize_t fieldIndex, OutputFormat outputFormat, ostream* output) const;
+
+  /**
+   * Record an update in the @a MessageJournal (if any).
+   * @param changed whether the data was changed.
+   */
+  void journalUpdate(bool changed);
 };
 
 
@@ -798,6 +935,235 @@ class MessagePriorityQueue
 };
 
 
+/**
+ * Helper class mapping a numeric key to a value using open addressing.
+ * The values are stored contiguously in insertion order (until removal) and the hash slots only keep the index
+ * into the values, so that a lookup usually touches just one slot and one value.
+ * @param V the value type.
+ */
+template <typename V>
+class KeyMap {
+ public:
+  /**
+   * Construct a new empty instance.
+   */
+  KeyMap() : m_mask(0) {}
+
+  /**
+   * Get the stored value for the key.
+   * @param key the key of the value.
+   * @return the stored value, or nullptr.
+   */
+  const V* find(uint64_t key) const {
+    size_t pos = findSlot(key);
+    return m_slots.empty() || m_slots[pos] == 0 ? nullptr : &m_values[m_slots[pos]-1];
+  }
+
+  /**
+   * Get the stored value for the key.
+   * @param key the key of the value.
+   * @return the stored value, or nullptr.
+   */
+  V* find(uint64_t key) {
+    size_t pos = findSlot(key);
+    return m_slots.empty() || m_slots[pos] == 0 ? nullptr : &m_values[m_slots[pos]-1];
+  }
+
+  /**
+   * Get the stored value for the key and create a default value if not yet present.
+   * @param key the key of the value.
+   * @return the stored value.
+   * Note: the returned reference is only valid until the next modification of this instance.
+   */
+  V& operator[](uint64_t key) {
+    size_t pos = findSlot(key);
+    if (!m_slots.empty() && m_slots[pos] != 0) {
+      return m_values[m_slots[pos]-1];
+    }
+    if ((m_keys.size()+1)*4 > m_slots.size()*3) {  // keep the load factor below 75%
+      rehash(m_slots.empty() ? 64 : m_slots.size()*2);
+      pos = findSlot(key);
+    }
+    m_keys.push_back(key);
+    m_values.emplace_back();
+    m_slots[pos] = (uint32_t)m_keys.size();
+    return m_values.back();
+  }
+
+  /**
+   * Remove the value for the key.
+   * @param key the key of the value.
+   * @return true when the key was removed, false if it was not present.
+   */
+  bool erase(uint64_t key) {
+    size_t pos = findSlot(key);
+    if (m_slots.empty() || m_slots[pos] == 0) {
+      return false;
+    }
+    size_t index = m_slots[pos]-1;
+    size_t last = m_keys.size()-1;
+    if (index != last) {
+      // move the last entry to the freed index
+      size_t lastPos = findSlot(m_keys[last]);
+      m_keys[index] = m_keys[last];
+      std::swap(m_values[index], m_values[last]);
+      m_slots[lastPos] = (uint32_t)(index+1);
+    }
+    m_keys.pop_back();
+    m_values.pop_back();
+    // shift following entries of the same probe sequence backwards instead of leaving a tombstone
+    size_t next = pos;
+    while (true) {
+      next = (next+1) & m_mask;
+      if (m_slots[next] == 0) {
+        break;
+      }
+      size_t home = hashSlot(m_keys[m_slots[next]-1]);
+      if (((next-home) & m_mask) >= ((next-pos) & m_mask)) {
+        m_slots[pos] = m_slots[next];
+        pos = next;
+      }
+    }
+    m_slots[pos] = 0;
+    return true;
+  }
+
+  /**
+   * Remove all entries.
+   */
+  void clear() {
+    m_slots.clear();
+    m_keys.clear();
+    m_values.clear();
+    m_mask = 0;
+  }
+
+  /**
+   * Exchange all entries with another instance.
+   * @param other the other instance.
+   */
+  void swap(KeyMap<V>& other) {
+    m_slots.swap(other.m_slots);
+    m_keys.swap(other.m_keys);
+    m_values.swap(other.m_values);
+    size_t mask = m_mask;
+    m_mask = other.m_mask;
+    other.m_mask = mask;
+  }
+
+  /**
+   * Return whether this instance is empty.
+   * @return whether this instance is empty.
+   */
+  bool empty() const { return m_keys.empty(); }
+
+  /**
+   * Get the number of distinct keys.
+   * @return the number of distinct keys.
+   */
+  size_t size() const { return m_keys.size(); }
+
+  /**
+   * Get the stored key by index.
+   * @param index the index of the entry (less than @a size()).
+   * @return the stored key.
+   */
+  uint64_t getKey(size_t index) const { return m_keys[index]; }
+
+  /**
+   * Get the stored value by index.
+   * @param index the index of the entry (less than @a size()).
+   * @return the stored value.
+   */
+  const V& getValue(size_t index) const { return m_values[index]; }
+
+
+ private:
+  /**
+   * Calculate the hash slot for the key.
+   * @param key the key to hash.
+   * @return the preferred slot position.
+   */
+  size_t hashSlot(uint64_t key) const {
+    // Fibonacci hashing spreads the few varying bits of the key over the whole slot range
+    return (size_t)((key * 0x9e3779b97f4a7c15ULL) >> 32) & m_mask;
+  }
+
+  /**
+   * Find the slot position of the key, or the empty slot where it would be inserted.
+   * @param key the key to find.
+   * @return the slot position (only valid if not empty).
+   */
+  size_t findSlot(uint64_t key) const {
+    if (m_slots.empty()) {
+      return 0;
+    }
+    size_t pos = hashSlot(key);
+    while (m_slots[pos] != 0 && m_keys[m_slots[pos]-1] != key) {
+      pos = (pos+1) & m_mask;
+    }
+    return pos;
+  }
+
+  /**
+   * Resize the slots to the specified capacity and re-insert all keys.
+   * @param capacity the new capacity (power of 2).
+   */
+  void rehash(size_t capacity) {
+    m_slots.assign(capacity, 0);
+    m_mask = capacity-1;
+    for (size_t index = 0; index < m_keys.size(); index++) {
+      m_slots[findSlot(m_keys[index])] = (uint32_t)(index+1);
+    }
+  }
+
+  /** the bit mask for the slot position (capacity-1). */
+  size_t m_mask;
+
+  /** the hash slots with the index into @a m_keys and @a m_values plus one, or 0 for an empty slot. */
+  vector<uint32_t> m_slots;
+
+  /** the stored keys. */
+  vector<uint64_t> m_keys;
+
+  /** the stored values in the same order as @a m_keys. */
+  vector<V> m_values;
+};
+
+
+/** the @a Message instances by key. */
+typedef KeyMap< vector<Message*> > MessageKeyMap;
+
+
+/**
+ * Helper class for the @a Message instances sharing the same key within a @a MessageDispatchMap.
+ */
+class MessageDispatchEntry {
+ public:
+  /** the @a Message key. */
+  uint64_t m_key;
+
+  /** the number of ID bytes in addition to PB and SB covered by the key. */
+  size_t m_idLength;
+
+  /** the lookup order within the same ID length (0=passive from specific source, 1=passive from any source,
+   * 2=active read, 3=active write). */
+  int m_rank;
+
+  /** the source master number (only relevant for passive from specific source). */
+  unsigned int m_source;
+
+  /** the @a Message instances with this key in the same order as in @a MessageKeyMap. */
+  vector<Message*> m_messages;
+};
+
+
+/**
+ * The @a MessageDispatchEntry lists by destination address, PB, and SB, each sorted in lookup order.
+ */
+typedef KeyMap< vector<MessageDispatchEntry> > MessageDispatchMap;
+
+
 /**
  * An abstract condition based on the value of one or more @a Message instances.
  */
@@ -807,7 +1173,7 @@ class Condition {
    * Construct a new instance.
    */
   Condition()
-    : m_lastCheckTime(0), m_isTrue(false) { }
+    : m_isTrue(false), m_needsCheck(true) { }
 
   /**
    * Destructor.
@@ -856,19 +1222,42 @@ class Condition {
   virtual result_t resolve(void (*readMessageFunc)(Message* message), MessageMap* messages,
       ostringstream* errorMessage) = 0;
 
+  /**
+   * Add a @a Condition depending on the result of this one (i.e. a @a CombinedCondition containing this one).
+   * @param dependent the dependent @a Condition.
+   */
+  void addDependent(Condition* dependent);
+
+  /**
+   * Invalidate the cached result of this condition and all of its dependents, so that it is evaluated again on the
+   * next check (only while holding the lock for the dependencies).
+   */
+  void invalidate();
+
   /**
    * Check and return whether this condition is fulfilled.
-   * @return whether this condition is fulfilled.
+   * @return whether this condition is fulfilled (only evaluated again after being invalidated).
    */
-  virtual bool isTrue() = 0;
+  bool isTrue();
 
 
  protected:
-  /** the system time when the condition was last checked, 0 for never. */
-  time_t m_lastCheckTime;
+  /**
+   * Evaluate whether this condition is fulfilled.
+   * @return whether this condition is fulfilled.
+   */
+  virtual bool evaluate() = 0;
+
+  /** whether the condition was @a true during the last check (returned without evaluating by concurrent checks). */
+  std::atomic<bool> m_isTrue;
 
-  /** whether the condition was @a true during the last check. */
-  bool m_isTrue;
+
+ private:
+  /** whether the condition needs to be evaluated again on the next check. */
+  std::atomic<bool> m_needsCheck;
+
+  /** the @a Condition instances depending on the result of this one. */
+  vector<Condition*> m_dependents;
 };
 
 
@@ -913,9 +1302,6 @@ class SimpleCondition : public Condition {
   result_t resolve(void (*readMessageFunc)(Message* message), MessageMap* messages,
       ostringstream* errorMessage) override;
 
-  // @copydoc
-  bool isTrue() override;
-
   /**
    * Return whether the condition is based on a numeric value.
    * @return whether the condition is based on a numeric value.
@@ -924,6 +1310,9 @@ class SimpleCondition : public Condition {
 
 
  protected:
+  // @copydoc
+  bool evaluate() override;
+
   /**
    * Check the values against the field in the @a Message.
    * @param message the @a Message to check against.
@@ -1066,14 +1455,20 @@ class CombinedCondition : public Condition {
   void dump(bool matched, ostream* output) const override;
 
   // @copydoc
-  CombinedCondition* combineAnd(Condition* other) override { m_conditions.push_back(other); return this; }
+  CombinedCondition* combineAnd(Condition* other) override {
+    m_conditions.push_back(other);
+    other->addDependent(this);
+    return this;
+  }
 
   // @copydoc
   result_t resolve(void (*readMessageFunc)(Message* message), MessageMap* messages,
       ostringstream* errorMessage) override;
 
+
+ protected:
   // @copydoc
-  bool isTrue() override;
+  bool evaluate() override;
 
 
  private:
@@ -1209,6 +1604,235 @@ class LoadedFileInfo {
 };
 
 
+/**
+ * Helper class for an entry in the @a MessageJournal.
+ */
+class MessageJournalEntry {
+ public:
+  /** the journal sequence number. */
+  uint64_t m_sequence;
+
+  /** the updated @a Message, or nullptr if it was removed in the meantime. */
+  Message* m_message;
+
+  /** whether the data was changed. */
+  bool m_changed;
+};
+
+
+/**
+ * Interface for getting notified of @a Message updates recorded in a @a MessageJournal.
+ */
+class MessageUpdateListener {
+ public:
+  /**
+   * Destructor.
+   */
+  virtual ~MessageUpdateListener() {}
+
+  /**
+   * Called after an update of a @a Message was recorded.
+   * Note: this is called from the thread storing the data while the journal is locked, so it has to return quickly.
+   * @param changed whether the data was changed.
+   */
+  virtual void notifyMessageUpdate(bool changed) = 0;
+};
+
+
+/**
+ * A bounded journal of @a Message updates with increasing sequence numbers.
+ */
+class MessageJournal {
+ public:
+  /**
+   * Construct a new instance.
+   */
+  MessageJournal() : m_sequence(0), m_droppedSequence(0) {}
+
+  /**
+   * Record an update of a @a Message.
+   * @param message the updated @a Message.
+   * @param changed whether the data was changed.
+   */
+  void add(Message* message, bool changed);
+
+  /**
+   * Get the @a Message instances updated after the specified sequence number.
+   * @param sequence pointer to the sequence number of the last seen update, set to the latest one.
+   * @param changedOnly true to only include messages with changed data, false to include all updated ones.
+   * @param messages the @a deque to which to add the (distinct) updated @a Message instances.
+   * @return true on success, false if the journal no longer contains all updates after the sequence number.
+   */
+  bool find(uint64_t* sequence, bool changedOnly, deque<Message*>* messages);
+
+  /**
+   * Forget all updates of a @a Message that is about to be removed.
+   * @param message the @a Message.
+   */
+  void remove(const Message* message);
+
+  /**
+   * Forget all updates and let readers of any previous sequence number start over.
+   */
+  void clear();
+
+  /**
+   * Get the sequence number of the latest update.
+   * @return the sequence number of the latest update.
+   */
+  uint64_t getSequence() { m_mutex.lock(); uint64_t ret = m_sequence; m_mutex.unlock(); return ret; }
+
+  /**
+   * Add a @a MessageUpdateListener to notify of each recorded update.
+   * @param listener the @a MessageUpdateListener to add.
+   */
+  void addListener(MessageUpdateListener* listener);
+
+  /**
+   * Remove a previously added @a MessageUpdateListener.
+   * @param listener the @a MessageUpdateListener to remove.
+   */
+  void removeListener(MessageUpdateListener* listener);
+
+
+ private:
+  /** @a Mutex for exclusive access. */
+  Mutex m_mutex;
+
+  /** the @a MessageUpdateListener instances to notify of each recorded update. */
+  vector<MessageUpdateListener*> m_listeners;
+
+  /** the recorded updates in order of their sequence number. */
+  deque<MessageJournalEntry> m_entries;
+
+  /** the sequence number of the latest update. */
+  uint64_t m_sequence;
+
+  /** the sequence number of the latest update that is no longer available. */
+  uint64_t m_droppedSequence;
+};
+
+
+/**
+ * Collects the last data of updated @a Message instances for publishing it as JSON document per circuit or for all
+ * circuits at once.
+ */
+class MessageBatch {
+ public:
+  /**
+   * Construct a new instance.
+   */
+  MessageBatch() : m_sequence(0) {}
+
+  /**
+   * Add the decoded last data of a @a Message, replacing that of a previously added one with the same circuit and
+   * name.
+   * @param message the @a Message to add.
+   * @param outputFormat the @a OutputFormat options to use (JSON with names is always used).
+   * @param buffer the @a OutputBuffer to use for decoding.
+   * @return @a RESULT_OK on success, or an error code.
+   */
+  result_t add(const Message* message, OutputFormat outputFormat, OutputBuffer* buffer);
+
+  /**
+   * Return whether no data was added since the last build.
+   * @return whether no data was added since the last build.
+   */
+  bool empty() const { return m_circuits.empty(); }
+
+  /**
+   * Build the JSON documents with the next sequence number from the added data and forget the data afterwards.
+   * @param perCircuit true for one document per circuit, false for a single document for all circuits.
+   * @param buffer the @a OutputBuffer to use for building.
+   * @param documents the @a vector to which to add the circuit name (empty for all circuits) and the JSON document.
+   */
+  void build(bool perCircuit, OutputBuffer* buffer, vector<pair<string, string>>* documents);
+
+
+ private:
+  /** the decoded data by message name and circuit. */
+  map<string, map<string, string>> m_circuits;
+
+  /** the sequence number of the last built documents. */
+  unsigned int m_sequence;
+};
+
+
+/**
+ * Queues the data updates of topics for publishing them combined per topic, within a rate limit, and without
+ * repeating the data last taken for a topic.
+ */
+class PublishQueue {
+ public:
+  /**
+   * Construct a new instance.
+   * @param coalesceMillis the time in milliseconds for combining updates of the same topic, or 0.
+   * @param maxRate the maximum number of updates to take per second, or 0 for no limit.
+   * @param dedup whether to skip data identical to the last one taken for the topic.
+   */
+  PublishQueue(unsigned int coalesceMillis, unsigned int maxRate, bool dedup)
+  : m_coalesceMillis(coalesceMillis), m_maxRate(maxRate), m_dedup(dedup), m_rateStart(0), m_rateCount(0) {}
+
+  /**
+   * Add a topic update, combining it with a still pending update of the same topic.
+   * @param topic the topic string.
+   * @param data the data string.
+   * @param now the current time in milliseconds.
+   * @return true when neither combining nor the rate limit apply and the update is to be published right away,
+   * false when it was queued or is identical to the last data taken for the topic.
+   */
+  bool add(const string& topic, const string& data, uint64_t now);
+
+  /**
+   * Take the queued updates that are due within the rate limit.
+   * @param now the current time in milliseconds.
+   * @param updates the @a vector to which to add the topic and data of the updates to publish.
+   * @return the time in milliseconds until the next queued update is due, or -1 if none is queued.
+   */
+  int take(uint64_t now, vector<pair<string, string>>* updates);
+
+  /**
+   * Forget the data last taken for each topic, e.g. after reconnecting to a broker that may no longer have it.
+   */
+  void clearTaken() { m_takenHashes.clear(); }
+
+
+ private:
+  /**
+   * Check whether the data differs from the last one taken for the topic and remember it when skipping identical
+   * data.
+   * @param topic the topic string.
+   * @param data the data string.
+   * @return true when the data is to be published.
+   */
+  bool isChanged(const string& topic, const string& data);
+
+  /** the time in milliseconds for combining updates of the same topic, or 0. */
+  const unsigned int m_coalesceMillis;
+
+  /** the maximum number of updates to take per second, or 0 for no limit. */
+  const unsigned int m_maxRate;
+
+  /** whether to skip data identical to the last one taken for the topic. */
+  const bool m_dedup;
+
+  /** the data of the queued updates by topic. */
+  map<string, string> m_queued;
+
+  /** the due time in milliseconds and topic of the queued updates in order. */
+  deque<pair<uint64_t, string>> m_queuedOrder;
+
+  /** the hash of the last taken data by topic (only when skipping identical data). */
+  map<string, size_t> m_takenHashes;
+
+  /** the start time in milliseconds of the current rate interval. */
+  uint64_t m_rateStart;
+
+  /** the number of updates taken in the current rate interval. */
+  unsigned int m_rateCount;
+};
+
+
 /**
  * Holds a map of all known @a Message instances.
  */
@@ -1222,8 +1846,9 @@ class MessageMap : public MappedFileReader {
    */
   explicit MessageMap(bool addAll = false, const string& preferLanguage = "", bool deleteData = true)
   : MappedFileReader::MappedFileReader(true),
-    m_addAll(addAll), m_additionalScanMessages(false), m_maxIdLength(0), m_maxBroadcastIdLength(0),
-    m_messageCount(0), m_conditionalMessageCount(0), m_passiveMessageCount(0) {
+    m_addAll(addAll), m_additionalScanMessages(false),
+    m_messageCount(0), m_conditionalMessageCount(0), m_passiveMessageCount(0), m_definitionVersion(0),
+    m_generation(0) {
     m_scanMessage = Message::createScanMessage(false, deleteData);
     m_broadcastScanMessage = Message::createScanMessage(true, false);
   }
@@ -1233,6 +1858,10 @@ class MessageMap : public MappedFileReader {
    */
   virtual ~MessageMap() {
     clear();
+    for (const auto& it : m_retiredDefinitions) {
+      delete it.second;
+    }
+    m_retiredDefinitions.clear();
     if (m_scanMessage) {
       delete m_scanMessage;
       m_scanMessage = nullptr;
@@ -1384,6 +2013,28 @@ class MessageMap : public MappedFileReader {
   Message* find(const string& circuit, const string& name, const string& levels, bool isWrite,
     bool isPassive = false) const;
 
+  /**
+   * Find all @a Message instances stored for the specified circuit and name regardless of their availability.
+   * @param circuit the optional circuit name.
+   * @param name the message name.
+   * @param isWrite whether this is a write message.
+   * @param isPassive whether this is a passive message.
+   * @return the @a Message instances to pass to @a findAvailable(), or nullptr. The returned pointer is only valid
+   * until the definitions change (see @a getDefinitionVersion()).
+   * Note: the caller may not free the returned instances.
+   */
+  const vector<Message*>* findCandidates(const string& circuit, const string& name, bool isWrite,
+    bool isPassive = false) const;
+
+  /**
+   * Get the first available @a Message instance of the ones found by @a findCandidates().
+   * @param candidates the @a Message instances found by @a findCandidates(), or nullptr.
+   * @param levels the access levels to match.
+   * @return the @a Message instance, or nullptr.
+   * Note: the caller may not free the returned instance.
+   */
+  static Message* findAvailable(const vector<Message*>* candidates, const string& levels);
+
   /**
    * Find all active get @a Message instances for the specified circuit and name.
    * Note: the caller may not free the returned instances.
@@ -1411,15 +2062,40 @@ class MessageMap : public MappedFileReader {
     time_t since, time_t until, bool changedSince, deque<Message*>* messages) const;
 
   /**
-   * Get the first available @a Message from the first map iterator entry.
-   * @param it the map iterator with list of @a Message instances to check.
-   * @param sameIdExtAs the optional @a MasterSymbolString to check for having the same ID.
-   * @param onlyAvailable true to include only available messages (default true), false to also include messages that
-   * are currently not available (e.g. due to unresolved or false conditions).
-   * @return the first available @a Message from the first map iterator entry.
+   * Find all @a Message instances updated after the specified journal sequence number.
+   * Note: the caller may not free the returned instances.
+   * @param levels the access levels to match.
+   * @param changedOnly true to only include messages with changed data, false to include all updated ones.
+   * @param sequence pointer to the journal sequence number of the last seen update, set to the latest one.
+   * @param messages the @a deque to which to add the found @a Message instances.
+   * @return true on success, false if the journal no longer contains all updates after the sequence number (in
+   * which case @a findAll() with a time range has to be used instead).
+   */
+  bool findUpdates(const string& levels, bool changedOnly, uint64_t* sequence, deque<Message*>* messages);
+
+  /**
+   * Get the journal sequence number of the latest update.
+   * @return the journal sequence number of the latest update.
+   */
+  uint64_t getUpdateSequence() { return m_journal.getSequence(); }
+
+  /**
+   * Get the version of the stored definitions that changes whenever a @a Message is added, removed, or replaced.
+   * @return the version of the stored definitions.
    */
-  Message* getFirstAvailableFromIterator(const map<uint64_t, vector<Message*> >::const_iterator& it,
-    const MasterSymbolString* sameIdExtAs, bool onlyAvailable) const;
+  uint64_t getDefinitionVersion() const { return m_definitionVersion; }
+
+  /**
+   * Add a @a MessageUpdateListener to notify of each recorded update of a @a Message in this map.
+   * @param listener the @a MessageUpdateListener to add.
+   */
+  void addUpdateListener(MessageUpdateListener* listener) { m_journal.addListener(listener); }
+
+  /**
+   * Remove a previously added @a MessageUpdateListener.
+   * @param listener the @a MessageUpdateListener to remove.
+   */
+  void removeUpdateListener(MessageUpdateListener* listener) { m_journal.removeListener(listener); }
 
   /**
    * Find the @a Message instance for the specified master data.
@@ -1468,11 +2144,53 @@ class MessageMap : public MappedFileReader {
    */
   void unlock() { m_mutex.unlock(); }
 
+  /**
+   * Lock this instance for reading access shared with other readers.
+   */
+  void lockShared() { m_mutex.lockShared(); }
+
+  /**
+   * Unlock this instance from reading access shared with other readers.
+   */
+  void unlockShared() { m_mutex.unlockShared(); }
+
   /**
    * Removes all @a Message instances.
    */
   void clear();
 
+  /**
+   * Exchange all definitions (messages including the scan messages, conditions, instructions, circuit data, and
+   * loaded files) with the ones of another instance that was loaded separately while this instance kept serving
+   * readers.
+   * The last seen data of each previous @a Message with the same key and definition is carried over to its
+   * replacement. The definitions are compared beforehand, so that only a short exclusive lock is needed.
+   * @param other the @a MessageMap with the new definitions, receiving the previous ones. It is owned by this
+   * instance afterwards and freed by @a freeRetiredDefinitions() once no longer held by any thread.
+   */
+  void swapDefinitions(MessageMap* other);
+
+  /**
+   * Keep the current definitions alive until released again, so that the @a Message and @a Condition instances
+   * looked up after this call stay valid even when they get replaced by @a swapDefinitions() in the meantime.
+   * This is needed by all threads using such an instance outside of a lock, except for the one calling
+   * @a swapDefinitions() and @a freeRetiredDefinitions().
+   * @return the hold to pass to @a releaseDefinitions().
+   */
+  uint64_t holdDefinitions();
+
+  /**
+   * Release the definitions kept alive by @a holdDefinitions().
+   * @param hold the hold returned by @a holdDefinitions().
+   */
+  void releaseDefinitions(uint64_t hold);
+
+  /**
+   * Free the previous definitions replaced by @a swapDefinitions() that are no longer held by any thread.
+   * @return the number of previous definitions still held.
+   */
+  size_t freeRetiredDefinitions();
+
   /**
    * Get the number of all stored @a Message instances.
    * @return the the number of all stored @a Message instances.
@@ -1525,6 +2243,26 @@ class MessageMap : public MappedFileReader {
 
 
  private:
+  /**
+   * Carry over the last seen data of a previous @a Message to its replacement.
+   * @param previous the previous @a Message.
+   * @param message the replacing @a Message.
+   */
+  static void carryLastData(const Message* previous, Message* message);
+
+  /**
+   * Add a @a Message to the @a MessageDispatchMap.
+   * @param message the @a Message to add.
+   */
+  void addDispatch(Message* message);
+
+  /**
+   * Remove a @a Message from the @a MessageDispatchMap.
+   * @param key the key of the @a Message.
+   * @param message the @a Message to remove.
+   */
+  void removeDispatch(uint64_t key, const Message* message);
+
   /** empty vector for @a getLoadedFiles(). */
   static vector<string> s_noFiles;
 
@@ -1546,12 +2284,6 @@ class MessageMap : public MappedFileReader {
   /** the @a LoadedFileInfo by for load configuration files (by file name with relative path). */
   map<string, LoadedFileInfo> m_loadedFileInfos;
 
-  /** the maximum ID length used by any of the known @a Message instances. */
-  size_t m_maxIdLength;
-
-  /** the maximum ID length used by any of the known @a Message instances with destination @a BROADCAST. */
-  size_t m_maxBroadcastIdLength;
-
   /** the number of distinct @a Message instances stored in @a m_messagesByName. */
   size_t m_messageCount;
 
@@ -1561,11 +2293,20 @@ class MessageMap : public MappedFileReader {
   /** the number of distinct passive @a Message instances stored in @a m_messagesByKey. */
   size_t m_passiveMessageCount;
 
+  /** the version of the stored definitions, incremented on each modification of the @a Message instances. */
+  std::atomic<uint64_t> m_definitionVersion;
+
   /** the known @a Message instances by lowercase circuit (optional), name, and type. */
   map<string, vector<Message*> > m_messagesByName;
 
   /** the known @a Message instances by key. */
-  map<uint64_t, vector<Message*> > m_messagesByKey;
+  MessageKeyMap m_messagesByKey;
+
+  /** the known @a Message instances by destination address, PB, and SB for the lookup from master data. */
+  MessageDispatchMap m_messagesByHeader;
+
+  /** the @a MessageJournal of updates to the @a Message instances stored by name. */
+  MessageJournal m_journal;
 
   /** the known @a Message instances to poll, by priority. */
   MessagePriorityQueue m_pollMessages;
@@ -1578,6 +2319,18 @@ class MessageMap : public MappedFileReader {
 
   /** additional attributes by circuit name. */
   map<string, AttributedItem*> m_circuitData;
+
+  /** the @a Mutex for accessing @a m_generation, @a m_definitionHolds, and @a m_retiredDefinitions. */
+  Mutex m_holdMutex;
+
+  /** the generation of the current definitions, incremented by each @a swapDefinitions(). */
+  uint64_t m_generation;
+
+  /** the number of holds taken by @a holdDefinitions() by generation (entries without hold are dropped lazily). */
+  map<uint64_t, unsigned int> m_definitionHolds;
+
+  /** the previous definitions replaced by @a swapDefinitions() with the last generation they were current in. */
+  deque<pair<uint64_t, MessageMap*>> m_retiredDefinitions;
 };
 
 }  // namespace ebusd
@@ -0,0 +1,119 @@
+/*
+ * ebusd - daemon for communication with eBUS heating systems.
+ * Copyright (C) 2014-2021 John Baier <ebusd@ebusd.eu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lib/ebus/outputbuffer.h"
+#include <cstdio>
+#include <iomanip>
+#include <string>
+
+namespace ebusd {
+
+static const char* hexDigits = "0123456789abcdef";
+
+void OutputBuffer::reset() {
+  m_buffer.m_data.clear();
+  clear();
+  flags(std::ios_base::dec | std::ios_base::skipws);
+  width(0);
+  precision(6);
+  fill(' ');
+}
+
+void OutputBuffer::truncate(size_t length) {
+  if (length < m_buffer.m_data.size()) {
+    m_buffer.m_data.resize(length);
+  }
+}
+
+void OutputBuffer::appendInt(int value, ostream* output) {
+  if (value < 0) {
+    output->rdbuf()->sputc('-');
+    appendUnsigned(0u - static_cast<unsigned int>(value), output);
+  } else {
+    appendUnsigned(static_cast<unsigned int>(value), output);
+  }
+}
+
+void OutputBuffer::appendUnsigned(unsigned int value, ostream* output) {
+  char buf[10];
+  char* pos = buf + sizeof(buf);
+  do {
+    *--pos = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value);
+  output->rdbuf()->sputn(pos, buf + sizeof(buf) - pos);
+}
+
+void OutputBuffer::appendFixed(double value, int precision, ostream* output) {
+  char buf[64];
+  int len = snprintf(buf, sizeof(buf), "%.*f", precision, value);
+  if (len <= 0 || len >= static_cast<int>(sizeof(buf))) {
+    *output << std::fixed << std::setprecision(precision) << value;  // out of buffer range
+    return;
+  }
+  output->rdbuf()->sputn(buf, len);
+}
+
+void OutputBuffer::appendHex(unsigned char value, ostream* output) {
+  char buf[2] = {hexDigits[value >> 4], hexDigits[value & 0x0f]};
+  output->rdbuf()->sputn(buf, 2);
+}
+
+void OutputBuffer::appendJsonString(const string& value, ostream* output) {
+  streambuf* buf = output->rdbuf();
+  const char* str = value.data();
+  size_t start = 0, length = value.length();
+  for (size_t pos = 0; pos < length; pos++) {
+    unsigned char ch = static_cast<unsigned char>(str[pos]);
+    if (ch >= 0x20 && ch != '"' && ch != '\\') {
+      continue;
+    }
+    buf->sputn(str + start, static_cast<streamsize>(pos - start));
+    start = pos + 1;
+    if (ch == '"' || ch == '\\') {
+      buf->sputc('\\');
+      buf->sputc(static_cast<char>(ch));
+    } else {
+      char escaped[6] = {'\\', 'u', '0', '0', hexDigits[ch >> 4], hexDigits[ch & 0x0f]};
+      buf->sputn(escaped, 6);
+    }
+  }
+  buf->sputn(str + start, static_cast<streamsize>(length - start));
+}
+
+OutputBuffer::StringBuffer::int_type OutputBuffer::StringBuffer::overflow(int_type ch) {
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    m_data.push_back(traits_type::to_char_type(ch));
+  }
+  return traits_type::not_eof(ch);
+}
+
+streamsize OutputBuffer::StringBuffer::xsputn(const char* str, streamsize count) {
+  m_data.append(str, static_cast<size_t>(count));
+  return count;
+}
+
+OutputBuffer::StringBuffer::pos_type OutputBuffer::StringBuffer::seekoff(off_type off, std::ios_base::seekdir dir,
+    std::ios_base::openmode which) {
+  if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out)) {
+    return pos_type(off_type(-1));  // only telling the current position is supported
+  }
+  return pos_type(static_cast<off_type>(m_data.size()));
+}
+
+}  // namespace ebusd
@@ -0,0 +1,180 @@
+/*
+ * ebusd - daemon for communication with eBUS heating systems.
+ * Copyright (C) 2014-2021 John Baier <ebusd@ebusd.eu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_EBUS_OUTPUTBUFFER_H_
+#define LIB_EBUS_OUTPUTBUFFER_H_
+
+#include <string>
+#include <iostream>
+
+namespace ebusd {
+
+/** @file lib/ebus/outputbuffer.h
+ * Classes for appending formatted values to an output without the locale
+ * and formatting state overhead of the stream operators.
+ *
+ * The static append methods of @a OutputBuffer write directly to the
+ * @a streambuf of any @a ostream (e.g. an @a ostringstream), so that they can
+ * be used in the decoding paths regardless of the actual output.
+ *
+ * An @a OutputBuffer instance itself is an @a ostream appending to a
+ * @a string that keeps its capacity when being reset, so that it can be reused
+ * for many messages without allocating fresh strings.
+ */
+
+using std::string;
+using std::ostream;
+using std::streambuf;
+using std::streamsize;
+
+/**
+ * An append-only output buffer usable as @a ostream.
+ */
+class OutputBuffer : public ostream {
+ public:
+  /**
+   * Construct a new empty instance.
+   */
+  OutputBuffer() : ostream(nullptr) { rdbuf(&m_buffer); }
+
+  /**
+   * Destructor.
+   */
+  virtual ~OutputBuffer() {}
+
+  /**
+   * Get the content of the buffer.
+   * @return the content of the buffer (only valid until the next modification).
+   */
+  const string& str() const { return m_buffer.m_data; }
+
+  /**
+   * Get the length of the content.
+   * @return the length of the content.
+   */
+  size_t size() const { return m_buffer.m_data.size(); }
+
+  /**
+   * Return whether the buffer is empty.
+   * @return whether the buffer is empty.
+   */
+  bool empty() const { return m_buffer.m_data.empty(); }
+
+  /**
+   * Remove the content and reset the stream state and formatting, but keep the allocated capacity.
+   */
+  void reset();
+
+  /**
+   * Truncate the content.
+   * @param length the new length of the content (if smaller than the current length).
+   */
+  void truncate(size_t length);
+
+  /**
+   * Append characters.
+   * @param str the characters to append.
+   * @param length the number of characters to append.
+   * @param output the @a ostream to append to.
+   */
+  static void append(const char* str, size_t length, ostream* output) {
+    output->rdbuf()->sputn(str, static_cast<streamsize>(length));
+  }
+
+  /**
+   * Append a @a string.
+   * @param str the @a string to append.
+   * @param output the @a ostream to append to.
+   */
+  static void append(const string& str, ostream* output) {
+    output->rdbuf()->sputn(str.data(), static_cast<streamsize>(str.length()));
+  }
+
+  /**
+   * Append a single character.
+   * @param ch the character to append.
+   * @param output the @a ostream to append to.
+   */
+  static void append(char ch, ostream* output) { output->rdbuf()->sputc(ch); }
+
+  /**
+   * Append a decimal integer.
+   * @param value the value to append.
+   * @param output the @a ostream to append to.
+   */
+  static void appendInt(int value, ostream* output);
+
+  /**
+   * Append a decimal unsigned integer.
+   * @param value the value to append.
+   * @param output the @a ostream to append to.
+   */
+  static void appendUnsigned(unsigned int value, ostream* output);
+
+  /**
+   * Append a fixed point number (equal to the output of the stream in fixed format with the same precision).
+   * @param value the value to append.
+   * @param precision the number of fraction digits.
+   * @param output the @a ostream to append to.
+   */
+  static void appendFixed(double value, int precision, ostream* output);
+
+  /**
+   * Append a byte as two lower case hex digits.
+   * @param value the byte to append.
+   * @param output the @a ostream to append to.
+   */
+  static void appendHex(unsigned char value, ostream* output);
+
+  /**
+   * Append the content of a JSON string (without the surrounding quotes) with double quote, backslash, and control
+   * characters escaped.
+   * @param value the value to append.
+   * @param output the @a ostream to append to.
+   */
+  static void appendJsonString(const string& value, ostream* output);
+
+
+ private:
+  /**
+   * The @a streambuf appending to a @a string.
+   */
+  class StringBuffer : public streambuf {
+    friend class OutputBuffer;
+   protected:
+    // @copydoc
+    int_type overflow(int_type ch) override;
+
+    // @copydoc
+    streamsize xsputn(const char* str, streamsize count) override;
+
+    // @copydoc
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+
+   private:
+    /** the buffered content. */
+    string m_data;
+  };
+
+  /** the @a StringBuffer used as @a streambuf. */
+  StringBuffer m_buffer;
+};
+
+}  // namespace ebusd
+
+#endif  // LIB_EBUS_OUTPUTBUFFER_H_
@@ -99,10 +99,72 @@ int parseSignedInt(const char* str, int base, int minValue, int maxValue,
 }
 
 
+/**
+ * The CRC tables for adding several symbols at once built from the @a CRC_LOOKUP_TABLE.
+ * As the CRC is linear, adding the symbols a,b,c,d to the CRC x results in
+ * T4[x]^T3[a]^T2[b]^T1[c]^d with Tn being the @a CRC_LOOKUP_TABLE applied n times.
+ */
+class CrcTables {
+ public:
+  /**
+   * Constructor.
+   */
+  CrcTables() {
+    for (unsigned int value = 0; value < 256; value++) {
+      symbol_t crc = static_cast<symbol_t>(value);
+      for (unsigned int stride = 0; stride < 4; stride++) {
+        crc = CRC_LOOKUP_TABLE[crc];
+        m_table[stride][value] = crc;
+      }
+      m_escaped[value] = value == ESC || value == SYN;
+      m_escapedAdd[value] = m_escaped[value] ? CRC_LOOKUP_TABLE[ESC]^(value == ESC ? 0x00 : 0x01) : 0;
+    }
+  }
+
+  /** the @a CRC_LOOKUP_TABLE applied 1 to 4 times. */
+  symbol_t m_table[4][256];
+
+  /** whether the symbol needs to be escaped. */
+  bool m_escaped[256];
+
+  /** the value to add to the twice looked up CRC for an escaped symbol. */
+  symbol_t m_escapedAdd[256];
+};
+
+/**
+ * Get the @a CrcTables.
+ * @return the @a CrcTables.
+ */
+static const CrcTables& getCrcTables() {
+  static const CrcTables tables;
+  return tables;
+}
+
 void SymbolString::updateCrc(symbol_t value, symbol_t* crc) {
   *crc = CRC_LOOKUP_TABLE[*crc]^value;
 }
 
+symbol_t SymbolString::updateCrc(const symbol_t* data, size_t length, bool escape, symbol_t crc) {
+  const CrcTables& tables = getCrcTables();
+  const symbol_t* end = data + length;
+  while (data < end) {
+    if (end - data >= 4 && !(escape && (tables.m_escaped[data[0]] || tables.m_escaped[data[1]]
+        || tables.m_escaped[data[2]] || tables.m_escaped[data[3]]))) {
+      crc = tables.m_table[3][crc]^tables.m_table[2][data[0]]^tables.m_table[1][data[1]]
+          ^tables.m_table[0][data[2]]^data[3];
+      data += 4;
+      continue;
+    }
+    symbol_t value = *data++;
+    if (escape && tables.m_escaped[value]) {
+      crc = tables.m_table[1][crc]^tables.m_escapedAdd[value];  // ESC followed by 0x00 or 0x01
+    } else {
+      crc = CRC_LOOKUP_TABLE[crc]^value;
+    }
+  }
+  return crc;
+}
+
 result_t SymbolString::parseHex(const string& str) {
   result_t result;
   for (size_t i = 0; i < str.size(); i += 2) {
@@ -110,7 +172,7 @@ result_t SymbolString::parseHex(const string& str) {
     if (result != RESULT_OK) {
       return result;
     }
-    m_data.push_back(value);
+    push_back(value);
   }
   return RESULT_OK;
 }
@@ -125,10 +187,10 @@ result_t SymbolString::parseHexEscaped(const string& str) {
     }
     if (inEscape) {
       if (value == 0x00) {
-        m_data.push_back(ESC);
+        push_back(ESC);
         inEscape = false;
       } else if (value == 0x01) {
-        m_data.push_back(SYN);
+        push_back(SYN);
         inEscape = false;
       } else {
         return RESULT_ERR_ESC;  // invalid escape sequence
@@ -138,15 +200,44 @@ result_t SymbolString::parseHexEscaped(const string& str) {
     } else if (value == SYN) {
       return RESULT_ERR_ESC;  // invalid escape sequence
     } else {
-      m_data.push_back(value);
+      push_back(value);
     }
   }
   return inEscape ? RESULT_ERR_ESC : RESULT_OK;
 }
 
+void SymbolString::assign(const SymbolString& other) {
+  if (other.m_size > m_capacity) {
+    reserve(other.m_size);
+  }
+  if (other.m_size > 0) {
+    memcpy(m_data, other.m_data, other.m_size);
+  }
+  m_size = other.m_size;
+  m_isMaster = other.m_isMaster;
+}
+
+void SymbolString::reserve(size_t capacity) {
+  if (capacity <= m_capacity) {
+    return;
+  }
+  if (capacity < m_capacity * 2) {
+    capacity = m_capacity * 2;
+  }
+  symbol_t* data = new symbol_t[capacity];
+  if (m_size > 0) {
+    memcpy(data, m_data, m_size);
+  }
+  if (m_data != m_inline) {
+    delete[] m_data;
+  }
+  m_data = data;
+  m_capacity = capacity;
+}
+
 const string SymbolString::getStr(size_t skipFirstSymbols) const {
   ostringstream sstr;
-  for (size_t i = 0; i < m_data.size(); i++) {
+  for (size_t i = 0; i < m_size; i++) {
     if (skipFirstSymbols > 0) {
       skipFirstSymbols--;
     } else {
@@ -158,23 +249,9 @@ const string SymbolString::getStr(size_t skipFirstSymbols) const {
 }
 
 symbol_t SymbolString::calcCrc() const {
-  symbol_t crc = 0;
-  for (size_t i = 0; i < m_data.size(); i++) {
-    symbol_t value = m_data[i];
-    if (value == ESC) {
-      updateCrc(ESC, &crc);
-      updateCrc(0x00, &crc);
-    } else if (value == SYN) {
-      updateCrc(ESC, &crc);
-      updateCrc(0x01, &crc);
-    } else {
-      updateCrc(value, &crc);
-    }
-  }
-  return crc;
+  return updateCrc(m_data, m_size, true, 0);
 }
 
-
 /**
  * Return the index of the upper or lower 4 bits of a master address.
  * @param bits the upper or lower 4 bits of the address.
@@ -86,6 +86,10 @@ typedef unsigned char symbol_t;
 /** the broadcast destination address. */
 #define BROADCAST ((symbol_t)0xFE)
 
+/** the number of symbols a @a SymbolString holds without allocating memory (covers a complete command or response
+ * part with the maximum of 16 data bytes, longer strings are moved to the heap). */
+#define SYMBOL_STRING_INLINE_SIZE 32
+
 /**
  * Parse an unsigned int value.
  * @param str the string to parse.
@@ -121,9 +125,31 @@ class SymbolString {
    * Creates a new empty instance.
    * @param isMaster whether this instance if for the master part.
    */
-  explicit SymbolString(bool isMaster = false) { m_isMaster = isMaster; }
+  explicit SymbolString(bool isMaster = false)
+    : m_data(m_inline), m_size(0), m_capacity(SYMBOL_STRING_INLINE_SIZE), m_isMaster(isMaster) {}
 
  public:
+  /**
+   * Destructor.
+   */
+  ~SymbolString() {
+    if (m_data != m_inline) {
+      delete[] m_data;
+    }
+  }
+
+  /**
+   * Assign the symbols of another instance.
+   * @param other the @a SymbolString to copy from.
+   * @return this instance.
+   */
+  SymbolString& operator=(const SymbolString& other) {
+    if (this != &other) {
+      assign(other);
+    }
+    return *this;
+  }
+
   /**
    * Update the CRC by adding a value.
    * @param value the escaped value to add to the current CRC.
@@ -131,6 +157,17 @@ class SymbolString {
    */
   static void updateCrc(symbol_t value, symbol_t* crc);
 
+  /**
+   * Update the CRC by adding a sequence of values.
+   * @param data the values to add to the current CRC.
+   * @param length the number of values to add.
+   * @param escape true when the values are unescaped and the #ESC and #SYN symbols shall be added in escaped form,
+   * false when the values are already escaped (e.g. as received from the bus).
+   * @param crc the current CRC.
+   * @return the updated CRC.
+   */
+  static symbol_t updateCrc(const symbol_t* data, size_t length, bool escape, symbol_t crc);
+
   /**
    * Return whether this instance if for the master part.
    * @return whether this instance if for the master part.
@@ -164,8 +201,8 @@ class SymbolString {
    * @return the reference to the symbol at the specified index.
    */
   symbol_t& operator[](const size_t index) {
-    if (index >= m_data.size()) {
-      m_data.resize(index+1, 0);
+    if (index >= m_size) {
+      resize(index+1);
     }
     return m_data[index];
   }
@@ -176,7 +213,7 @@ class SymbolString {
    * @return the reference to the symbol at the specified index, or SYN if not available.
    */
   symbol_t operator[](size_t index) const {
-    if (index >= m_data.size()) {
+    if (index >= m_size) {
       return SYN;
     }
     return m_data[index];
@@ -188,7 +225,7 @@ class SymbolString {
    * @return true if this instance is equal to the other instance.
    */
   bool operator == (const SymbolString& other) {
-    return m_isMaster == other.m_isMaster && m_data == other.m_data;
+    return m_isMaster == other.m_isMaster && m_size == other.m_size && memcmp(m_data, other.m_data, m_size) == 0;
   }
 
   /**
@@ -197,7 +234,7 @@ class SymbolString {
    * @return true if this instance is different from the other instance.
    */
   bool operator != (const SymbolString& other) {
-    return m_isMaster != other.m_isMaster || m_data != other.m_data;
+    return !(*this == other);
   }
 
   /**
@@ -208,35 +245,37 @@ class SymbolString {
    * 2 if both instances are a master part and the data only differs in the first byte (the master address).
    */
   int compareTo(const SymbolString& other) const {
-    if (m_data.size() != other.m_data.size() || m_isMaster != other.m_isMaster) {
+    if (m_size != other.m_size || m_isMaster != other.m_isMaster) {
       return 1;
     }
-    if (m_data == other.m_data) {
+    if (m_size == 0) {
       return 0;
     }
-    if (!m_isMaster) {
+    if (memcmp(m_data+1, other.m_data+1, m_size-1) != 0) {
       return 1;
     }
-    if (m_data.size() == 1) {
-      return 2;
-    }
-    if (equal(m_data.begin()+1, m_data.end(), other.m_data.begin()+1)) {
-      return 2;
+    if (m_data[0] == other.m_data[0]) {
+      return 0;
     }
-    return 1;
+    return m_isMaster ? 2 : 1;
   }
 
   /**
    * Append a symbol to the end of the symbol string.
    * @param value the symbol to append.
    */
-  void push_back(symbol_t value) { m_data.push_back(value); }
+  void push_back(symbol_t value) {
+    if (m_size >= m_capacity) {
+      reserve(m_size+1);
+    }
+    m_data[m_size++] = value;
+  }
 
   /**
    * Return the number of symbols in this symbol string.
    * @return the number of available symbols.
    */
-  size_t size() const { return m_data.size(); }
+  size_t size() const { return m_size; }
 
   /**
    * Adjust the header NN field to the number of data bytes DD.
@@ -244,12 +283,12 @@ class SymbolString {
    */
   bool adjustHeader() {
     size_t lengthOffset = (m_isMaster ? 4 : 0);
-    if (m_data.size() <= lengthOffset) {
-      m_data.resize(lengthOffset+1);
-    } else if (m_data.size() >= lengthOffset+255) {
+    if (m_size <= lengthOffset) {
+      resize(lengthOffset+1);
+    } else if (m_size >= lengthOffset+255) {
       return false;
     }
-    m_data[lengthOffset] = (symbol_t)(m_data.size() - lengthOffset - 1);
+    m_data[lengthOffset] = (symbol_t)(m_size - lengthOffset - 1);
     return true;
   }
 
@@ -265,11 +304,11 @@ class SymbolString {
    */
   size_t getDataSize() const {
     size_t lengthOffset = (m_isMaster ? 4 : 0);
-    if (m_data.size() <= lengthOffset) {
+    if (m_size <= lengthOffset) {
       return 0;
     }
     size_t ret = m_data[lengthOffset];
-    return m_data.size() < lengthOffset + 1 + ret ? m_data.size() - lengthOffset - 1 : ret;
+    return m_size < lengthOffset + 1 + ret ? m_size - lengthOffset - 1 : ret;
   }
 
   /**
@@ -278,10 +317,10 @@ class SymbolString {
    */
   size_t getCalculatedDataSize() const {
     size_t lengthOffset = (m_isMaster ? 4 : 0);
-    if (m_data.size() <= lengthOffset) {
+    if (m_size <= lengthOffset) {
       return 0;
     }
-    return m_data.size() - lengthOffset - 1;
+    return m_size - lengthOffset - 1;
   }
 
   /**
@@ -291,7 +330,7 @@ class SymbolString {
    */
   symbol_t dataAt(size_t index) const {
     size_t offset = (m_isMaster ? 5 : 1) + index;
-    if (offset < m_data.size()) {
+    if (offset < m_size) {
       return m_data[offset];
     }
     return 0;
@@ -304,8 +343,8 @@ class SymbolString {
    */
   symbol_t& dataAt(size_t index) {
     size_t offset = (m_isMaster ? 5 : 1) + index;
-    if (offset >= m_data.size()) {
-      m_data.resize(offset+1, 0);
+    if (offset >= m_size) {
+      resize(offset+1);
     }
     return m_data[offset];
   }
@@ -316,10 +355,10 @@ class SymbolString {
    */
   bool isComplete() {
     size_t lengthOffset = (m_isMaster ? 4 : 0);
-    if (m_data.size() < lengthOffset + 1) {
+    if (m_size < lengthOffset + 1) {
       return false;
     }
-    return m_data.size() >= lengthOffset + 1 + m_data[lengthOffset];
+    return m_size >= lengthOffset + 1 + m_data[lengthOffset];
   }
 
   /**
@@ -331,7 +370,7 @@ class SymbolString {
   /**
    * Clear the symbols.
    */
-  void clear() { m_data.clear(); }
+  void clear() { m_size = 0; }
 
 
  private:
@@ -340,10 +379,47 @@ class SymbolString {
    * @param str the @a SymbolString to copy from.
    */
   SymbolString(const SymbolString& str)
-    : m_data(str.m_data), m_isMaster(str.m_isMaster) {}
+    : m_data(m_inline), m_size(0), m_capacity(SYMBOL_STRING_INLINE_SIZE), m_isMaster(str.m_isMaster) {
+    assign(str);
+  }
+
+  /**
+   * Copy the symbols and the part of another instance.
+   * @param other the @a SymbolString to copy from.
+   */
+  void assign(const SymbolString& other);
+
+  /**
+   * Ensure the capacity for the specified number of symbols.
+   * @param capacity the minimum number of symbols to hold.
+   */
+  void reserve(size_t capacity);
+
+  /**
+   * Change the number of symbols, filling new symbols with zero.
+   * @param size the new number of symbols.
+   */
+  void resize(size_t size) {
+    if (size > m_capacity) {
+      reserve(size);
+    }
+    if (size > m_size) {
+      memset(m_data+m_size, 0, size-m_size);
+    }
+    m_size = size;
+  }
+
+  /** the inline storage for the symbols. */
+  symbol_t m_inline[SYMBOL_STRING_INLINE_SIZE];
+
+  /** the string of unescaped symbols (either @a m_inline or allocated on the heap). */
+  symbol_t* m_data;
+
+  /** the number of symbols in @a m_data. */
+  size_t m_size;
 
-  /** the string of unescaped symbols. */
-  vector<symbol_t> m_data;
+  /** the capacity of @a m_data. */
+  size_t m_capacity;
 
   /** whether this instance is for the master part. */
   bool m_isMaster;
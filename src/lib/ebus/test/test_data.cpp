@@ -21,10 +21,13 @@
 #include <string>
 #include <vector>
 #include "lib/ebus/data.h"
+#include "lib/ebus/outputbuffer.h"
 
 using namespace ebusd;
 using std::cout;
 using std::endl;
+using std::hex;
+using std::setw;
 
 static bool error = false;
 
@@ -703,5 +706,20 @@ int main() {
 
   delete templates;
 
+  OutputBuffer buffer;
+  buffer << setw(4) << hex << 10;
+  OutputBuffer::append(',', &buffer);
+  OutputBuffer::appendInt(-123, &buffer);
+  OutputBuffer::append(",", 1, &buffer);
+  OutputBuffer::appendFixed(-0.5, 3, &buffer);
+  OutputBuffer::append(',', &buffer);
+  OutputBuffer::appendHex(0xa5, &buffer);
+  OutputBuffer::append(',', &buffer);
+  OutputBuffer::appendJsonString("a\"b\\c\n", &buffer);
+  verify(false, "output", "buffer", true, "   a,-123,-0.500,a5,a\\\"b\\\\c\\u000a", buffer.str());
+  buffer.reset();
+  buffer << 10;
+  verify(false, "output", "reset", buffer.tellp() == 2, "10", buffer.str());
+
   return error ? 1 : 0;
 }
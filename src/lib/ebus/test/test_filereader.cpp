@@ -16,6 +16,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <string>
@@ -79,6 +81,20 @@ class NoopReader : public FileReader {
   }
 };
 
+class CollectReader : public FileReader {
+ public:
+  result_t addFromFile(const string& filename, unsigned int lineNo, vector<string>* row, string* errorDescription,
+    bool replace) override {
+    m_collected << lineNo << ":";
+    for (const auto& field : *row) {
+      m_collected << field << "|";
+    }
+    m_collected << endl;
+    return RESULT_OK;
+  }
+  ostringstream m_collected;
+};
+
 class TestReader : public MappedFileReader {
  public:
   TestReader(size_t expectedCols, size_t langCols)
@@ -290,5 +306,123 @@ int main(int argc, char** argv) {
     error = true;
   }
 
+  // record the rows into the cache, save and load it again, then add the cached rows without the stream
+  const string cacheFile = "test_filereader_cache.bin";
+  remove(cacheFile.c_str());
+  FileRowsCache cache(cacheFile);
+  CollectReader recordReader, replayReader;
+  ifs.clear();
+  ifs.seekg(0);
+  recordReader.setCachedRows(cache.prepare("test.csv", 1234, ifs.str().size()));
+  result_t result = recordReader.readFromStream(&ifs, "test.csv", 0, false, nullptr, &errorDescription, false, &hash,
+      &size);
+  cache.commit("test.csv");
+  FileRowsCache loaded(cacheFile);
+  size_t cachedHash = 0, cachedSize = 0;
+  CachedFileRows* rows = nullptr;
+  if (result == RESULT_OK && cache.save() && loaded.load()) {
+    rows = loaded.get("test.csv", 1234, ifs.str().size());
+  }
+  if (rows && !loaded.get("test.csv", 1235, ifs.str().size()) && !loaded.get("test.csv", 1234, 1)) {
+    replayReader.setCachedRows(rows);
+    result = replayReader.readFromStream(nullptr, "test.csv", 0, false, nullptr, &errorDescription, false,
+        &cachedHash, &cachedSize);
+  } else {
+    result = RESULT_ERR_NOTFOUND;
+  }
+  remove(cacheFile.c_str());
+  if (result == RESULT_OK && cachedHash == hash && cachedSize == size && !recordReader.m_collected.str().empty()
+      && replayReader.m_collected.str() == recordReader.m_collected.str()) {
+    cout << "cached rows OK" << endl;
+  } else {
+    cout << "cached rows error: " << getResultCode(result) << ", got >" << replayReader.m_collected.str()
+        << "<, expected >" << recordReader.m_collected.str() << "<" << endl;
+    error = true;
+  }
+
+  // files that were not used since loading the cache are dropped when saving it
+  FileRowsCache pruning(cacheFile);
+  pruning.prepare("kept.csv", 1, 1)->m_complete = true;
+  pruning.commit("kept.csv");
+  pruning.prepare("dropped.csv", 2, 2)->m_complete = true;
+  pruning.commit("dropped.csv");
+  FileRowsCache pruned(cacheFile);
+  bool pruneOk = pruning.save() && pruned.load() && pruned.size() == 2 && pruned.get("kept.csv", 1, 1)
+    && pruned.save() && pruning.load() && pruning.size() == 1 && pruning.get("kept.csv", 1, 1)
+    && !pruning.get("dropped.csv", 2, 2);
+  remove(cacheFile.c_str());
+  if (pruneOk) {
+    cout << "pruned cache OK" << endl;
+  } else {
+    cout << "pruned cache error" << endl;
+    error = true;
+  }
+
+  // split the same content from a stream, from a buffer and from a file read at once
+  ostringstream content;
+  content << "\n"
+      << "# comment\r\n"
+      << "   \n"
+      << "\t\"quoted\",x ,\" \" , \"multi\n"
+      << "line\";\"part\" \r\n"
+      << "// comment\n"
+      << ",,\n";
+  for (int line = 0; line < 2000; line++) {
+    content << "r,circuit" << line << ",name" << line << ",\"comment, with \"\"quotes\"\"\",,08,b509,0d" << line
+        << ",,,D2C,,°C,temperature  ,,,UCH,0=off;1=on;2=auto,,mode\n";
+  }
+  content << "last,line";
+  const string contentStr = content.str();
+  const string contentFile = "test_filereader_split.csv";
+  ofstream contentOut(contentFile.c_str(), ofstream::out | ofstream::binary | ofstream::trunc);
+  contentOut << contentStr;
+  contentOut.close();
+  size_t streamHash = 0, streamSize = 0, bufferHash = 0, bufferSize = 0, fileHash = 0, fileSize = 0;
+  CollectReader streamReader, bufferReader, fileReader;
+  istringstream contentStream(contentStr);
+  result_t streamResult = streamReader.readFromStream(&contentStream, "split", 0, false, nullptr, &errorDescription,
+      false, &streamHash, &streamSize);
+  BufferStream contentBuffer(contentStr.data(), contentStr.size());
+  result_t bufferResult = bufferReader.readFromStream(&contentBuffer, "split", 0, false, nullptr, &errorDescription,
+      false, &bufferHash, &bufferSize);
+  result_t fileResult = RESULT_ERR_NOTFOUND;
+  const int rounds = 20;
+  NoopReader benchReader;
+  auto start = chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    istringstream stream(contentStr);
+    benchReader.readFromStream(&stream, "split", 0, false, nullptr, &errorDescription, false, &hash, &size);
+  }
+  auto stop = chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    BufferStream stream(contentStr.data(), contentStr.size());
+    benchReader.readFromStream(&stream, "split", 0, false, nullptr, &errorDescription, false, &hash, &size);
+  }
+  auto stopBuffer = chrono::steady_clock::now();
+  istream* fileStream = FileReader::openFile(contentFile, &errorDescription);
+  // truncating the file after opening it must neither crash nor change the opened content
+  contentOut.open(contentFile.c_str(), ofstream::out | ofstream::binary | ofstream::trunc);
+  contentOut.close();
+  if (fileStream && dynamic_cast<BufferStream*>(fileStream)) {
+    fileResult = fileReader.readFromStream(fileStream, "split", 0, false, nullptr, &errorDescription, false,
+        &fileHash, &fileSize);
+  }
+  delete fileStream;
+  remove(contentFile.c_str());
+  const string expect = streamReader.m_collected.str();
+  if (streamResult == RESULT_OK && bufferResult == RESULT_OK && fileResult == RESULT_OK
+      && bufferReader.m_collected.str() == expect && fileReader.m_collected.str() == expect
+      && bufferHash == streamHash && fileHash == streamHash && bufferSize == streamSize && fileSize == streamSize
+      && bufferSize == contentStr.size()) {
+    cout << "split buffer OK: " << fixed << setprecision(2)
+        << chrono::duration<double, milli>(stop - start).count()/rounds << " ms with stream, "
+        << chrono::duration<double, milli>(stopBuffer - stop).count()/rounds << " ms with buffer" << endl;
+  } else {
+    cout << "split buffer error: " << getResultCode(streamResult) << "/" << getResultCode(bufferResult) << "/"
+        << getResultCode(fileResult) << ", got >" << bufferReader.m_collected.str().substr(0, 200) << "<, expected >"
+        << expect.substr(0, 200) << "<" << endl;
+    error = true;
+  }
+
   return error ? 1 : 0;
 }
@@ -52,6 +52,93 @@ void verify(bool expectFailMatch, string type, string input,
 
 DataFieldTemplates* templates = nullptr;
 
+/**
+ * A @a MessageUpdateListener counting the notifications.
+ */
+class CountingListener : public MessageUpdateListener {
+ public:
+  CountingListener() : m_updates(0), m_changes(0) {}
+
+  // @copydoc
+  void notifyMessageUpdate(bool changed) override {
+    m_updates++;
+    if (changed) {
+      m_changes++;
+    }
+  }
+
+  /** the number of notified updates. */
+  int m_updates;
+
+  /** the number of notified changes. */
+  int m_changes;
+};
+
+/**
+ * Find the @a Message for the master data the way it was done before the dispatch table, i.e. by trying the keys of
+ * each ID length from longest to shortest with specific source, any source, active read, and active write.
+ * @param messages the @a MessageMap to search.
+ * @param master the @a MasterSymbolString to find the @a Message for.
+ * @param anyDestination true to only return messages without a particular destination.
+ * @param withRead true to include read messages.
+ * @param withWrite true to include write messages.
+ * @param withPassive true to include passive messages.
+ * @return the @a Message instance, or nullptr.
+ */
+Message* findByKeyScan(const MessageMap* messages, const MasterSymbolString& master, bool anyDestination,
+    bool withRead, bool withWrite, bool withPassive) {
+  const uint64_t sourceMask = 0x1fLL << (8 * 7);
+  const uint64_t activeRead = 0x1eLL << (8 * 7);
+  const uint64_t activeWrite = 0x1fLL << (8 * 7);
+  size_t maxIdLength = master.getDataSize() > 7 ? 7 : master.getDataSize();
+  for (size_t idLength = maxIdLength; true; idLength--) {
+    uint64_t key = Message::createKey(master, idLength, anyDestination);
+    vector<uint64_t> keys;
+    if (withPassive) {
+      keys.push_back(key);
+      if ((key & sourceMask) != 0) {
+        keys.push_back(key & ~sourceMask);
+      }
+    }
+    if (withRead) {
+      keys.push_back((key & ~sourceMask) | activeRead);
+    }
+    if (withWrite) {
+      keys.push_back((key & ~sourceMask) | activeWrite);
+    }
+    for (const auto check : keys) {
+      const vector<Message*>* found = messages->getByKey(check);
+      if (!found) {
+        continue;
+      }
+      for (const auto message : *found) {
+        if (message->checkId(master, nullptr) && message->isAvailable()) {
+          return message;
+        }
+      }
+    }
+    if (idLength == 0) {
+      break;
+    }
+  }
+  return nullptr;
+}
+
+/** the content of the files split in parallel. */
+static const char* splitContents[] = {
+  "r,cir,first,,,15,b509,0d3000,temp,,D2C,,°C,,mode,,UCH,0=off;1=on\n"
+  "w,cir,first,,,15,b509,0d3000,temp,,D2C,,°C\n",
+  "*[mode],cir,first,,mode,,1\n"
+  "r,other,second,,,08,b509,0d3100,,,UCH\n"
+  "[mode]r,other,third,,,08,b509,0d3200,value,,UIN,10\n",
+  "*r,prefix,,,,25,b509,0d\n"
+  "r,,fourth,,,,,3300,,,STR:3\n"
+  "u,prefix,fifth,,,25,b509,0d3400,,,HEX:2\n",
+};
+
+/** the number of files split in parallel. */
+#define SPLIT_FILES (sizeof(splitContents) / sizeof(splitContents[0]))
+
 namespace ebusd {
 
 DataFieldTemplates* getTemplates(const string& filename) {
@@ -482,6 +569,463 @@ int main() {
     }
   }
 
+  MessageKeyMap keyMap;
+  for (uint64_t key = 0; key < 1000; key++) {
+    keyMap[(key << 40) | key].push_back(nullptr);
+  }
+  for (uint64_t key = 0; key < 1000; key += 2) {
+    keyMap.erase((key << 40) | key);
+  }
+  bool keyMapOk = keyMap.size() == 500;
+  for (uint64_t key = 0; keyMapOk && key < 1000; key++) {
+    const vector<Message*>* found = keyMap.find((key << 40) | key);
+    keyMapOk = (key % 2 == 0) ? found == nullptr : (found != nullptr && found->size() == 1);
+  }
+  if (keyMapOk) {
+    cout << "key map OK" << endl;
+  } else {
+    cout << "key map error" << endl;
+    error = true;
+  }
+
+  messages->clear();
+  istringstream journalDef("r,cir,nam,,,15,b509,0d2800,,,UCH");
+  result_t journalResult = messages->readLineFromStream(&journalDef, __FILE__, false, &lineNo, &row,
+      &errorDescription, false, nullptr, nullptr);
+  MasterSymbolString journalMaster;
+  SlaveSymbolString journalSlave;
+  journalMaster.parseHex("ff15b509030d2800");
+  journalSlave.parseHex("0105");
+  uint64_t updateSequence = messages->getUpdateSequence(), changeSequence = updateSequence;
+  deque<Message*> updated, changed;
+  CountingListener listener;
+  messages->addUpdateListener(&listener);
+  bool journalOk = journalResult == RESULT_OK && (message = messages->find(journalMaster)) != nullptr;
+  if (journalOk) {
+    message->storeLastData(journalMaster, journalSlave);
+    message->storeLastData(journalMaster, journalSlave);
+    journalOk = messages->findUpdates("*", false, &updateSequence, &updated) && updated.size() == 1
+      && messages->findUpdates("*", true, &changeSequence, &changed) && changed.size() == 1;
+  }
+  if (journalOk) {
+    updated.clear();
+    changed.clear();
+    message->storeLastData(journalMaster, journalSlave);
+    journalOk = messages->findUpdates("*", false, &updateSequence, &updated) && updated.size() == 1
+      && messages->findUpdates("*", true, &changeSequence, &changed) && changed.empty();
+  }
+  messages->removeUpdateListener(&listener);
+  if (journalOk) {
+    // the first store changed the data, the following ones only updated it
+    int updates = listener.m_updates, changes = listener.m_changes;
+    message->storeLastData(journalMaster, journalSlave);
+    journalOk = changes > 0 && updates >= changes + 2 && listener.m_updates == updates
+      && listener.m_changes == changes;
+  }
+  if (journalOk) {
+    cout << "journal OK" << endl;
+  } else {
+    cout << "journal error" << endl;
+    error = true;
+  }
+
+  const vector<Message*>* candidates = journalOk ? messages->findCandidates(message->getCircuit(),
+      message->getName(), false) : nullptr;
+  bool candidatesOk = candidates != nullptr && candidates->size() == 1
+    && MessageMap::findAvailable(candidates, "*") == message
+    && messages->findCandidates(message->getCircuit(), message->getName(), true) == nullptr
+    && MessageMap::findAvailable(nullptr, "*") == nullptr;
+  if (candidatesOk) {
+    cout << "find candidates OK" << endl;
+  } else {
+    cout << "find candidates error" << endl;
+    error = true;
+  }
+
+  bool cacheOk = journalOk;
+  if (cacheOk) {
+    ostringstream first, second, third;
+    cacheOk = message->decodeLastData(false, nullptr, -1, 0, &first) == RESULT_OK
+      && message->decodeLastData(false, nullptr, -1, 0, &second) == RESULT_OK
+      && first.str() == "5" && second.str() == "5";
+    SlaveSymbolString changedSlave;
+    changedSlave.parseHex("0106");
+    message->storeLastData(journalMaster, changedSlave);
+    cacheOk = cacheOk && message->decodeLastData(false, nullptr, -1, 0, &third) == RESULT_OK && third.str() == "6";
+  }
+  if (cacheOk) {
+    cout << "decode cache OK" << endl;
+  } else {
+    cout << "decode cache error" << endl;
+    error = true;
+  }
+
+  istringstream valuesDef("r,cir,values,,,15,b509,0d2a00,temp,,D2C,,,,mode,,UCH,1=on;2=off,,,str,,STR:2,,,,nul,,UCH");
+  result_t valuesResult = messages->readLineFromStream(&valuesDef, __FILE__, false, &lineNo, &row,
+      &errorDescription, false, nullptr, nullptr);
+  MasterSymbolString valuesMaster;
+  SlaveSymbolString valuesSlave;
+  valuesMaster.parseHex("ff15b509030d2a00");
+  valuesSlave.parseHex("06200101414aff");
+  bool valuesOk = valuesResult == RESULT_OK && (message = messages->find(valuesMaster)) != nullptr;
+  if (valuesOk) {
+    NumericValue value;
+    unsigned int rawValue = 0;
+    valuesOk = message->getLastValue(nullptr, -1, &value) == RESULT_EMPTY;  // no data yet
+    message->storeLastData(valuesMaster, valuesSlave);
+    valuesOk = valuesOk && message->getLastValue(nullptr, -1, &value) == RESULT_OK
+      && value.m_type == nv_float && value.m_value == 18.0 && value.m_raw == 0x0120
+      && message->getLastValue("mode", -1, &value) == RESULT_OK && value.m_type == nv_enum && value.m_value == 1
+      && message->getLastValue(nullptr, 2, &value) == RESULT_EMPTY && value.m_type == nv_none
+      && message->getLastValue("nul", -1, &value) == RESULT_OK && value.m_type == nv_null && value.m_raw == 0xff
+      && message->getLastValue("unknown", -1, &value) == RESULT_ERR_NOTFOUND
+      && message->decodeLastDataNumField("mode", -1, &rawValue) == RESULT_OK && rawValue == 1;
+  }
+  if (valuesOk) {
+    cout << "numeric values OK" << endl;
+  } else {
+    cout << "numeric values error" << endl;
+    error = true;
+  }
+
+  istringstream lastFieldDef("r,cir,lastfield,,,15,b509,0d2c00,index,m,UCH,,,,first,,UCH,,,,second,,UCH");
+  result_t lastFieldResult = messages->readLineFromStream(&lastFieldDef, __FILE__, false, &lineNo, &row,
+      &errorDescription, false, nullptr, nullptr);
+  MasterSymbolString lastFieldMaster;
+  SlaveSymbolString lastFieldSlave;
+  lastFieldMaster.parseHex("ff15b509040d2c0003");
+  lastFieldSlave.parseHex("020506");
+  bool lastFieldOk = lastFieldResult == RESULT_OK && (message = messages->find(lastFieldMaster)) != nullptr;
+  if (lastFieldOk) {
+    unsigned int rawValue = 0;
+    message->storeLastData(lastFieldMaster, lastFieldSlave);
+    // without field index, the last matching field of the master data takes precedence over the slave data
+    lastFieldOk = message->decodeLastDataNumField(nullptr, -1, &rawValue) == RESULT_OK && rawValue == 3
+      && message->decodeLastDataNumField("first", -1, &rawValue) == RESULT_OK && rawValue == 5
+      && message->decodeLastDataNumField("second", -1, &rawValue) == RESULT_OK && rawValue == 6
+      && message->decodeLastDataNumField(nullptr, 1, &rawValue) == RESULT_OK && rawValue == 5
+      && message->decodeLastDataNumField("unknown", -1, &rawValue) == RESULT_ERR_NOTFOUND;
+    istringstream slaveOnlyDef("r,cir,slavefields,,,15,b509,0d2d00,first,,UCH,,,,second,,UCH");
+    MasterSymbolString slaveOnlyMaster;
+    slaveOnlyMaster.parseHex("ff15b509030d2d00");
+    lastFieldOk = lastFieldOk && messages->readLineFromStream(&slaveOnlyDef, __FILE__, false, &lineNo, &row,
+        &errorDescription, false, nullptr, nullptr) == RESULT_OK
+      && (message = messages->find(slaveOnlyMaster)) != nullptr;
+    if (lastFieldOk) {
+      message->storeLastData(slaveOnlyMaster, lastFieldSlave);
+      lastFieldOk = message->decodeLastDataNumField(nullptr, -1, &rawValue) == RESULT_OK && rawValue == 6;
+    }
+  }
+  if (lastFieldOk) {
+    cout << "last numeric field OK" << endl;
+  } else {
+    cout << "last numeric field error" << endl;
+    error = true;
+  }
+
+  // a value out of range is not decoded, but the raw value is still used for conditions
+  istringstream rangeDef("r,cir,range,,,15,b509,0d2f00,value,,D1C");
+  MasterSymbolString rangeMaster;
+  SlaveSymbolString rangeSlave;
+  rangeMaster.parseHex("ff15b509030d2f00");
+  rangeSlave.parseHex("01c9");
+  bool rangeOk = messages->readLineFromStream(&rangeDef, __FILE__, false, &lineNo, &row, &errorDescription, false,
+      nullptr, nullptr) == RESULT_OK && (message = messages->find(rangeMaster)) != nullptr;
+  if (rangeOk) {
+    NumericValue value;
+    unsigned int rawValue = 0;
+    ostringstream decoded;
+    message->storeLastData(rangeMaster, rangeSlave);
+    rangeOk = message->decodeLastData(false, nullptr, -1, 0, &decoded) == RESULT_ERR_OUT_OF_RANGE
+      && message->getLastValue("value", -1, &value) == RESULT_ERR_OUT_OF_RANGE && value.m_type == nv_raw
+      && value.m_raw == 0xc9 && message->decodeLastDataNumField("value", -1, &rawValue) == RESULT_OK
+      && rawValue == 0xc9;
+  }
+  if (rangeOk) {
+    cout << "out of range numeric field OK" << endl;
+  } else {
+    cout << "out of range numeric field error" << endl;
+    error = true;
+  }
+
+  // the data of each message in a batch is replaced by later updates of the same message
+  istringstream batchDef("r,other,single,,,15,b509,0d2e00,value,,UCH");
+  MasterSymbolString batchMaster;
+  SlaveSymbolString batchSlave;
+  batchMaster.parseHex("ff15b509030d2e00");
+  batchSlave.parseHex("0109");
+  MessageBatch batch;
+  OutputBuffer batchBuffer;
+  vector<pair<string, string>> documents;
+  batch.build(true, &batchBuffer, &documents);
+  Message* other = nullptr;
+  bool batchOk = documents.empty() && messages->readLineFromStream(&batchDef, __FILE__, false, &lineNo, &row,
+      &errorDescription, false, nullptr, nullptr) == RESULT_OK
+    && (other = messages->find(batchMaster)) != nullptr && (message = messages->find(lastFieldMaster)) != nullptr;
+  if (batchOk) {
+    other->storeLastData(batchMaster, batchSlave);
+    batchOk = batch.add(message, 0, &batchBuffer) == RESULT_OK && batch.add(other, 0, &batchBuffer) == RESULT_OK;
+    SlaveSymbolString updatedSlave;
+    updatedSlave.parseHex("020708");
+    message->storeLastData(lastFieldMaster, updatedSlave);
+    batchOk = batchOk && batch.add(message, 0, &batchBuffer) == RESULT_OK;
+  }
+  if (batchOk) {
+    batch.build(true, &batchBuffer, &documents);
+    batchOk = batch.empty() && documents.size() == 2
+      && documents[0].first == "circircuit"
+      && documents[0].second == "{\"sequence\": 1, \"messages\": {\"nalastfieldme\": {\n"
+         "     \"index\": {\"value\": 3},\n     \"first\": {\"value\": 7},\n     \"second\": {\"value\": 8}}}}"
+      && documents[1].first == "cirothercuit"
+      && documents[1].second == "{\"sequence\": 1, \"messages\": {\"nasingleme\": {\n"
+         "     \"value\": {\"value\": 9}}}}";
+  }
+  if (batchOk) {
+    documents.clear();
+    batchOk = batch.add(other, 0, &batchBuffer) == RESULT_OK;
+    batch.build(false, &batchBuffer, &documents);
+    batchOk = batchOk && documents.size() == 1 && documents[0].first.empty()
+      && documents[0].second == "{\"sequence\": 2, \"cirothercuit\": {\"messages\": {\"nasingleme\": {\n"
+         "     \"value\": {\"value\": 9}}}}}";
+  }
+  if (batchOk) {
+    cout << "batch OK" << endl;
+  } else {
+    cout << "batch error" << endl;
+    error = true;
+  }
+
+  // updates of the same topic are combined into the latest data and taken once due
+  PublishQueue coalescing(100, 0, false);
+  vector<pair<string, string>> taken;
+  bool queueOk = !coalescing.add("a", "1", 1000) && !coalescing.add("b", "2", 1010)
+    && !coalescing.add("a", "3", 1050) && coalescing.take(1050, &taken) == 50 && taken.empty()
+    && coalescing.take(1100, &taken) == 10 && taken.size() == 1 && taken[0].first == "a" && taken[0].second == "3"
+    && coalescing.take(1110, &taken) == -1 && taken.size() == 2 && taken[1].first == "b" && taken[1].second == "2";
+  if (queueOk) {
+    cout << "publish queue coalescing OK" << endl;
+  } else {
+    cout << "publish queue coalescing error" << endl;
+    error = true;
+  }
+
+  // updates exceeding the rate limit are deferred to the next second
+  PublishQueue limited(0, 2, false);
+  taken.clear();
+  queueOk = !limited.add("a", "1", 5000) && !limited.add("b", "2", 5000) && !limited.add("c", "3", 5000)
+    && limited.take(5000, &taken) == 1000 && taken.size() == 2 && taken[0].first == "a" && taken[1].first == "b"
+    && limited.take(5999, &taken) == 1 && taken.size() == 2
+    && limited.take(6000, &taken) == -1 && taken.size() == 3 && taken[2].first == "c";
+  if (queueOk) {
+    cout << "publish queue rate limit OK" << endl;
+  } else {
+    cout << "publish queue rate limit error" << endl;
+    error = true;
+  }
+
+  // identical data is skipped until the taken data is forgotten, directly and when queued
+  PublishQueue direct(0, 0, true);
+  queueOk = direct.add("a", "1", 0) && !direct.add("a", "1", 0) && direct.add("b", "1", 0)
+    && direct.add("a", "2", 0) && !direct.add("a", "2", 0);
+  direct.clearTaken();
+  queueOk = queueOk && direct.add("a", "2", 0) && !direct.add("a", "2", 0);
+  PublishQueue deduplicating(10, 0, true);
+  taken.clear();
+  queueOk = queueOk && !deduplicating.add("a", "1", 0) && deduplicating.take(10, &taken) == -1 && taken.size() == 1
+    && !deduplicating.add("a", "1", 20) && deduplicating.take(30, &taken) == -1 && taken.size() == 1;
+  deduplicating.clearTaken();
+  queueOk = queueOk && !deduplicating.add("a", "1", 40) && deduplicating.take(50, &taken) == -1 && taken.size() == 2
+    && taken[1].first == "a" && taken[1].second == "1";
+  if (queueOk) {
+    cout << "publish queue dedup OK" << endl;
+  } else {
+    cout << "publish queue dedup error" << endl;
+    error = true;
+  }
+
+  MessageMap* conditional = new MessageMap(false, "", false);
+  istringstream conditionalDef("#\nr,cir,mode,,,15,b509,0d2a00,mode,,UCH\n*[on],cir,mode,,mode,,1\n"
+      "[on]r,cir,dependent,,,15,b509,0d2b00,,,UCH");
+  result_t conditionalResult = RESULT_OK;
+  lineNo = 0;
+  row.clear();
+  while (conditionalResult == RESULT_OK && !conditionalDef.eof()) {
+    conditionalResult = conditional->readLineFromStream(&conditionalDef, __FILE__, false, &lineNo, &row,
+        &errorDescription, false, nullptr, nullptr);
+  }
+  if (conditionalResult == RESULT_OK) {
+    conditionalResult = conditional->resolveConditions(false, &errorDescription);
+  }
+  MasterSymbolString dependentMaster;
+  dependentMaster.parseHex("ff15b509030d2b00");
+  Message* modeMessage = conditional->find(valuesMaster);
+  Message* dependent = conditional->find(dependentMaster, false, true, true, true, false);
+  bool conditionOk = conditionalResult == RESULT_OK && modeMessage != nullptr && dependent != nullptr
+    && dependent->isConditional();
+  if (conditionOk) {
+    SlaveSymbolString onSlave, offSlave;
+    onSlave.parseHex("0101");
+    offSlave.parseHex("0102");
+    conditionOk = !dependent->isAvailable();  // before the dependency update
+    modeMessage->storeLastData(valuesMaster, onSlave);
+    conditionOk = conditionOk && dependent->isAvailable();  // after the dependency update
+    modeMessage->storeLastData(valuesMaster, offSlave);  // changed within the same second
+    conditionOk = conditionOk && !dependent->isAvailable();
+    modeMessage->storeLastData(valuesMaster, onSlave);
+    conditionOk = conditionOk && dependent->isAvailable();
+  }
+  if (conditionOk) {
+    cout << "condition dependency OK" << endl;
+  } else {
+    cout << "condition dependency error: " << getResultCode(conditionalResult) << " " << errorDescription << endl;
+    error = true;
+  }
+  delete conditional;
+
+  MessageMap* dispatch = new MessageMap(false, "", false);
+  istringstream dispatchDef("#\nr,cir,r0,,,15,b509,,,,UCH\nr,cir,r1,,,15,b509,0d,,,UCH\n"
+      "r,cir,r2,,,15,b509,0d28,,,UCH\nw,cir,w1,,,15,b509,0d,,,UCH\nw,cir,w2,,,15,b509,0e28,,,UCH\n"
+      "u,cir,u0,,,15,b509,,,,UCH\nu,cir,u1,,,15,b509,0d,,,UCH\nu,cir,u2,,10,15,b509,0d28,,,UCH\n"
+      "u,cir,u3,,31,15,b509,0d,,,UCH\nu,cir,b0,,,fe,b516,,,,UCH\nw,cir,b1,,,fe,b516,01,,,UCH\n"
+      "u,cir,b2,,10,fe,b516,01,,,UCH\nw,cir,m1,,,10,b509,0d,,,UCH\nr,cir,a1,,,,b509,0d28,,,UCH");
+  result_t dispatchResult = RESULT_OK;
+  lineNo = 0;
+  row.clear();
+  while (dispatchResult == RESULT_OK && !dispatchDef.eof()) {
+    dispatchResult = dispatch->readLineFromStream(&dispatchDef, __FILE__, false, &lineNo, &row,
+        &errorDescription, false, nullptr, nullptr);
+  }
+  const char* dispatchMasters[] = {
+    "ff15b509030d2800", "1015b509030d2800", "3115b509030d2800", "ff15b509020d28", "1015b509010d",
+    "3115b509010d", "ff15b50900", "ff15b509030e2801", "ff15b509030e2901", "10feb5160101", "10feb5160102",
+    "31feb5160101", "10feb51600", "ff10b509020d01", "3110b509010d", "ff50b509030d2800",
+  };
+  bool dispatchOk = dispatchResult == RESULT_OK && dispatch->size() == 14;
+  size_t dispatchFound = 0;
+  for (const auto hex : dispatchMasters) {
+    MasterSymbolString master;
+    dispatchOk = dispatchOk && master.parseHex(hex) == RESULT_OK;
+    for (int flags = 0; dispatchOk && flags < 16; flags++) {
+      bool anyDestination = flags & 1, withRead = flags & 2, withWrite = flags & 4, withPassive = flags & 8;
+      Message* expected = findByKeyScan(dispatch, master, anyDestination, withRead, withWrite, withPassive);
+      Message* found = dispatch->find(master, anyDestination, withRead, withWrite, withPassive);
+      if (found != expected) {
+        cout << "  dispatch " << hex << " flags " << flags << ": got "
+             << (found ? found->getName() : "none") << ", expected " << (expected ? expected->getName() : "none")
+             << endl;
+        dispatchOk = false;
+      }
+      if (found) {
+        dispatchFound++;
+      }
+    }
+  }
+  if (dispatchOk && dispatchFound > 0) {
+    cout << "dispatch order OK" << endl;
+  } else {
+    cout << "dispatch order error: " << getResultCode(dispatchResult) << " " << errorDescription << endl;
+    error = true;
+  }
+  delete dispatch;
+
+  MessageMap* current = new MessageMap(false, "", false);
+  MessageMap* reloaded = new MessageMap(false, "", false);
+  istringstream currentDef("#\nr,cir,nam,,,15,b509,0d2800,,,UCH\nr,cir,nam2,,,15,b509,0d2900,,,UCH");
+  istringstream reloadDef("#\nr,cir,nam,,,15,b509,0d2800,,,UCH\nr,cir,nam2,,,15,b509,0d2900,,,SCH");
+  result_t swapResult = RESULT_OK;
+  lineNo = 0;
+  row.clear();
+  while (swapResult == RESULT_OK && !currentDef.eof()) {
+    swapResult = current->readLineFromStream(&currentDef, __FILE__, false, &lineNo, &row,
+        &errorDescription, false, nullptr, nullptr);
+  }
+  lineNo = 0;
+  row.clear();
+  while (swapResult == RESULT_OK && !reloadDef.eof()) {
+    swapResult = reloaded->readLineFromStream(&reloadDef, __FILE__, false, &lineNo, &row,
+        &errorDescription, false, nullptr, nullptr);
+  }
+  MasterSymbolString swapMaster;
+  swapMaster.parseHex("ff15b509030d2900");
+  Message* unchanged = current->find(journalMaster);
+  Message* changedDef = current->find(swapMaster);
+  bool swapOk = swapResult == RESULT_OK && unchanged != nullptr && changedDef != nullptr;
+  if (swapOk) {
+    unchanged->storeLastData(journalMaster, journalSlave);
+    changedDef->storeLastData(swapMaster, journalSlave);
+    updateSequence = current->getUpdateSequence();
+    uint64_t definitionVersion = current->getDefinitionVersion();
+    Message* reloadedScan = reloaded->getScanMessage();
+    uint64_t hold = current->holdDefinitions();
+    current->swapDefinitions(reloaded);
+    reloaded = nullptr;
+    swapOk = current->getDefinitionVersion() != definitionVersion && current->getScanMessage() == reloadedScan
+      && current->freeRetiredDefinitions() == 1 && unchanged->getLastUpdateTime() != 0;
+    current->releaseDefinitions(hold);
+    swapOk = swapOk && current->freeRetiredDefinitions() == 0;
+    message = current->find(journalMaster);
+    swapOk = swapOk && message != nullptr && message != unchanged && message->getLastUpdateTime() != 0
+      && journalSlave == message->getLastSlaveData();
+    message = current->find(swapMaster);
+    updated.clear();
+    swapOk = swapOk && message != nullptr && message != changedDef && message->getLastUpdateTime() == 0
+      && !current->findUpdates("*", false, &updateSequence, &updated);
+  }
+  if (swapOk) {
+    cout << "swap definitions OK" << endl;
+  } else {
+    cout << "swap definitions error" << endl;
+    error = true;
+  }
+  if (reloaded) {
+    delete reloaded;
+  }
+  delete current;
+
+  // split the files in parallel, then add the rows in order and compare with adding them serially
+  MessageMap* serial = new MessageMap(false, "", false);
+  MessageMap* parallel = new MessageMap(false, "", false);
+  vector<string> splitFiles;
+  for (size_t index = 0; index < SPLIT_FILES; index++) {
+    splitFiles.push_back("test_message_split" + std::to_string(index) + ".csv");
+    std::ofstream splitOut(splitFiles[index].c_str(),
+        std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    splitOut << "#\n" << splitContents[index];
+    splitOut.close();
+  }
+  map<string, CachedFileRows> splitRows;
+  bool splitOk = FileSplitter::splitFiles("", splitFiles, SPLIT_FILES, &splitRows) == SPLIT_FILES
+    && splitRows.size() == SPLIT_FILES;
+  for (size_t index = 0; splitOk && index < SPLIT_FILES; index++) {
+    istringstream stream(string("#\n") + splitContents[index]);
+    splitOk = serial->readFromStream(&stream, splitFiles[index], 0, false, nullptr, &errorDescription) == RESULT_OK;
+    parallel->setCachedRows(&splitRows[splitFiles[index]]);
+    splitOk = splitOk
+      && parallel->readFromStream(nullptr, splitFiles[index], 0, false, nullptr, &errorDescription) == RESULT_OK;
+  }
+  for (const auto& name : splitFiles) {
+    remove(name.c_str());
+  }
+  if (splitOk) {
+    splitOk = serial->resolveConditions(false, &errorDescription) == RESULT_OK
+      && parallel->resolveConditions(false, &errorDescription) == RESULT_OK;
+  }
+  ostringstream serialDump, parallelDump;
+  if (splitOk) {
+    serial->dump(true, &serialDump);
+    parallel->dump(true, &parallelDump);
+  }
+  if (splitOk && serial->size() == 6 && parallel->size() == serial->size()
+      && parallelDump.str() == serialDump.str()) {
+    cout << "parallel split OK" << endl;
+  } else {
+    cout << "parallel split error: " << errorDescription << ", got >" << parallelDump.str() << "<, expected >"
+        << serialDump.str() << "<" << endl;
+    error = true;
+  }
+  delete parallel;
+  delete serial;
+
   delete templates;
   delete messages;
   for (vector<MasterSymbolString*>::iterator it = mstrs.begin(); it != mstrs.end(); it++) {
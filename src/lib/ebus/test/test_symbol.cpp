@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <string>
@@ -119,6 +120,73 @@ int main(int argc, char** argv) {
     verify(false, "data size", "0427a90015a901", sstr.getDataSize() == 4, expectStr, gotStr);
   }
 
+  string longHex = "28";
+  for (int i = 0; i < 40; i++) {
+    longHex += "a5";
+  }
+  SlaveSymbolString longStr, copyStr;
+  result = longStr.parseHex(longHex);  // exceeds the inline storage
+  copyStr.parseHex("0100");
+  copyStr = longStr;
+  verify(false, "heap storage", longHex, result == RESULT_OK && longStr.size() == 41
+      && copyStr == longStr && copyStr.compareTo(longStr) == 0 && copyStr.getDataSize() == 40, longHex,
+      copyStr.getStr());
+  copyStr = sstr;
+  copyStr.dataAt(5) = 0x12;
+  verify(false, "inline storage", "0427a915aa", copyStr != sstr && copyStr.compareTo(sstr) == 1,
+      "0427a915aa0012", copyStr.getStr());
+
+  // compare the whole buffer CRC with the CRC updated symbol by symbol on pseudo random traffic
+  vector<symbol_t> traffic(1024*1024);
+  uint32_t seed = 12345;
+  for (auto& value : traffic) {
+    seed = seed*1103515245+12345;
+    value = static_cast<symbol_t>(seed >> 16);
+  }
+  bool crcMatch = true;
+  for (size_t length = 0; length < 64 && crcMatch; length++) {
+    for (int escape = 0; escape < 2 && crcMatch; escape++) {
+      symbol_t expectCrc = 0x5a;
+      for (size_t pos = 0; pos < length; pos++) {
+        symbol_t value = traffic[pos];
+        if (escape && (value == ESC || value == SYN)) {
+          SymbolString::updateCrc(ESC, &expectCrc);
+          SymbolString::updateCrc(value == ESC ? 0x00 : 0x01, &expectCrc);
+        } else {
+          SymbolString::updateCrc(value, &expectCrc);
+        }
+      }
+      crcMatch = SymbolString::updateCrc(traffic.data(), length, escape == 1, 0x5a) == expectCrc;
+    }
+  }
+  if (crcMatch) {
+    cout << "CRC of buffer OK" << endl;
+  } else {
+    cout << "CRC of buffer error" << endl;
+    error = true;
+  }
+  const int rounds = 16;
+  symbol_t crc = 0;
+  auto start = chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    crc = SymbolString::updateCrc(traffic.data(), traffic.size(), false, crc);
+  }
+  auto stop = chrono::steady_clock::now();
+  symbol_t expectCrc = 0;
+  for (int round = 0; round < rounds; round++) {
+    for (auto value : traffic) {
+      SymbolString::updateCrc(value, &expectCrc);
+    }
+  }
+  auto stopSingle = chrono::steady_clock::now();
+  double bufferMs = chrono::duration<double, milli>(stop - start).count();
+  double singleMs = chrono::duration<double, milli>(stopSingle - stop).count();
+  cout << "CRC throughput " << (crc == expectCrc ? "OK" : "error") << ": " << fixed << setprecision(2)
+       << bufferMs/rounds << " ms per MB with buffer, " << singleMs/rounds << " ms per MB per symbol" << endl;
+  if (crc != expectCrc) {
+    error = true;
+  }
+
   int masterCnt = 0, slaveCnt = 0;
   for (int i=0; i<256; i++) {
     symbol_t address = static_cast<symbol_t>(i);
@@ -16,9 +16,19 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
 #include "lib/utils/httpclient.h"
+#ifdef HAVE_ZLIB
+#  include <zlib.h>
+#endif
+#include <strings.h>
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
+#include <ctime>
 #include <sstream>
 
 namespace ebusd {
@@ -28,6 +38,9 @@ using std::ostringstream;
 using std::dec;
 using std::hex;
 
+/** the maximum size of a response body (also after decompression). */
+#define MAX_BODY_SIZE (16 * 1024 * 1024)
+
 bool HttpClient::parseUrl(const string& url, string* proto, string* host, uint16_t* port, string* uri) {
   size_t hostPos = url.find("://");
   if (hostPos == string::npos) {
@@ -71,15 +84,12 @@ bool HttpClient::parseUrl(const string& url, string* proto, string* host, uint16
 
 bool HttpClient::connect(const string& host, const uint16_t port, const string& userAgent, const int timeout) {
   disconnect();
-  m_socket = m_client.connect(host, port, timeout);
-  if (!m_socket) {
-    return false;
-  }
   m_host = host;
   m_port = port;
   m_timeout = timeout;
   m_userAgent = userAgent;
-  return true;
+  m_socket = m_client.connect(host, port, timeout);
+  return m_socket != nullptr;
 }
 
 bool HttpClient::reconnect() {
@@ -106,6 +116,8 @@ void HttpClient::disconnect() {
     delete m_socket;
     m_socket = nullptr;
   }
+  m_responses = 0;
+  m_bufferPos = m_bufferEnd = 0;
 }
 
 bool HttpClient::get(const string& uri, const string& body, string* response, time_t* time) {
@@ -116,6 +128,114 @@ bool HttpClient::post(const string& uri, const string& body, string* response) {
   return request("POST", uri, body, response);
 }
 
+/** the abbreviated day names for formatting an HTTP date. */
+static const char* dayNames[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+
+/** the abbreviated month names for formatting an HTTP date. */
+static const char* monthNames[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+/**
+ * Build the conditional request headers.
+ * @param etag the entity tag of the previously retrieved content, or empty.
+ * @param time the modification time of the previously retrieved content, or 0.
+ * @return the request headers (each terminated by CR LF).
+ */
+static string buildConditionalHeaders(const string& etag, time_t time) {
+  string headers;
+  if (!etag.empty()) {
+    headers = "If-None-Match: " + etag + "\r\n";
+  }
+  struct tm t;
+  if (time > 0 && gmtime_r(&time, &t)) {
+    // If-Modified-Since: Wed, 21 Oct 2015 07:28:00 GMT
+    char date[64];
+    snprintf(date, sizeof(date), "If-Modified-Since: %s, %02d %s %04d %02d:%02d:%02d GMT\r\n", dayNames[t.tm_wday],
+        t.tm_mday, monthNames[t.tm_mon], t.tm_year + 1900, t.tm_hour, t.tm_min, t.tm_sec);
+    headers += date;
+  }
+  return headers;
+}
+
+bool HttpClient::getIfModified(const string& uri, string* etag, time_t* time, string* response, bool* modified) {
+  vector<conditionalGet_t> requests(1);
+  conditionalGet_t& get = requests[0];
+  get.uri = uri;
+  get.etag = *etag;
+  get.time = *time;
+  getIfModified(&requests);
+  if (!get.success) {
+    response->swap(get.response);
+    return false;
+  }
+  *modified = get.modified;
+  if (get.modified) {
+    response->swap(get.response);
+    *etag = get.etag;
+    *time = get.time;
+  }
+  return true;
+}
+
+size_t HttpClient::getIfModified(vector<conditionalGet_t>* requests) {
+  size_t count = requests->size(), next = 0, successful = 0;
+  bool retried = false;
+  string output;
+  while (next < count) {
+    bool reused = m_responses > 0;
+    if (!ensureConnected()) {
+      break;
+    }
+    // send all outstanding requests at once and receive the responses in the same order
+    output.clear();
+    for (size_t index = next; index < count; index++) {
+      const conditionalGet_t& get = (*requests)[index];
+      buildRequest("GET", get.uri, buildConditionalHeaders(get.etag, get.time), "", &output);
+    }
+    size_t received = next;
+    if (send(output)) {
+      for (; received < count; received++) {
+        conditionalGet_t& get = (*requests)[received];
+        time_t time = 0;
+        string etag;
+        bool notModified = false, closed = false;
+        get.modified = false;
+        get.success = readResponse(&get.response, &time, &etag, &notModified, &closed);
+        if (!get.success && closed && (reused || received > next)) {
+          break;  // closed by the server in between: re-send outstanding requests
+        }
+        if (get.success) {
+          successful++;
+          get.modified = !notModified;
+          if (!notModified) {
+            get.etag = etag;
+            get.time = time;
+          }
+        }
+        if (!m_socket) {
+          received++;
+          break;  // connection not usable anymore: re-send outstanding requests
+        }
+      }
+    }
+    if (received == next) {
+      if (retried || !reused) {
+        break;
+      }
+      retried = true;  // retry once on a new connection
+      disconnect();
+      continue;
+    }
+    retried = false;
+    next = received;
+  }
+  for (; next < count; next++) {
+    conditionalGet_t& get = (*requests)[next];
+    get.success = false;
+    get.response = m_socket ? "receive error" : "not connected";
+  }
+  return successful;
+}
+
 const int indexToMonth[] = {
   -1, -1,  2, 12, -1, -1,  1, -1,  // 0-7
   -1, -1, -1, -1,  7, -1,  6,  8,  // 8-15
@@ -124,16 +244,45 @@ const int indexToMonth[] = {
 };
 
 bool HttpClient::request(const string& method, const string& uri, const string& body, string* response, time_t* time) {
-  if (!ensureConnected()) {
-    *response = "not connected";
-    return false;
+  string output;
+  buildRequest(method, uri, "", body, &output);
+  for (bool retry = false; ; retry = true) {
+    bool reused = m_responses > 0;
+    if (!ensureConnected()) {
+      *response = "not connected";
+      return false;
+    }
+    if (!send(output)) {
+      if (reused && !retry) {
+        disconnect();
+        continue;  // retry once on a new connection
+      }
+      *response = "send error";
+      return false;
+    }
+    bool closed = false;
+    if (readResponse(response, time, nullptr, nullptr, &closed)) {
+      return true;
+    }
+    if (!closed || !reused || retry) {
+      return false;
+    }
+    disconnect();  // closed by the server in the meantime: retry once on a new connection
   }
+}
+
+void HttpClient::buildRequest(const string& method, const string& uri, const string& headers, const string& body,
+    string* output) const {
   ostringstream ostr;
-  ostr << method << " " << uri << " HTTP/1.0\r\n"
+  ostr << method << " " << uri << " HTTP/1.1\r\n"
        << "Host: " << m_host << "\r\n";
   if (!m_userAgent.empty()) {
     ostr << "User-Agent: " << m_userAgent << "\r\n";
   }
+#ifdef HAVE_ZLIB
+  ostr << "Accept-Encoding: gzip\r\n";
+#endif
+  ostr << headers;
   if (body.empty()) {
     ostr << "\r\n";
   } else {
@@ -142,121 +291,358 @@ bool HttpClient::request(const string& method, const string& uri, const string&
          << "\r\n"
          << body;
   }
-  string str = ostr.str();
-  size_t len = str.size();
-  const char* cstr = str.c_str();
+  *output += ostr.str();
+}
+
+bool HttpClient::send(const string& data) {
+  size_t len = data.size();
+  const char* cstr = data.c_str();
   for (size_t pos = 0; pos < len; ) {
     ssize_t sent = m_socket->send(cstr + pos, len - pos);
     if (sent < 0) {
       disconnect();
-      *response = "send error";
       return false;
     }
     pos += sent;
   }
-  string result;
-  size_t pos = readUntil(" ", 4 * 1024, &result);  // max 4k headers
-  if (pos == string::npos || pos > 8 || result.substr(0, 5) != "HTTP/") {
-    disconnect();
-    *response = "receive error (headers)";
+  return true;
+}
+
+/**
+ * Find a response header.
+ * @param headers the response headers (each starting with CR LF).
+ * @param name the header name including the trailing colon.
+ * @param value the string in which to store the header value.
+ * @return true when the header was found, false otherwise.
+ */
+static bool findHeader(const string& headers, const char* name, string* value) {
+  size_t nameLen = strlen(name);
+  for (size_t pos = headers.find("\r\n"); pos != string::npos; pos = headers.find("\r\n", pos)) {
+    pos += 2;
+    if (strncasecmp(headers.c_str() + pos, name, nameLen) != 0) {
+      continue;
+    }
+    pos = headers.find_first_not_of(" \t", pos + nameLen);
+    size_t end = pos == string::npos ? pos : headers.find("\r\n", pos);
+    *value = pos == string::npos ? "" : headers.substr(pos, end == string::npos ? end : end - pos);
+    return true;
+  }
+  return false;
+}
+
+#ifdef HAVE_ZLIB
+/**
+ * Decompress gzip encoded content.
+ * @param content the gzip encoded content to decompress in place.
+ * @param maxLength the maximum length of the decompressed content.
+ * @return true on success, false on error or when the decompressed content exceeds @a maxLength.
+ */
+static bool gunzip(string* content, size_t maxLength) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {  // gzip header only
     return false;
   }
-  if (result.substr(pos+1, 6) != "200 OK") {
-    disconnect();
-    size_t endpos = result.find("\r\n", pos+1);
-    *response = "receive error: " + result.substr(pos+1, endpos == string::npos ? endpos : endpos-pos-1);
+  string result;
+  size_t size = content->size() * 4 + 1024;
+  result.resize(size > maxLength ? maxLength + 1 : size);
+  stream.next_in = reinterpret_cast<Bytef*>(&(*content)[0]);
+  stream.avail_in = static_cast<uInt>(content->size());
+  int ret;
+  do {
+    if (stream.total_out >= result.size()) {
+      if (result.size() > maxLength) {
+        break;
+      }
+      result.resize(result.size() > maxLength / 2 ? maxLength + 1 : result.size() * 2);
+    }
+    stream.next_out = reinterpret_cast<Bytef*>(&result[stream.total_out]);
+    stream.avail_out = static_cast<uInt>(result.size() - stream.total_out);
+    ret = inflate(&stream, Z_NO_FLUSH);
+  } while (ret == Z_OK);
+  result.resize(stream.total_out);
+  inflateEnd(&stream);
+  if (ret != Z_STREAM_END || result.size() > maxLength) {
     return false;
   }
-  pos = readUntil("\r\n\r\n", 4 * 1024, &result);  // max 4k headers
-  if (pos == string::npos) {
+  content->swap(result);
+  return true;
+}
+#endif
+
+bool HttpClient::readResponse(string* response, time_t* time, string* etag, bool* notModified, bool* closed) {
+  string status;
+  *closed = m_bufferPos == m_bufferEnd && !receive();
+  if (*closed || !readUntil("\r\n", 4 * 1024, &status) || status.substr(0, 5) != "HTTP/") {  // max 4k status line
     disconnect();
     *response = "receive error (headers)";
     return false;
   }
-  string headers = result.substr(0, pos+2);  // including final \r\n
-  const char* hdrs = headers.c_str();
-  *response = result.substr(pos+4);
-  if (time) {
-    pos = headers.find("\r\nLast-Modified: ");
-    if (pos != string::npos && headers.substr(pos+42, 4) == " GMT") {
-      // Last-Modified: Wed, 21 Oct 2015 07:28:00 GMT
-      struct tm t;
-      pos += strlen("\r\nLast-Modified: ") + 5;
+  size_t pos = status.find(' ');
+  string code = pos == string::npos ? "" : status.substr(pos+1, 3);
+  // collect the headers, each starting with \r\n
+  string responseHeaders, line;
+  do {
+    if (responseHeaders.length() > 4 * 1024 || !readUntil("\r\n", 4 * 1024, &line)) {  // max 4k headers
+      disconnect();
+      *response = "receive error (headers)";
+      return false;
+    }
+    if (!line.empty()) {
+      responseHeaders += "\r\n" + line;
+    }
+  } while (!line.empty());
+  responseHeaders += "\r\n";
+  string value;
+  bool keepAlive = status.substr(0, 9) == "HTTP/1.1 ";
+  if (findHeader(responseHeaders, "Connection:", &value)) {
+    keepAlive = strcasecmp(value.c_str(), "keep-alive") == 0 || (keepAlive && strcasecmp(value.c_str(), "close") != 0);
+  }
+  if (code == "304" || code == "204" || code[0] == '1') {
+    // no body
+    if (code[0] == '1' || code == "204" || !notModified) {
+      if (!keepAlive) {
+        disconnect();
+      }
+      *response = "receive error: " + status.substr(pos+1);
+      return false;
+    }
+    if (!keepAlive) {
+      disconnect();
+    } else {
+      m_responses++;
+    }
+    *notModified = true;
+    return true;
+  }
+  // read the complete body in order to keep the connection usable even on error
+  string body;
+  bool chunked = findHeader(responseHeaders, "Transfer-Encoding:", &value)
+                 && strcasecmp(value.c_str(), "identity") != 0;
+  if (chunked) {
+    if (strcasecmp(value.c_str(), "chunked") != 0) {
+      disconnect();
+      *response = "unsupported transfer encoding " + value;
+      return false;
+    }
+    while (true) {
       char* strEnd = nullptr;
-      t.tm_mday = static_cast<int>(strtol(hdrs + pos, &strEnd, 10));
-      if (strEnd != hdrs + pos + 2 || t.tm_mday < 1 || t.tm_mday > 31) {
-        t.tm_mday = -1;
+      unsigned long length = 0;
+      if (readUntil("\r\n", 1024, &line)) {
+        length = strtoul(line.c_str(), &strEnd, 16);
       }
-      t.tm_mon = indexToMonth[((hdrs[pos+4]&0x10)>>1) | (hdrs[pos+5]&0x17)] - 1;
-      strEnd = nullptr;
-      t.tm_year = static_cast<int>(strtol(hdrs + pos + 7, &strEnd, 10));
-      if (strEnd != hdrs + pos + 11 || t.tm_year < 1970 || t.tm_year >= 3000) {
-        t.tm_year = -1;
-      } else {
-        t.tm_year -= 1900;
+      if (strEnd == nullptr || strEnd == line.c_str() || (*strEnd != '\0' && *strEnd != ';' && *strEnd != ' ')) {
+        disconnect();
+        *response = "invalid chunk size";
+        return false;
       }
-      strEnd = nullptr;
-      t.tm_hour = static_cast<int>(strtol(hdrs + pos + 12, &strEnd, 10));
-      if (strEnd != hdrs + pos + 14 || t.tm_hour > 23) {
-        t.tm_hour = -1;
+      if (length == 0) {
+        break;
       }
-      strEnd = nullptr;
-      t.tm_min = static_cast<int>(strtol(hdrs + pos + 15, &strEnd, 10));
-      if (strEnd != hdrs + pos + 17 || t.tm_min > 59) {
-        t.tm_min = -1;
+      if (length > MAX_BODY_SIZE - body.size()) {
+        disconnect();
+        *response = "body too large";
+        return false;
       }
-      strEnd = nullptr;
-      t.tm_sec = static_cast<int>(strtol(hdrs + pos + 18, &strEnd, 10));
-      if (strEnd != hdrs + pos + 20 || t.tm_sec > 59) {
-        t.tm_sec = -1;
+      if (!read(length, &body) || !readUntil("\r\n", 2, &line) || !line.empty()) {
+        disconnect();
+        *response = "receive error (chunk)";
+        return false;
       }
-      if (t.tm_mday > 0 && t.tm_mon >= 0 && t.tm_year >= 0 && t.tm_hour >= 0 && t.tm_min >=0 && t.tm_sec >= 0) {
-        *time = timegm(&t);
+    }
+    do {  // skip the trailer
+      if (!readUntil("\r\n", 4 * 1024, &line)) {
+        disconnect();
+        *response = "receive error (trailer)";
+        return false;
       }
+    } while (!line.empty());
+  } else if (findHeader(responseHeaders, "Content-Length:", &value)) {
+    char* strEnd = nullptr;
+    unsigned long length = strtoul(value.c_str(), &strEnd, 10);
+    if (strEnd == nullptr || strEnd == value.c_str() || *strEnd != '\0') {
+      disconnect();
+      *response = "invalid content length ";
+      return false;
+    }
+    if (length > MAX_BODY_SIZE) {
+      disconnect();
+      *response = "body too large";
+      return false;
+    }
+    if (!read(length, &body)) {
+      disconnect();
+      *response = "receive error (body)";
+      return false;
+    }
+  } else {
+    keepAlive = false;
+    if (!readToEnd(MAX_BODY_SIZE, &body)) {
+      disconnect();
+      *response = "receive error (body)";
+      return false;
     }
   }
-  pos = headers.find("\r\nContent-Length: ");
-  if (pos == string::npos) {
+  if (!keepAlive) {
     disconnect();
-    return true;
+  } else {
+    m_responses++;
   }
-  char* strEnd = nullptr;
-  unsigned long length = strtoul(hdrs + pos + strlen("\r\nContent-Length: "), &strEnd, 10);
-  if (strEnd == nullptr || *strEnd != '\r') {
-    disconnect();
-    *response = "invalid content length ";
+  if (code != "200") {
+    *response = "receive error: " + status.substr(pos+1);
     return false;
   }
-  pos = readUntil("", length, response);
-  disconnect();
-  return pos == length;
+  if (findHeader(responseHeaders, "Content-Encoding:", &value) && strcasecmp(value.c_str(), "identity") != 0) {
+#ifdef HAVE_ZLIB
+    if (strcasecmp(value.c_str(), "gzip") != 0 || !gunzip(&body, MAX_BODY_SIZE)) {
+#endif
+      *response = "unsupported content encoding " + value;
+      return false;
+#ifdef HAVE_ZLIB
+    }
+#endif
+  }
+  response->swap(body);
+  if (etag) {
+    if (!findHeader(responseHeaders, "ETag:", etag)) {
+      etag->clear();
+    }
+  }
+  if (time && findHeader(responseHeaders, "Last-Modified:", &value) && value.length() >= 29
+      && value.compare(25, 4, " GMT") == 0) {
+    // Last-Modified: Wed, 21 Oct 2015 07:28:00 GMT
+    const char* hdrs = value.c_str();
+    struct tm t;
+    pos = 5;
+    char* strEnd = nullptr;
+    t.tm_mday = static_cast<int>(strtol(hdrs + pos, &strEnd, 10));
+    if (strEnd != hdrs + pos + 2 || t.tm_mday < 1 || t.tm_mday > 31) {
+      t.tm_mday = -1;
+    }
+    t.tm_mon = indexToMonth[((hdrs[pos+4]&0x10)>>1) | (hdrs[pos+5]&0x17)] - 1;
+    strEnd = nullptr;
+    t.tm_year = static_cast<int>(strtol(hdrs + pos + 7, &strEnd, 10));
+    if (strEnd != hdrs + pos + 11 || t.tm_year < 1970 || t.tm_year >= 3000) {
+      t.tm_year = -1;
+    } else {
+      t.tm_year -= 1900;
+    }
+    strEnd = nullptr;
+    t.tm_hour = static_cast<int>(strtol(hdrs + pos + 12, &strEnd, 10));
+    if (strEnd != hdrs + pos + 14 || t.tm_hour > 23) {
+      t.tm_hour = -1;
+    }
+    strEnd = nullptr;
+    t.tm_min = static_cast<int>(strtol(hdrs + pos + 15, &strEnd, 10));
+    if (strEnd != hdrs + pos + 17 || t.tm_min > 59) {
+      t.tm_min = -1;
+    }
+    strEnd = nullptr;
+    t.tm_sec = static_cast<int>(strtol(hdrs + pos + 18, &strEnd, 10));
+    if (strEnd != hdrs + pos + 20 || t.tm_sec > 59) {
+      t.tm_sec = -1;
+    }
+    if (t.tm_mday > 0 && t.tm_mon >= 0 && t.tm_year >= 0 && t.tm_hour >= 0 && t.tm_min >=0 && t.tm_sec >= 0) {
+      *time = timegm(&t);
+    }
+  }
+  return true;
 }
 
-size_t HttpClient::readUntil(const string& delim, const size_t length, string* result) {
-  if (!m_buffer) {
-    m_buffer = reinterpret_cast<char*>(malloc(1024));
-    if (!m_buffer) {
-      return string::npos;
-    }
-    m_bufferSize = 1024;
-  }
-  bool findDelim = !delim.empty();
-  size_t pos = findDelim ? result->find(delim) : string::npos;
-  while (pos == string::npos && result->length() < length) {
-    ssize_t received = m_socket->recv(m_buffer, m_bufferSize);
-    if (received < 0) {
-      return string::npos;
-    }
-    if (received == 0) {
-      break;
+/** the initial size of the receive buffer. */
+#define RECEIVE_BUFFER_SIZE 4096
+
+bool HttpClient::receive() {
+  if (!m_socket) {
+    return false;
+  }
+  if (m_bufferPos > 0) {
+    // move the unconsumed data to the front
+    if (m_bufferEnd > m_bufferPos) {
+      memmove(m_buffer, m_buffer + m_bufferPos, m_bufferEnd - m_bufferPos);
     }
-    size_t oldLength = result->length();
-    *result += string(m_buffer, 0, static_cast<unsigned>(received));
-    if (findDelim) {
-      pos = result->find(delim, oldLength - (delim.length() - 1));
+    m_bufferEnd -= m_bufferPos;
+    m_bufferPos = 0;
+  }
+  if (m_bufferEnd >= m_bufferSize) {
+    size_t size = m_bufferSize ? m_bufferSize * 2 : RECEIVE_BUFFER_SIZE;
+    char* buffer = reinterpret_cast<char*>(realloc(m_buffer, size));
+    if (!buffer) {
+      return false;
     }
+    m_buffer = buffer;
+    m_bufferSize = size;
+  }
+  ssize_t received = m_socket->recv(m_buffer + m_bufferEnd, m_bufferSize - m_bufferEnd);
+  if (received <= 0) {
+    return false;
   }
-  return findDelim ? pos : result->length();
+  m_bufferEnd += static_cast<size_t>(received);
+  return true;
+}
+
+bool HttpClient::readUntil(const char* delim, const size_t maxLength, string* result) {
+  size_t delimLen = strlen(delim);
+  size_t checked = 0;  // number of bytes already checked for the delimiter
+  while (true) {
+    const char* start = m_buffer + m_bufferPos;
+    size_t available = m_bufferEnd - m_bufferPos;
+    if (available >= delimLen) {
+      const char* found = reinterpret_cast<const char*>(memmem(start + checked, available - checked, delim, delimLen));
+      if (found) {
+        size_t length = static_cast<size_t>(found - start);
+        if (length > maxLength) {
+          return false;
+        }
+        result->assign(start, length);
+        m_bufferPos += length + delimLen;
+        return true;
+      }
+      checked = available - delimLen + 1;
+    }
+    if (available > maxLength + delimLen || !receive()) {
+      return false;
+    }
+  }
+}
+
+bool HttpClient::read(size_t length, string* result) {
+  size_t available = m_bufferEnd - m_bufferPos;
+  if (available >= length) {
+    result->append(m_buffer + m_bufferPos, length);
+    m_bufferPos += length;
+    return true;
+  }
+  // take the buffered data and receive the rest directly into the result
+  size_t offset = result->size();
+  result->resize(offset + length);
+  if (available) {
+    memcpy(&(*result)[offset], m_buffer + m_bufferPos, available);
+    offset += available;
+    length -= available;
+  }
+  m_bufferPos = m_bufferEnd = 0;
+  while (length > 0) {
+    ssize_t received = m_socket->recv(&(*result)[offset], length);
+    if (received <= 0) {
+      result->resize(offset);
+      return false;
+    }
+    offset += static_cast<size_t>(received);
+    length -= static_cast<size_t>(received);
+  }
+  return true;
+}
+
+bool HttpClient::readToEnd(size_t maxLength, string* result) {
+  do {
+    result->append(m_buffer + m_bufferPos, m_bufferEnd - m_bufferPos);
+    m_bufferPos = m_bufferEnd;
+    if (result->size() > maxLength) {
+      return false;
+    }
+  } while (receive());
+  return true;
 }
 
 }  // namespace ebusd
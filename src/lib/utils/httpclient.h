@@ -21,7 +21,9 @@
 
 #include <unistd.h>
 #include <cstdint>
+#include <ctime>
 #include <string>
+#include <vector>
 #include "lib/utils/tcpsocket.h"
 
 
@@ -34,6 +36,17 @@ namespace ebusd {
 
 using std::string;
 using std::ifstream;
+using std::vector;
+
+/** A single conditional GET request for being pipelined with @a HttpClient::getIfModified(). */
+typedef struct conditionalGet {
+  string uri;  //!< the URI string.
+  string etag;  //!< the entity tag of the previously retrieved content, or empty (updated with the new entity tag).
+  time_t time;  //!< the modification time of the previously retrieved content, or 0 (updated with the new one).
+  string response;  //!< the response body from the server (or the error), unchanged if not modified.
+  bool modified;  //!< set to whether the content was modified and @a response was set.
+  bool success;  //!< set to whether the request was successful.
+} conditionalGet_t;
 
 /**
  * Helper class for handling HTTP client requests.
@@ -43,7 +56,8 @@ class HttpClient {
   /**
    * Constructor.
    */
-  HttpClient() : m_port(0), m_timeout(0), m_socket(nullptr), m_bufferSize(0), m_buffer(nullptr) {}
+  HttpClient() : m_port(0), m_timeout(0), m_socket(nullptr), m_responses(0), m_bufferSize(0), m_bufferPos(0),
+    m_bufferEnd(0), m_buffer(nullptr) {}
 
   /**
    * Destructor.
@@ -78,7 +92,7 @@ class HttpClient {
   bool connect(const string& host, uint16_t port, const string& userAgent = "", int timeout = 5);
 
   /**
-   * Re-connect to the last specified server.
+   * Re-connect to the last specified server (even if the initial connect failed).
    * @return true on success, false on connect failure.
    */
   bool reconnect();
@@ -104,6 +118,26 @@ class HttpClient {
    */
   bool get(const string& uri, const string& body, string* response, time_t* time = nullptr);
 
+  /**
+   * Execute a conditional GET request only retrieving the content if it was modified.
+   * @param uri the URI string.
+   * @param etag the entity tag of the previously retrieved content, or empty (updated with the new entity tag).
+   * @param time the modification time of the previously retrieved content, or 0 (updated with the new modification
+   * time).
+   * @param response the response body from the server (or the HTTP header on error), unchanged if not modified.
+   * @param modified pointer to a bool for storing whether the content was modified and @a response was set.
+   * @return true on success, false on error.
+   */
+  bool getIfModified(const string& uri, string* etag, time_t* time, string* response, bool* modified);
+
+  /**
+   * Execute several conditional GET requests pipelined on the same connection (re-sending the outstanding ones on a
+   * new connection if the server closes the connection in between).
+   * @param requests the @a conditionalGet_t requests to execute (updated with the results).
+   * @return the number of successful requests.
+   */
+  size_t getIfModified(vector<conditionalGet_t>* requests);
+
   /**
    * Execute a POST request.
    * @param uri the URI string.
@@ -126,22 +160,75 @@ class HttpClient {
 
  private:
   /**
-   * Read from the connected socket until the specified delimiter is found or the specified number of bytes was received.
-   * @param delim the delimiter to find, or empty for reading the specified number of bytes.
-   * @param length the maximum number of bytes to receive.
-   * @param result the string to append the read data to and in which to find the delimiter.
-   * @return the position of the delimiter if delimiter was set or the number of bytes received, or string::npos if not found.
+   * Build a request.
+   * @param method the method string.
+   * @param uri the URI string.
+   * @param headers the additional request headers (each terminated by CR LF), or empty.
+   * @param body the optional body to send.
+   * @param output the string to append the request to.
    */
-  size_t readUntil(const string& delim, const size_t length, string* result);
+  void buildRequest(const string& method, const string& uri, const string& headers, const string& body,
+      string* output) const;
+
+  /**
+   * Send data to the connected socket.
+   * @param data the data to send.
+   * @return true on success, false on error.
+   */
+  bool send(const string& data);
+
+  /**
+   * Read a response from the connected socket including the complete body.
+   * @param response the response body from the server (or the error description).
+   * @param time optional pointer to a @a time_t value for storing the modification time of the file, or nullptr.
+   * @param etag optional pointer to a string for storing the entity tag of the file, or nullptr.
+   * @param notModified optional pointer to a bool for storing whether the server answered with "304 Not Modified"
+   * (which is regarded as error if nullptr).
+   * @param closed pointer to a bool for storing whether the connection was closed before anything was received.
+   * @return true on success, false on error or when the body exceeds the maximum size (and the connection is no
+   * longer usable when @a m_socket was cleared).
+   */
+  bool readResponse(string* response, time_t* time, string* etag, bool* notModified, bool* closed);
+
+  /**
+   * Receive more data from the connected socket into the receive buffer.
+   * @return true when more data was received, false on error or when the connection was closed.
+   */
+  bool receive();
+
+  /**
+   * Read from the receive buffer until the specified delimiter is found.
+   * @param delim the delimiter to find.
+   * @param maxLength the maximum number of bytes to read.
+   * @param result the string in which to store the read data (without the delimiter).
+   * @return true on success, false when the delimiter was not found.
+   */
+  bool readUntil(const char* delim, size_t maxLength, string* result);
+
+  /**
+   * Read the specified number of bytes from the receive buffer.
+   * @param length the number of bytes to read.
+   * @param result the string to append the read data to.
+   * @return true on success, false when not all bytes were received.
+   */
+  bool read(size_t length, string* result);
+
+  /**
+   * Read from the receive buffer until the connection is closed.
+   * @param maxLength the maximum length of @a result.
+   * @param result the string to append the read data to.
+   * @return true on success, false on error or when @a result exceeds @a maxLength.
+   */
+  bool readToEnd(size_t maxLength, string* result);
 
  private:
   /** the @a TCPClient handling the traffic. */
   TCPClient m_client;
 
-  /** the name of the host last successfully connected to. */
+  /** the name of the host last connected to (also kept for a later @a reconnect() if unsuccessful). */
   string m_host;
 
-  /** the port last successfully connected to. */
+  /** the port last connected to. */
   uint16_t m_port;
 
   /** the timeout in seconds. */
@@ -153,10 +240,19 @@ class HttpClient {
   /** the currently connected socket. */
   TCPSocket* m_socket;
 
+  /** the number of responses received on the current connection. */
+  unsigned int m_responses;
+
   /** the size of the @a m_buffer. */
   size_t m_bufferSize;
 
-  /** the buffer for preparing/receiving data. */
+  /** the position of the first received but not yet consumed byte in @a m_buffer. */
+  size_t m_bufferPos;
+
+  /** the position after the last received byte in @a m_buffer. */
+  size_t m_bufferEnd;
+
+  /** the buffer for receiving data (kept across responses on the same connection). */
   char* m_buffer;
 };
 
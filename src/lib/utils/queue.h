@@ -21,6 +21,7 @@
 
 #include <pthread.h>
 #include <errno.h>
+#include <atomic>
 #include <list>
 #include "lib/utils/clock.h"
 
@@ -163,6 +164,79 @@ class Queue {
   pthread_cond_t m_cond;
 };
 
+
+/**
+ * Lock free template class for queuing items from a single producer thread to a single consumer thread.
+ * The items are kept in place so that the storage of previously queued items gets reused.
+ * @param T the item type.
+ * @param N the capacity plus one.
+ */
+template <typename T, size_t N>
+class RingQueue {
+ public:
+  /**
+   * Constructor.
+   */
+  RingQueue() : m_head(0), m_tail(0) {}
+
+
+ private:
+  /**
+   * Hidden copy constructor.
+   * @param src the object to copy from.
+   */
+  RingQueue(const RingQueue& src);
+
+
+ public:
+  /**
+   * Add a copy of the item to the end of queue (producer thread only).
+   * @param item the item to add.
+   * @return true when the item was added, false if the queue is full.
+   */
+  bool push(const T& item) {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t next = (tail+1) % N;
+    if (next == m_head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    m_items[tail] = item;
+    m_tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Return the first item in the queue without removing it (consumer thread only).
+   * @return the item, or nullptr if no item is available.
+   */
+  T* front() {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &m_items[head];
+  }
+
+  /**
+   * Remove the first item from the queue after it was retrieved via @a front() (consumer thread only).
+   */
+  void pop() {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    m_head.store((head+1) % N, std::memory_order_release);
+  }
+
+
+ private:
+  /** the queued items. */
+  T m_items[N];
+
+  /** the index of the first item (only modified by the consumer). */
+  std::atomic<size_t> m_head;
+
+  /** the index after the last item (only modified by the producer). */
+  std::atomic<size_t> m_tail;
+};
+
 }  // namespace ebusd
 
 #endif  // LIB_UTILS_QUEUE_H_
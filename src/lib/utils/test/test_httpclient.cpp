@@ -0,0 +1,275 @@
+/*
+ * ebusd - daemon for communication with eBUS heating systems.
+ * Copyright (C) 2014-2021 John Baier <ebusd@ebusd.eu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <cstring>
+#ifdef HAVE_ZLIB
+#  include <zlib.h>
+#endif
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "lib/utils/httpclient.h"
+#include "lib/utils/thread.h"
+
+using namespace std;
+using namespace ebusd;
+
+static bool error = false;
+
+void verify(bool ok, const string& name, const string& got = "") {
+  if (ok) {
+    cout << name << " OK" << endl;
+  } else {
+    cout << name << " error" << (got.empty() ? "" : ": got >" + got + "<") << endl;
+    error = true;
+  }
+}
+
+/**
+ * A local stand-in for an HTTP server sending canned responses in the order the requests are received.
+ */
+class StandInServer : public Thread {
+ public:
+  /**
+   * Constructor.
+   */
+  StandInServer() : Thread(), m_server(0, "127.0.0.1"), m_port(0) {}
+
+  /**
+   * Start listening on an ephemeral port and serving in a separate thread.
+   * @return true on success.
+   */
+  bool listen() {
+    if (m_server.start() != 0) {
+      return false;
+    }
+    struct sockaddr_in address;
+    socklen_t len = sizeof(address);
+    if (getsockname(m_server.getFD(), reinterpret_cast<struct sockaddr*>(&address), &len) != 0) {
+      return false;
+    }
+    m_port = ntohs(address.sin_port);
+    return start("standin");
+  }
+
+  // @copydoc
+  void stop() override {
+    Thread::stop();
+    shutdown(m_server.getFD(), SHUT_RDWR);  // wake up the blocking accept
+  }
+
+  /**
+   * Add a canned response to be sent for the next request.
+   * @param data the raw response data, or empty to send nothing.
+   * @param close whether to close the connection after sending it.
+   */
+  void add(const string& data, bool close = false) {
+    m_mutex.lock();
+    m_responses.push_back(pair<string, bool>(data, close));
+    m_mutex.unlock();
+  }
+
+  /**
+   * Get the raw request headers received so far.
+   * @return the raw request headers in the order received.
+   */
+  vector<string> getRequests() {
+    m_mutex.lock();
+    vector<string> requests = m_requests;
+    m_mutex.unlock();
+    return requests;
+  }
+
+  /** the port the server is listening on. */
+  uint16_t getPort() const { return m_port; }
+
+
+ protected:
+  // @copydoc
+  void run() override {
+    TCPSocket* socket;
+    while (isRunning() && (socket = m_server.newSocket()) != nullptr) {
+      string received;
+      char buffer[1024];
+      bool open = true;
+      while (open) {
+        ssize_t len = socket->recv(buffer, sizeof(buffer));
+        if (len <= 0) {
+          break;
+        }
+        received.append(buffer, static_cast<size_t>(len));
+        size_t end;
+        while (open && (end = received.find("\r\n\r\n")) != string::npos) {
+          m_mutex.lock();
+          m_requests.push_back(received.substr(0, end + 4));
+          received.erase(0, end + 4);
+          if (m_responses.empty()) {
+            open = false;
+          } else {
+            const string data = m_responses.front().first;
+            open = !m_responses.front().second;
+            m_responses.pop_front();
+            if (!data.empty()) {
+              socket->send(data.data(), data.size());
+            }
+          }
+          m_mutex.unlock();
+        }
+      }
+      delete socket;
+    }
+  }
+
+
+ private:
+  /** the @a TCPServer for accepting connections. */
+  TCPServer m_server;
+
+  /** the port the server is listening on. */
+  uint16_t m_port;
+
+  /** the @a Mutex for accessing @a m_responses and @a m_requests. */
+  Mutex m_mutex;
+
+  /** the canned responses with whether to close the connection afterwards. */
+  deque<pair<string, bool>> m_responses;
+
+  /** the raw request headers received so far. */
+  vector<string> m_requests;
+};
+
+#ifdef HAVE_ZLIB
+/**
+ * Compress content with gzip.
+ * @param content the content to compress.
+ * @return the gzip encoded content.
+ */
+string gzip(const string& content) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return "";
+  }
+  string result;
+  result.resize(deflateBound(&stream, static_cast<uLong>(content.size())));
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(content.data()));
+  stream.avail_in = static_cast<uInt>(content.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+  stream.avail_out = static_cast<uInt>(result.size());
+  int ret = deflate(&stream, Z_FINISH);
+  result.resize(stream.total_out);
+  deflateEnd(&stream);
+  return ret == Z_STREAM_END ? result : "";
+}
+#endif
+
+int main() {
+  StandInServer server;
+  if (!server.listen()) {
+    verify(false, "listen");
+    return 1;
+  }
+  HttpClient client;
+  verify(client.connect("127.0.0.1", server.getPort(), "", 2), "connect");
+
+  // retrieve the content first, then revalidate it with the received entity tag
+  server.add("HTTP/1.1 200 OK\r\nETag: \"abc\"\r\nLast-Modified: Wed, 21 Oct 2015 07:28:00 GMT\r\n"
+      "Content-Length: 5\r\n\r\nfirst");
+  server.add("HTTP/1.1 304 Not Modified\r\nETag: \"abc\"\r\n\r\n");
+  string etag, response;
+  time_t time = 0;
+  bool modified = false;
+  bool ok = client.getIfModified("/file.csv", &etag, &time, &response, &modified);
+  verify(ok && modified && response == "first" && etag == "\"abc\"" && time == 1445412480, "initial get", response);
+  response = "kept";
+  ok = client.getIfModified("/file.csv", &etag, &time, &response, &modified);
+  vector<string> requests = server.getRequests();
+  verify(ok && !modified && response == "kept" && etag == "\"abc\"" && time == 1445412480
+      && requests.size() == 2 && requests[1].find("\r\nIf-None-Match: \"abc\"\r\n") != string::npos
+      && requests[1].find("\r\nIf-Modified-Since: Wed, 21 Oct 2015 07:28:00 GMT\r\n") != string::npos,
+      "not modified", response);
+
+  // chunks with extensions followed by a trailer
+  server.add("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+      "4;name=value\r\nchun\r\n3 ; name\r\nked\r\n0\r\nX-Checksum: 1234\r\nX-Other: 5\r\n\r\n");
+  ok = client.get("/chunked", "", &response);
+  verify(ok && response == "chunked", "chunked", response);
+
+  // a pair of responses sent at once for the pipelined requests
+  server.add("HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\none"
+      "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n3\r\ntwo\r\n0\r\n\r\n");
+  server.add("");
+  vector<conditionalGet_t> gets(2);
+  gets[0].uri = "/one";
+  gets[0].time = 0;
+  gets[1].uri = "/two";
+  gets[1].time = 0;
+  size_t successful = client.getIfModified(&gets);
+  verify(successful == 2 && gets[0].modified && gets[0].response == "one" && gets[1].modified
+      && gets[1].response == "two", "pipelined", gets[0].response + "," + gets[1].response);
+
+#ifdef HAVE_ZLIB
+  string compressed = gzip("compressed content");
+  server.add("HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nContent-Length: " + to_string(compressed.size())
+      + "\r\n\r\n" + compressed);
+  ok = client.get("/gzip", "", &response);
+  verify(ok && response == "compressed content", "gzip", response);
+
+  // decompressing to more than the maximum body size
+  compressed = gzip(string(17 * 1024 * 1024, '0'));
+  server.add("HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nContent-Length: " + to_string(compressed.size())
+      + "\r\n\r\n" + compressed);
+  ok = client.get("/gzipbomb", "", &response);
+  verify(!ok && response.size() < 1024, "gzip too large", response.substr(0, 100));
+#endif
+
+  // the connection closed before the complete body was sent
+  server.add("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nfour", true);
+  ok = client.get("/truncated", "", &response);
+  verify(!ok && response == "receive error (body)", "truncated", response);
+
+  server.add("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n4\r\nchun", true);
+  ok = client.get("/truncatedchunk", "", &response);
+  verify(!ok && response == "receive error (chunk)", "truncated chunk", response);
+
+  // exceeding the maximum body size
+  server.add("HTTP/1.1 200 OK\r\nContent-Length: 100000000\r\n\r\nlarge", true);
+  ok = client.get("/large", "", &response);
+  verify(!ok && response == "body too large", "content length too large", response);
+
+  server.add("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n1000001\r\n", true);
+  ok = client.get("/largechunk", "", &response);
+  verify(!ok && response == "body too large", "chunk too large", response);
+
+  server.add("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n1000\r\n" + string(0x1000, '0')
+      + "\r\nfffff0\r\n", true);
+  ok = client.get("/largechunks", "", &response);
+  verify(!ok && response == "body too large", "chunks too large", response.substr(0, 100));
+
+  client.disconnect();
+  server.stop();
+  server.join();
+  return error ? 1 : 0;
+}
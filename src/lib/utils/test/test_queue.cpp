@@ -0,0 +1,100 @@
+/*
+ * ebusd - daemon for communication with eBUS heating systems.
+ * Copyright (C) 2014-2021 John Baier <ebusd@ebusd.eu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <iostream>
+#include "lib/utils/queue.h"
+
+using namespace std;
+using namespace ebusd;
+
+static bool error = false;
+
+void verify(bool ok, const string& name) {
+  if (ok) {
+    cout << name << " OK" << endl;
+  } else {
+    cout << name << " error" << endl;
+    error = true;
+  }
+}
+
+/** the number of items passed between the threads. */
+#define THREAD_ITEMS 100000
+
+/** the queue shared between the threads. */
+static RingQueue<int, 8> s_shared;
+
+void* produce(void* arg) {
+  for (int value = 0; value < THREAD_ITEMS; ) {
+    if (s_shared.push(value)) {
+      value++;
+    } else {
+      sched_yield();
+    }
+  }
+  return nullptr;
+}
+
+int main() {
+  RingQueue<int, 4> queue;  // capacity 3
+  verify(queue.front() == nullptr, "empty");
+
+  bool ok = queue.push(1) && queue.push(2) && queue.push(3);
+  verify(ok && !queue.push(4), "full");
+
+  ok = queue.front() && *queue.front() == 1;
+  queue.pop();
+  ok = ok && queue.push(4) && !queue.push(5);
+  verify(ok, "push after pop");
+
+  // run the indices around the end of the storage several times
+  int expect = 2, next = 5;
+  for (int round = 0; ok && round < 10; round++) {
+    int* item = queue.front();
+    ok = item && *item == expect++;
+    queue.pop();
+    ok = ok && queue.push(next++);
+  }
+  verify(ok, "wraparound");
+
+  while (ok && queue.front()) {
+    ok = *queue.front() == expect++;
+    queue.pop();
+  }
+  verify(ok && expect == next && queue.front() == nullptr, "drain");
+
+  pthread_t producer;
+  ok = pthread_create(&producer, nullptr, produce, nullptr) == 0;
+  for (int received = 0; ok && received < THREAD_ITEMS; ) {
+    int* item = s_shared.front();
+    if (!item) {
+      sched_yield();
+      continue;
+    }
+    ok = ok && *item == received++;
+    s_shared.pop();
+  }
+  if (ok) {
+    pthread_join(producer, nullptr);
+  }
+  verify(ok && s_shared.front() == nullptr, "threads");
+
+  return error ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * ebusd - daemon for communication with eBUS heating systems.
+ * Copyright (C) 2014-2021 John Baier <ebusd@ebusd.eu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include <atomic>
+#include <iostream>
+#include "lib/utils/thread.h"
+
+using namespace std;
+using namespace ebusd;
+
+static bool error = false;
+
+void verify(bool ok, const string& name) {
+  if (ok) {
+    cout << name << " OK" << endl;
+  } else {
+    cout << name << " error" << endl;
+    error = true;
+  }
+}
+
+/** the lock shared between the threads. */
+static SharedMutex s_shared;
+
+/** the number of threads that acquired the exclusive lock. */
+static std::atomic<int> s_written(0);
+
+void* exclusive(void* arg) {
+  s_shared.lock();
+  s_written++;
+  s_shared.unlock();
+  return nullptr;
+}
+
+void* upgrade(void* arg) {
+  s_shared.lockShared();
+  usleep(100000);  // let the other reader acquire the shared lock as well
+  s_shared.lock();
+  s_written++;
+  s_shared.unlock();
+  s_shared.unlockShared();
+  return nullptr;
+}
+
+int main() {
+  alarm(10);  // a deadlock terminates the test
+
+  s_shared.lock();
+  s_shared.lock();
+  s_shared.lockShared();
+  s_shared.unlockShared();
+  s_shared.unlock();
+  s_shared.unlock();
+  verify(true, "recursive");
+
+  // a nested shared lock must not wait for the writer queued in the meantime
+  s_shared.lockShared();
+  pthread_t writer;
+  bool ok = pthread_create(&writer, nullptr, exclusive, nullptr) == 0;
+  usleep(100000);  // let the writer wait for the lock
+  s_shared.lockShared();
+  ok = ok && s_written == 0;
+  s_shared.unlockShared();
+  s_shared.unlockShared();
+  if (ok) {
+    pthread_join(writer, nullptr);
+  }
+  verify(ok && s_written == 1, "nested shared");
+
+  // two readers acquiring the exclusive lock at the same time
+  s_written = 0;
+  pthread_t upgrader;
+  ok = pthread_create(&upgrader, nullptr, upgrade, nullptr) == 0;
+  if (ok) {
+    upgrade(nullptr);
+    pthread_join(upgrader, nullptr);
+  }
+  verify(ok && s_written == 2, "upgrade");
+
+  // the shared lock is held again after the upgrade
+  s_shared.lockShared();
+  s_shared.lock();
+  s_shared.unlock();
+  ok = pthread_create(&writer, nullptr, exclusive, nullptr) == 0;
+  usleep(100000);
+  ok = ok && s_written == 2;
+  s_shared.unlockShared();
+  if (ok) {
+    pthread_join(writer, nullptr);
+  }
+  verify(ok && s_written == 3, "shared after upgrade");
+
+  return error ? 1 : 0;
+}
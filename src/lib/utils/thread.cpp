@@ -21,6 +21,8 @@
 #endif
 
 #include "lib/utils/thread.h"
+#include <utility>
+#include <vector>
 #include "lib/utils/clock.h"
 
 namespace ebusd {
@@ -120,9 +122,9 @@ bool NotifiableThread::waitNotified(int millis) {
   if (!m_notified) {
     struct timespec t;
     clockGettime(&t);
-    t.tv_sec += millis / 1000000000;
-    t.tv_nsec += (millis % 1000000000) * 1000000;
-    if (t.tv_nsec > 1000000000) {
+    t.tv_sec += millis / 1000;
+    t.tv_nsec += (millis % 1000) * 1000000;
+    if (t.tv_nsec >= 1000000000) {
       t.tv_sec++;
       t.tv_nsec -= 1000000000;
     }
@@ -134,4 +136,86 @@ bool NotifiableThread::waitNotified(int millis) {
   return notified;
 }
 
+
+/** the shared lock depth of the calling thread by @a SharedMutex (only while held). */
+static thread_local std::vector<std::pair<const SharedMutex*, int>> s_readerDepths;
+
+int SharedMutex::getReaderDepth() const {
+  for (const auto& it : s_readerDepths) {
+    if (it.first == this) {
+      return it.second;
+    }
+  }
+  return 0;
+}
+
+void SharedMutex::setReaderDepth(int depth) const {
+  for (auto it = s_readerDepths.begin(); it != s_readerDepths.end(); it++) {
+    if (it->first == this) {
+      if (depth > 0) {
+        it->second = depth;
+      } else {
+        s_readerDepths.erase(it);
+      }
+      return;
+    }
+  }
+  if (depth > 0) {
+    s_readerDepths.push_back(std::pair<const SharedMutex*, int>(this, depth));
+  }
+}
+
+void SharedMutex::lock() {
+  if (isWriter()) {
+    m_writerDepth++;
+    return;
+  }
+  int readerDepth = getReaderDepth();
+  if (readerDepth > 0) {
+    setReaderDepth(0);
+    pthread_rwlock_unlock(&m_lock);  // give up the shared lock as it can't be upgraded atomically
+  }
+  pthread_rwlock_wrlock(&m_lock);
+  m_writer = pthread_self();
+  m_writerDepth = 1;
+  m_upgradedDepth = readerDepth;
+}
+
+void SharedMutex::unlock() {
+  if (--m_writerDepth > 0) {
+    return;
+  }
+  int readerDepth = m_upgradedDepth;
+  m_upgradedDepth = 0;
+  pthread_rwlock_unlock(&m_lock);
+  if (readerDepth > 0) {
+    pthread_rwlock_rdlock(&m_lock);  // back to the shared lock given up in lock()
+    setReaderDepth(readerDepth);
+  }
+}
+
+void SharedMutex::lockShared() {
+  if (isWriter()) {
+    m_writerDepth++;
+    return;
+  }
+  int readerDepth = getReaderDepth();
+  if (readerDepth == 0) {
+    pthread_rwlock_rdlock(&m_lock);
+  }
+  setReaderDepth(readerDepth + 1);
+}
+
+void SharedMutex::unlockShared() {
+  if (isWriter()) {
+    unlock();
+    return;
+  }
+  int readerDepth = getReaderDepth() - 1;
+  setReaderDepth(readerDepth);
+  if (readerDepth == 0) {
+    pthread_rwlock_unlock(&m_lock);
+  }
+}
+
 }  // namespace ebusd
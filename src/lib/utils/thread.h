@@ -20,6 +20,7 @@
 #define LIB_UTILS_THREAD_H_
 
 #include <pthread.h>
+#include <atomic>
 
 namespace ebusd {
 
@@ -214,6 +215,90 @@ class Mutex {
   pthread_mutex_t m_mutex;
 };
 
+
+/**
+ * A reader/writer lock allowing shared access for multiple readers or exclusive access for a single writer.
+ * Both locks may be acquired recursively, and the writer may also acquire the shared lock. The shared lock depth is
+ * tracked per thread, so that a nested shared lock never waits for a writer queued in the meantime.
+ * A reader acquiring the exclusive lock gives up its shared lock while waiting for it (and gets it back after
+ * releasing the exclusive lock), as an atomic upgrade would deadlock with another upgrading reader. Instances looked
+ * up under the shared lock before therefore might have been replaced in the meantime.
+ */
+class SharedMutex {
+ public:
+  /**
+   * Constructor.
+   */
+  SharedMutex() : m_writer(pthread_t()), m_writerDepth(0), m_upgradedDepth(0) {
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    pthread_rwlock_init(&m_lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+  }
+
+  /**
+   * Destructor.
+   */
+  virtual ~SharedMutex() {
+    pthread_rwlock_destroy(&m_lock);
+  }
+
+  /**
+   * Acquire the exclusive lock.
+   */
+  void lock();
+
+  /**
+   * Release the exclusive lock.
+   */
+  void unlock();
+
+  /**
+   * Acquire the shared lock.
+   */
+  void lockShared();
+
+  /**
+   * Release the shared lock.
+   */
+  void unlockShared();
+
+
+ private:
+  /**
+   * Return whether the calling thread holds the exclusive lock.
+   * @return true when the calling thread holds the exclusive lock.
+   */
+  bool isWriter() const { return m_writerDepth > 0 && pthread_equal(m_writer, pthread_self()); }
+
+  /**
+   * Get the number of times the calling thread acquired the shared lock.
+   * @return the number of times the calling thread acquired the shared lock.
+   */
+  int getReaderDepth() const;
+
+  /**
+   * Set the number of times the calling thread acquired the shared lock.
+   * @param depth the number of times the calling thread acquired the shared lock.
+   */
+  void setReaderDepth(int depth) const;
+
+  /** the reader/writer lock. */
+  pthread_rwlock_t m_lock;
+
+  /** the thread holding the exclusive lock (only valid while @a m_writerDepth is positive). */
+  std::atomic<pthread_t> m_writer;
+
+  /** the number of times the exclusive lock was acquired by the writer. */
+  std::atomic<int> m_writerDepth;
+
+  /** the shared lock depth given up by the writer for acquiring the exclusive lock (only accessed by the writer). */
+  int m_upgradedDepth;
+};
+
 }  // namespace ebusd
 
 #endif  // LIB_UTILS_THREAD_H_